@@ -182,5 +182,6 @@ static int aac_decode(void *ctx, phi_track *t)
 
 const phi_filter phi_aac_dec = {
 	aac_open, (void*)aac_close, (void*)aac_decode,
-	"aac-decode"
+	"aac-decode",
+	PHI_FILTER_OWN_OUTPUT
 };
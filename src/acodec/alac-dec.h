@@ -77,5 +77,6 @@ static int alac_in_decode(void *ctx, phi_track *t)
 
 const phi_filter phi_alac_dec = {
 	alac_open, alac_close, alac_in_decode,
-	"alac-decode"
+	"alac-decode",
+	PHI_FILTER_OWN_OUTPUT
 };
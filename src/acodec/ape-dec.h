@@ -111,5 +111,6 @@ static int ape_dec_decode(void *ctx, phi_track *t)
 
 static const phi_filter phi_ape_dec = {
 	ape_dec_create, ape_dec_free, ape_dec_decode,
-	"ape-decode"
+	"ape-decode",
+	PHI_FILTER_OWN_OUTPUT
 };
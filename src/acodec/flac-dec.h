@@ -148,5 +148,6 @@ static int flac_dec_decode(void *ctx, phi_track *t)
 
 const phi_filter phi_flac_dec = {
 	flac_dec_create, flac_dec_free, flac_dec_decode,
-	"flac-decode"
+	"flac-decode",
+	PHI_FILTER_OWN_OUTPUT
 };
@@ -0,0 +1,480 @@
+/** phiola: FLAC: parallel encoding
+2026, Simon Zolin */
+
+/*
+The input PCM is split into chunks of FLPE_CHUNK_FRAMES frames.
+Each chunk is encoded by a separate libFLAC instance on another worker,
+ the frames are passed to the next filter in order as they become ready.
+Track thread:
+ (input) -> [convert to int32, MD5] -> chunk -> task(encode) ...
+                                                     |
+ (output) <- frames <- chunk (done)  <- task(done) <--
+Each encoder numbers its frames from 0,
+ so the frame number in the header (and CRC of the header and the frame) is rewritten.
+MD5 of the whole stream is computed here: libFLAC instances don't see all input data.
+The chunk memory is freed by the track's worker only:
+ if the track is closed while the chunk is being encoded, the chunk is freed after the task is complete.
+*/
+
+#include <util/md5.h>
+
+static int pcm_to32(int **dst, const void **src, uint srcbits, uint channels, uint samples);
+
+enum {
+	FLPE_CHUNK_FRAMES = 64,
+	FLPE_MD5_SAMPLES = 4096,
+};
+
+enum FLPE_CHUNK_STATE {
+	FLPE_FILL,
+	FLPE_BUSY,
+	FLPE_DONE,
+};
+
+struct flpe_frame {
+	uint off, size;
+	uint samples;
+};
+
+struct flpe_chunk {
+	phi_task task_enc, task_done;
+	struct flac_penc *pe;
+	uint worker;
+	uint state; // enum FLPE_CHUNK_STATE
+	int error; // libFLAC error code
+	uint bad_frame :1;
+	uint64 frame_first; // number of the first frame in the stream
+	uint samples;
+	int *pcm32[FLAC__MAX_CHANNELS];
+	ffvec pcm; // int[channels][chunk_samples]
+	ffvec data; // encoded frames
+	ffvec frames; // struct flpe_frame[]
+	uint iframe; // frames sent
+};
+
+struct flac_penc {
+	phi_track *trk; // NULL: the track is closed
+	uint worker; // the track's worker
+	flac_conf conf;
+	uint blocksize;
+	uint chunk_samples;
+	uint busy, max_busy; // chunks being encoded
+	uint waiting :1;
+	uint64 nchunks;
+	ffvec chunks; // struct flpe_chunk*[]: in stream order
+
+	const void **pcm;
+	ffsize pcmlen;
+	uint off_pcm; // samples
+	struct md5 md5;
+	ffvec md5buf;
+	uint minframe, maxframe;
+};
+
+static ushort flpe_crc16_tbl[256];
+
+static void flpe_crc16_init()
+{
+	if (flpe_crc16_tbl[1])
+		return;
+	for (uint i = 0;  i < 256;  i++) {
+		uint c = i << 8;
+		for (uint k = 0;  k < 8;  k++) {
+			c = (c & 0x8000) ? (c << 1) ^ 0x8005 : c << 1;
+		}
+		flpe_crc16_tbl[i] = (ushort)c;
+	}
+}
+
+static uint flpe_crc16(const u_char *d, ffsize n)
+{
+	uint c = 0;
+	for (ffsize i = 0;  i < n;  i++) {
+		c = ((c << 8) ^ flpe_crc16_tbl[(c >> 8) ^ d[i]]) & 0xffff;
+	}
+	return c;
+}
+
+static uint flpe_crc8(const u_char *d, ffsize n)
+{
+	uint c = 0;
+	for (ffsize i = 0;  i < n;  i++) {
+		c ^= d[i];
+		for (uint k = 0;  k < 8;  k++) {
+			c = (c & 0x80) ? ((c << 1) ^ 0x07) & 0xff : (c << 1) & 0xff;
+		}
+	}
+	return c;
+}
+
+/** Write frame number in FLAC's UTF-8-like coding (up to 36 bits).
+Return the number of bytes written */
+static uint flpe_utf8_write(u_char *d, uint64 v)
+{
+	if (v < 0x80) {
+		d[0] = (u_char)v;
+		return 1;
+	}
+
+	uint n = 2;
+	while (n < 7 && v >= (1ULL << (5 * n + 1))) {
+		n++;
+	}
+	for (uint i = n - 1;  i != 0;  i--) {
+		d[i] = 0x80 | (v & 0x3f);
+		v >>= 6;
+	}
+	d[0] = (u_char)(0xff00 >> n) | (u_char)v;
+	return n;
+}
+
+/** Copy the frame with the new frame number; update CRC of the header and the frame.
+dst: must have space for 'len + 6' bytes
+Return the new frame size;  0: unsupported frame */
+static uint flpe_frame_renumber(u_char *dst, const u_char *src, uint len, uint64 num)
+{
+	if (len < 8 || src[0] != 0xff || src[1] != 0xf8) // fixed block size
+		return 0;
+
+	uint nlen = 1;
+	if (src[4] & 0x80) {
+		nlen = 0;
+		for (u_char b = src[4];  b & 0x80;  b <<= 1) {
+			nlen++;
+		}
+		if (nlen < 2 || nlen > 7)
+			return 0;
+	}
+
+	uint hdr = 4 + nlen;
+	uint bs_code = src[2] >> 4, sr_code = src[2] & 0x0f;
+	if (bs_code == 6)
+		hdr += 1;
+	else if (bs_code == 7)
+		hdr += 2;
+	if (sr_code == 12)
+		hdr += 1;
+	else if (sr_code == 13 || sr_code == 14)
+		hdr += 2;
+	if (hdr + 1 + 2 > len)
+		return 0;
+
+	ffmem_copy(dst, src, 4);
+	uint i = 4 + flpe_utf8_write(dst + 4, num);
+	ffmem_copy(dst + i, src + 4 + nlen, hdr - (4 + nlen));
+	i += hdr - (4 + nlen);
+	dst[i] = flpe_crc8(dst, i);
+	i++;
+
+	uint body = len - (hdr + 1) - 2;
+	ffmem_copy(dst + i, src + hdr + 1, body);
+	i += body;
+	uint crc = flpe_crc16(dst, i);
+	dst[i] = (u_char)(crc >> 8);
+	dst[i + 1] = (u_char)crc;
+	return i + 2;
+}
+
+static int flpe_frame_add(struct flpe_chunk *ch, const char *data, uint len, uint samples)
+{
+	uint64 num = ch->frame_first + ch->frames.len;
+	struct flpe_frame *fr = ffvec_pushT(&ch->frames, struct flpe_frame);
+	fr->off = ch->data.len;
+	fr->samples = samples;
+
+	ffvec_growtwice(&ch->data, len + 6, 1);
+	u_char *d = (u_char*)ch->data.ptr + ch->data.len;
+	if (ch->frame_first == 0) {
+		ffmem_copy(d, data, len);
+		fr->size = len;
+	} else if (0 == (fr->size = flpe_frame_renumber(d, (u_char*)data, len, num))) {
+		return -1;
+	}
+	ch->data.len += fr->size;
+	return 0;
+}
+
+/** Encode all samples of the chunk.  Called within an encoder worker. */
+static int flpe_chunk_encode(struct flpe_chunk *ch)
+{
+	flac_conf conf = ch->pe->conf;
+	flac_encoder *enc;
+	int r;
+	if ((r = flac_encode_init(&enc, &conf)))
+		return r;
+
+	const int *pcm[FLAC__MAX_CHANNELS];
+	char *data;
+	uint off = 0, bs = ch->pe->blocksize, block = bs + 1, samples;
+	while (off < ch->samples) {
+		samples = ffmin(ch->samples - off, block);
+		for (uint i = 0;  i < conf.channels;  i++) {
+			pcm[i] = ch->pcm32[i] + off;
+		}
+		if ((r = flac_encode(enc, pcm, &samples, &data)) < 0)
+			goto end;
+		off += samples;
+		block = bs;
+		if (r > 0 && flpe_frame_add(ch, data, r, bs)) {
+			ch->bad_frame = 1;
+			r = 0;
+			goto end;
+		}
+	}
+
+	samples = 0;
+	if ((r = flac_encode(enc, pcm, &samples, &data)) < 0)
+		goto end;
+	if (r > 0 && flpe_frame_add(ch, data, r, samples))
+		ch->bad_frame = 1;
+	r = 0;
+
+end:
+	flac_encode_free(enc);
+	return r;
+}
+
+static void flpe_chunk_free(struct flpe_chunk *ch)
+{
+	ffvec_free(&ch->pcm);
+	ffvec_free(&ch->data);
+	ffvec_free(&ch->frames);
+	ffmem_free(ch);
+}
+
+static void flpe_free(struct flac_penc *pe)
+{
+	ffvec_free(&pe->chunks);
+	ffvec_free(&pe->md5buf);
+	ffmem_free(pe);
+}
+
+/** The chunk is encoded.  Called within the track's worker. */
+static void flpe_encoded(void *param)
+{
+	struct flpe_chunk *ch = param;
+	struct flac_penc *pe = ch->pe;
+	core->worker_release(ch->worker);
+	pe->busy--;
+
+	if (!pe->trk) {
+		flpe_chunk_free(ch);
+		if (pe->busy == 0)
+			flpe_free(pe);
+		return;
+	}
+
+	ch->state = FLPE_DONE;
+	if (pe->waiting) {
+		pe->waiting = 0;
+		core->track->wake(pe->trk);
+	}
+}
+
+static void flpe_encode(void *param)
+{
+	struct flpe_chunk *ch = param;
+	ch->error = flpe_chunk_encode(ch);
+	core->task(ch->pe->worker, &ch->task_done, flpe_encoded, ch);
+}
+
+static struct flac_penc* flpe_create(phi_track *t, const struct flac_info *info)
+{
+	struct flac_penc *pe = ffmem_new(struct flac_penc);
+	if (NULL == ffvec_alloc(&pe->md5buf, FLPE_MD5_SAMPLES * info->bits/8 * info->channels, 1)) {
+		syserrlog(t, "ffvec_alloc");
+		ffmem_free(pe);
+		return NULL;
+	}
+	pe->trk = t;
+	pe->worker = t->worker;
+	pe->conf.bps = info->bits;
+	pe->conf.channels = info->channels;
+	pe->conf.rate = info->sample_rate;
+	pe->conf.level = 6;
+	pe->conf.nomd5 = 1;
+	pe->blocksize = info->minblock;
+	pe->chunk_samples = info->minblock * FLPE_CHUNK_FRAMES;
+	pe->max_busy = core->conf.workers;
+	pe->pcm = (const void**)t->data_in.ptr; // the input data is processed on the next call
+	pe->pcmlen = t->data_in.len;
+	md5_init(&pe->md5);
+	flpe_crc16_init();
+	t->worker_bound++; // the encoded chunks are returned to our worker
+	dbglog(t, "parallel encoding: %u samples per chunk, %u workers"
+		, pe->chunk_samples, pe->max_busy);
+	return pe;
+}
+
+static void flpe_close(struct flac_penc *pe, phi_track *t)
+{
+	if (!pe)
+		return;
+
+	t->worker_bound--;
+	struct flpe_chunk **it;
+	FFSLICE_WALK(&pe->chunks, it) {
+		if ((*it)->state != FLPE_BUSY)
+			flpe_chunk_free(*it);
+	}
+
+	if (pe->busy) {
+		pe->trk = NULL; // the remaining chunks are freed by flpe_encoded()
+		return;
+	}
+	flpe_free(pe);
+}
+
+static struct flpe_chunk* flpe_chunk_new(struct flac_penc *pe)
+{
+	struct flpe_chunk *ch = ffmem_new(struct flpe_chunk);
+	if (NULL == ffvec_alloc(&ch->pcm, (ffsize)pe->chunk_samples * sizeof(int) * pe->conf.channels, 1)) {
+		ffmem_free(ch);
+		return NULL;
+	}
+	ch->pe = pe;
+	ch->frame_first = pe->nchunks * FLPE_CHUNK_FRAMES;
+	pe->nchunks++;
+	for (uint i = 0;  i < pe->conf.channels;  i++) {
+		ch->pcm32[i] = (int*)ch->pcm.ptr + pe->chunk_samples * i;
+	}
+	*ffvec_pushT(&pe->chunks, struct flpe_chunk*) = ch;
+	return ch;
+}
+
+static void flpe_chunk_start(struct flac_penc *pe, struct flpe_chunk *ch)
+{
+	ch->state = FLPE_BUSY;
+	ch->worker = core->worker_assign(1);
+	pe->busy++;
+	core->task(ch->worker, &ch->task_enc, flpe_encode, ch);
+}
+
+/** Update MD5 with the interleaved input samples */
+static void flpe_md5(struct flac_penc *pe, const void **src, uint off, uint samples)
+{
+	uint ss = pe->conf.bps / 8, nch = pe->conf.channels;
+	while (samples) {
+		uint n = ffmin(samples, FLPE_MD5_SAMPLES);
+		char *d = pe->md5buf.ptr;
+		for (uint i = 0;  i < n;  i++) {
+			for (uint c = 0;  c < nch;  c++) {
+				const char *s = (char*)src[c] + (off + i) * ss;
+				for (uint k = 0;  k < ss;  k++) {
+					*d++ = s[k];
+				}
+			}
+		}
+		md5_update(&pe->md5, pe->md5buf.ptr, n * ss * nch);
+		off += n;
+		samples -= n;
+	}
+}
+
+/** Copy input samples to the chunk being filled */
+static void flpe_fill(struct flac_penc *pe, struct flpe_chunk *ch, uint samples)
+{
+	const void* src[FLAC__MAX_CHANNELS];
+	int* dst[FLAC__MAX_CHANNELS];
+	for (uint i = 0;  i < pe->conf.channels;  i++) {
+		src[i] = (char*)pe->pcm[i] + pe->off_pcm * pe->conf.bps/8;
+		dst[i] = ch->pcm32[i] + ch->samples;
+	}
+	int r = pcm_to32(dst, src, pe->conf.bps, pe->conf.channels, samples);
+	FF_ASSERT(!r);
+	(void)r;
+	flpe_md5(pe, src, 0, samples);
+	pe->off_pcm += samples;
+	ch->samples += samples;
+}
+
+/** Get stream info after all frames are written */
+static void flpe_info(struct flac_penc *pe, struct flac_info *info)
+{
+	info->minframe = pe->minframe;
+	info->maxframe = pe->maxframe;
+	md5_fin(&pe->md5, (u_char*)info->md5);
+}
+
+/**
+Return enum PHI_R */
+static int flpe_process(struct flac_penc *pe, phi_track *t, struct flac_info *info)
+{
+	if (t->chain_flags & PHI_FFWD) {
+		pe->pcm = (const void**)t->data_in.ptr;
+		pe->pcmlen = t->data_in.len;
+		pe->off_pcm = 0;
+	}
+
+	uint sample_size = pe->conf.bps/8 * pe->conf.channels;
+	for (;;) {
+		struct flpe_chunk *ch = (pe->chunks.len) ? *(struct flpe_chunk**)pe->chunks.ptr : NULL;
+		if (ch && ch->state == FLPE_DONE) {
+			if (ch->error) {
+				errlog(t, "flac_encode(): %s", flac_errstr(ch->error));
+				return PHI_ERR;
+			} else if (ch->bad_frame) {
+				errlog(t, "frame #%U: unsupported frame header", ch->frame_first + ch->frames.len - 1);
+				return PHI_ERR;
+			}
+
+			if (ch->iframe < ch->frames.len) {
+				const struct flpe_frame *fr = ffslice_itemT(&ch->frames, ch->iframe, struct flpe_frame);
+				ch->iframe++;
+				if (pe->minframe == 0 || fr->size < pe->minframe)
+					pe->minframe = fr->size;
+				pe->maxframe = ffmax(pe->maxframe, fr->size);
+				t->oaudio.flac_frame_samples = fr->samples;
+				ffstr_set(&t->data_out, ch->data.ptr + fr->off, fr->size);
+				return PHI_DATA;
+			}
+
+			ffslice_rm((ffslice*)&pe->chunks, 0, 1, sizeof(struct flpe_chunk*));
+			flpe_chunk_free(ch);
+			continue;
+		}
+
+		struct flpe_chunk *fill = NULL;
+		if (pe->chunks.len) {
+			fill = ((struct flpe_chunk**)pe->chunks.ptr)[pe->chunks.len - 1];
+			if (fill->state != FLPE_FILL)
+				fill = NULL;
+		}
+
+		uint n = pe->pcmlen / sample_size - pe->off_pcm;
+		if (n) {
+			if (!fill) {
+				if (pe->busy == pe->max_busy) {
+					pe->waiting = 1;
+					return PHI_ASYNC;
+				}
+				if (!(fill = flpe_chunk_new(pe))) {
+					syserrlog(t, "ffvec_alloc");
+					return PHI_ERR;
+				}
+			}
+
+			n = ffmin(n, pe->chunk_samples - fill->samples);
+			flpe_fill(pe, fill, n);
+			if (fill->samples == pe->chunk_samples)
+				flpe_chunk_start(pe, fill);
+			continue;
+		}
+
+		if (!(t->chain_flags & PHI_FFIRST))
+			return PHI_MORE;
+
+		if (fill) {
+			flpe_chunk_start(pe, fill);
+			continue;
+		}
+
+		if (ch) {
+			pe->waiting = 1;
+			return PHI_ASYNC;
+		}
+
+		flpe_info(pe, info);
+		return PHI_DONE;
+	}
+}
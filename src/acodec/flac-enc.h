@@ -3,6 +3,7 @@
 
 #include <avpack/base/flac.h>
 #include <FLAC/FLAC-phi.h>
+#include <acodec/flac-enc-parallel.h>
 
 struct flac_enc {
 	uint state;
@@ -13,6 +14,7 @@ struct flac_enc {
 	int* pcm32[FLAC__MAX_CHANNELS];
 	uint cap_pcm32, off_pcm, off_pcm32;
 	ffvec obuf;
+	struct flac_penc *pe;
 };
 
 static void* flac_enc_create(phi_track *t)
@@ -28,6 +30,7 @@ static void* flac_enc_create(phi_track *t)
 
 static void flac_enc_free(struct flac_enc *f, phi_track *t)
 {
+	flpe_close(f->pe, t);
 	ffvec_free(&f->obuf);
 	if (f->enc)
 		flac_encode_free(f->enc);
@@ -68,11 +71,23 @@ static int flac_enc_init(struct flac_enc *f, phi_track *t)
 	f->info.minblock = info.min_blocksize;
 	f->info.maxblock = info.max_blocksize;
 
-	ffvec_realloc(&f->obuf, (f->info.minblock + 1) * sizeof(int) * f->info.channels, 1);
-	for (uint i = 0;  i < f->info.channels;  i++) {
-		f->pcm32[i] = (void*)(f->obuf.ptr + (f->info.minblock + 1) * sizeof(int) * i);
+	if (t->conf.flac.parallel && core->conf.workers > 1
+		&& (f->pe = flpe_create(t, &f->info))) {
+		// Each chunk is encoded by its own libFLAC instance:
+		//  the main instance was needed only to get the block size
+		flac_encode_free(f->enc);
+		f->enc = NULL;
+
+	} else {
+		if (NULL == ffvec_realloc(&f->obuf, (f->info.minblock + 1) * sizeof(int) * f->info.channels, 1)) {
+			syserrlog(t, "ffvec_realloc");
+			return PHI_ERR;
+		}
+		for (uint i = 0;  i < f->info.channels;  i++) {
+			f->pcm32[i] = (void*)(f->obuf.ptr + (f->info.minblock + 1) * sizeof(int) * i);
+		}
+		f->cap_pcm32 = f->info.minblock + 1;
 	}
-	f->cap_pcm32 = f->info.minblock + 1;
 
 	t->oaudio.flac_vendor = flac_vendor();
 	t->data_type = PHI_AC_FLAC;
@@ -142,7 +157,7 @@ static int flac_enc_encode(struct flac_enc *f, phi_track *t)
 	int r;
 	uint samples, sample_size, blksize;
 	char *data;
-	enum { I_CONV, I_INIT, I_ENC, I_DONE };
+	enum { I_CONV, I_INIT, I_ENC, I_PARALLEL, I_DONE };
 
 	if (t->chain_flags & PHI_FFWD) {
 		f->pcm = (const void**)t->data_in.ptr;
@@ -169,9 +184,15 @@ static int flac_enc_encode(struct flac_enc *f, phi_track *t)
 		if (flac_enc_init(f, t))
 			return PHI_ERR;
 		ffstr_set(&t->data_out, (void*)&f->info, sizeof(f->info));
-		f->state = I_ENC;
+		f->state = (f->pe) ? I_PARALLEL : I_ENC;
 		return PHI_DATA;
 
+	case I_PARALLEL:
+		r = flpe_process(f->pe, t, &f->info);
+		if (r == PHI_DONE)
+			ffstr_set(&t->data_out, (void*)&f->info, sizeof(f->info));
+		return r;
+
 	case I_DONE: {
 		flac_conf info = {};
 		flac_encode_info(f->enc, &info);
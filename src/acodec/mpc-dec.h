@@ -95,5 +95,6 @@ more:
 
 static const phi_filter phi_mpc_dec = {
 	mpc_dec_open, mpc_dec_close, mpc_dec_process,
-	"mpc-decode"
+	"mpc-decode",
+	PHI_FILTER_OWN_OUTPUT
 };
@@ -89,5 +89,6 @@ end:
 
 const phi_filter phi_mpeg_dec = {
 	mpeg_dec_open, (void*)mpeg_dec_close, (void*)mpeg_dec_process,
-	"mpeg-decode"
+	"mpeg-decode",
+	PHI_FILTER_OWN_OUTPUT
 };
@@ -150,5 +150,6 @@ more:
 
 static const phi_filter phi_opus_dec = {
 	opus_open, opus_close, opus_in_decode,
-	"opus-decode"
+	"opus-decode",
+	PHI_FILTER_OWN_OUTPUT
 };
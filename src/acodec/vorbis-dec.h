@@ -120,5 +120,6 @@ more:
 
 static const phi_filter phi_vorbis_dec = {
 	vorbis_open, vorbis_close, vorbis_in_decode,
-	"vorbis-decode"
+	"vorbis-decode",
+	PHI_FILTER_OWN_OUTPUT
 };
@@ -128,5 +128,6 @@ more:
 
 const phi_filter phi_wavpack_dec = {
 	wvpk_dec_create, wvpk_dec_free, wvpk_dec_decode,
-	"wavpack-decode"
+	"wavpack-decode",
+	PHI_FILTER_OWN_OUTPUT
 };
@@ -10,11 +10,16 @@ const phi_core *core;
 #define errlog(t, ...)  phi_errlog(core, NULL, t, __VA_ARGS__)
 #define warnlog(t, ...)  phi_warnlog(core, NULL, t, __VA_ARGS__)
 #define infolog(t, ...)  phi_infolog(core, NULL, t, __VA_ARGS__)
+#define userlog(t, ...)  phi_userlog(core, NULL, t, __VA_ARGS__)
 #define dbglog(t, ...)  phi_dbglog(core, NULL, t, __VA_ARGS__)
 
 #include <afilter/auto-conv.h>
+#include <afilter/batch.h>
+#include <afilter/equalizer.h>
+#include <afilter/loudness-r128.h>
 #include <afilter/noise-gate.h>
 #include <afilter/silence-gen.h>
+#include <afilter/silence.h>
 #include <afilter/skip.h>
 #include <afilter/until.h>
 #include <afilter/split.h>
@@ -27,19 +32,28 @@ extern const phi_filter
 	phi_gain,
 	phi_noise_gate,
 	phi_peaks,
+	phi_resample,
 	phi_rtpeak;
+extern void phi_resample_free();
 static const void* af_iface(const char *name)
 {
 	static const struct map_sz_vptr mods[] = {
 		{ "auto-conv",	&phi_autoconv },
 		{ "auto-conv-f",&phi_autoconv_f },
 		{ "auto-norm",	&phi_auto_norm },
+		{ "batch",		&phi_pcm_batch },
 		{ "conv",		&phi_aconv },
+		{ "eq",			&phi_eq },
+		{ "eq-live",	&phi_equalizer },
 		{ "gain",		&phi_gain },
+		{ "loudness",	&phi_loudness_r128 },
+		{ "loudness-album",	&phi_loudness_album },
 		{ "noise-gate",	&phi_noise_gate },
 		{ "peaks",		&phi_peaks },
+		{ "resample",	&phi_resample },
 		{ "rg-norm",	&phi_rg_norm },
 		{ "rtpeak",		&phi_rtpeak },
+		{ "silence",	&phi_silence },
 		{ "silence-gen",&phi_sil_gen },
 		{ "skip",		&phi_pcm_skip },
 		{ "split",		&phi_split },
@@ -49,9 +63,17 @@ static const void* af_iface(const char *name)
 	return map_sz_vptr_find(mods, name);
 }
 
+static void af_close()
+{
+	ldr_album_free();
+	eq_live_free();
+	phi_resample_free();
+}
+
 static const phi_mod phi_mod_afilter = {
 	.ver = PHI_VERSION, .ver_core = PHI_VERSION_CORE,
 	.iface = af_iface,
+	.close = af_close,
 };
 
 FF_EXPORT const phi_mod* phi_mod_init(const phi_core *_core)
@@ -3,6 +3,8 @@
 
 #include <track.h>
 #include <util/util.h>
+#include <afilter/limiter.h>
+#include <afilter/pcm-writable.h>
 #include <ffaudio/pcm-gain.h>
 #include <ffbase/args.h>
 
@@ -13,12 +15,16 @@ extern const phi_core *core;
 struct autonorm_conf {
 	int target;
 	int max_gain, max_attenuate;
+	uint lookahead; // limiter lookahead (msec); 0: disable limiter
+	int ceiling; // limiter ceiling (dBFS)
 };
 
 #define O(m)  (void*)(size_t)FF_OFF(struct autonorm_conf, m)
 static const struct ffarg autonorm_conf_args[] = {
 	{ "attenuate",	'd',	O(max_attenuate) },
+	{ "ceiling",	'd',	O(ceiling) },
 	{ "gain",		'd',	O(max_gain) },
+	{ "lookahead",	'u',	O(lookahead) },
 	{ "target",		'd',	O(target) },
 	{}
 };
@@ -28,6 +34,10 @@ struct autonorm {
 	struct pcm_af af;
 	double gain_db, gain;
 	struct autonorm_conf conf;
+	struct limiter lim;
+	uint lim_active :1;
+	ffvec buf; // the final data with the frames from limiter's delay line
+	struct pcm_wbuf wbuf;
 };
 
 static void* anorm_open(phi_track *t)
@@ -38,6 +48,8 @@ static void* anorm_open(phi_track *t)
 		.target = -14,
 		.max_gain = 6,
 		.max_attenuate = -6,
+		.lookahead = 5,
+		.ceiling = -1,
 	};
 	c->conf = conf;
 	struct ffargs a = {};
@@ -46,12 +58,26 @@ static void* anorm_open(phi_track *t)
 		phi_track_free(t, c);
 		return PHI_OPEN_ERR;
 	}
+
+	if (c->conf.lookahead) {
+		if (!(c->af.format == PHI_PCM_FLOAT64 && c->af.interleaved)
+			|| limiter_init(&c->lim, c->af.channels, c->af.rate, c->conf.lookahead, c->conf.ceiling)) {
+			dbglog(t, "limiter: audio format not supported");
+		} else {
+			c->lim_active = 1;
+			dbglog(t, "limiter: lookahead:%u samples  ceiling:%ddB", c->lim.la, c->conf.ceiling);
+		}
+	}
 	return c;
 }
 
 static void anorm_close(void *ctx, phi_track *t)
 {
 	struct autonorm *c = ctx;
+	if (c->lim_active)
+		limiter_close(&c->lim);
+	ffvec_free(&c->buf);
+	pcm_wbuf_free(&c->wbuf, t);
 	phi_track_free(t, c);
 }
 
@@ -59,6 +85,12 @@ static int anorm_process(void *ctx, phi_track *t)
 {
 	struct autonorm *c = ctx;
 
+	if (t->audio.seek_req) {
+		if (c->lim_active)
+			limiter_reset(&c->lim);
+		return PHI_MORE;
+	}
+
 	double db = c->conf.target - t->oaudio.loudness;
 	if (t->oaudio.loudness_momentary - t->oaudio.loudness > 2) {
 		db = c->conf.target - t->oaudio.loudness_momentary;
@@ -77,10 +109,29 @@ static int anorm_process(void *ctx, phi_track *t)
 		dbglog(t, "gain: %.02FdB %.02F", c->gain_db, c->gain);
 	}
 
+	if ((db != 0 || c->lim_active)
+		&& pcm_wbuf_get(&c->wbuf, t, (struct phi_af*)&c->af))
+		return PHI_ERR;
+
 	t->data_out = t->data_in;
 	if (db != 0)
 		pcm_gain(&c->af, c->gain, t->data_out.ptr, t->data_out.ptr, t->data_out.len / pcm_size1(&c->af));
 
+	if (c->lim_active) {
+		uint frame_size = pcm_size1(&c->af);
+		limiter_process(&c->lim, (double*)t->data_out.ptr, t->data_out.len / frame_size);
+
+		if (t->chain_flags & PHI_FFIRST) {
+			// append the delayed frames
+			uint tail = c->lim.la * frame_size;
+			ffvec_grow(&c->buf, t->data_out.len + tail, 1);
+			ffmem_copy(c->buf.ptr, t->data_out.ptr, t->data_out.len);
+			limiter_flush(&c->lim, (double*)((char*)c->buf.ptr + t->data_out.len));
+			c->buf.len = t->data_out.len + tail;
+			ffstr_setstr(&t->data_out, &c->buf);
+		}
+	}
+
 	return (t->chain_flags & PHI_FFIRST) ? PHI_DONE : PHI_OK;
 }
 
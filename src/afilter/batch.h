@@ -0,0 +1,140 @@
+/** phiola: combine small PCM chunks into larger blocks
+2026, Simon Zolin */
+
+/* Decoders with small frames (Opus 20ms, MPEG 1152 samples) return lots of tiny chunks,
+ and the per-call overhead of the filters below becomes noticeable.
+This filter collects the decoded data into ~100ms blocks,
+ so the rest of the chain is executed once per block rather than once per frame. */
+
+#include <track.h>
+#include <afilter/pcm.h>
+
+#define BATCH_MSEC  100
+#define BATCH_CHANNELS_MAX  8
+
+struct pcm_batch {
+	ffstr in;
+	uint in_off; // samples consumed from 'in'
+	uint64 in_pos; // position of the first unconsumed sample in 'in'
+
+	char *buf;
+	void *chan[BATCH_CHANNELS_MAX];
+	uint cap, n; // samples
+	uint64 pos; // position of the first buffered sample
+
+	uint sample_size;
+	uint channels;
+	uint interleaved :1;
+};
+
+static void* pcm_batch_open(phi_track *t)
+{
+	if (t->data_type != PHI_AC_PCM
+		|| t->audio.format.channels > BATCH_CHANNELS_MAX)
+		return PHI_OPEN_SKIP;
+
+	struct pcm_batch *c = phi_track_allocT(t, struct pcm_batch);
+	c->sample_size = phi_af_size(&t->audio.format);
+	c->channels = t->audio.format.channels;
+	c->interleaved = t->audio.format.interleaved;
+	c->cap = pcm_samples(BATCH_MSEC, t->audio.format.rate);
+	c->buf = ffmem_alloc(c->cap * c->sample_size);
+
+	if (!c->interleaved) {
+		ffsize chan_size = c->cap * c->sample_size / c->channels;
+		for (uint i = 0;  i < c->channels;  i++) {
+			c->chan[i] = c->buf + chan_size * i;
+		}
+	}
+	return c;
+}
+
+static void pcm_batch_close(void *ctx, phi_track *t)
+{
+	struct pcm_batch *c = ctx;
+	dbglog(t, "batch size:%u", c->cap);
+	ffmem_free(c->buf);
+	phi_track_free(t, c);
+}
+
+/** Append 'n' samples from input to the buffer */
+static void pcm_batch_copy(struct pcm_batch *c, uint n)
+{
+	if (c->interleaved) {
+		ffmem_copy(c->buf + c->n * c->sample_size, c->in.ptr + c->in_off * c->sample_size, n * c->sample_size);
+
+	} else {
+		uint ss = c->sample_size / c->channels;
+		char **ichan = (char**)c->in.ptr;
+		for (uint i = 0;  i < c->channels;  i++) {
+			ffmem_copy((char*)c->chan[i] + c->n * ss, ichan[i] + c->in_off * ss, n * ss);
+		}
+	}
+
+	c->n += n;
+	c->in_off += n;
+	if (c->in_pos != ~0ULL)
+		c->in_pos += n;
+}
+
+static int pcm_batch_process(void *ctx, phi_track *t)
+{
+	struct pcm_batch *c = ctx;
+
+	if (t->audio.seek_req) {
+		// drop the data from the old position
+		c->n = 0;
+		ffstr_null(&c->in);
+		if (t->chain_flags & PHI_FFIRST)
+			return PHI_DONE;
+		return PHI_MORE;
+	}
+
+	if (t->chain_flags & PHI_FFWD) {
+		c->in = t->data_in;
+		c->in_off = 0;
+		c->in_pos = t->audio.pos;
+	}
+
+	uint in_samples = c->in.len / c->sample_size;
+
+	if (c->n == 0 && c->in_off == 0 && in_samples >= c->cap) {
+		// the chunk is large enough: pass it through without copying
+		t->data_out = c->in;
+		t->audio.pos = c->in_pos;
+		ffstr_null(&c->in);
+		if (t->chain_flags & PHI_FFIRST)
+			return PHI_DONE;
+		return PHI_DATA;
+	}
+
+	if (c->n == 0)
+		c->pos = c->in_pos;
+	pcm_batch_copy(c, ffmin(c->cap - c->n, in_samples - c->in_off));
+
+	if (c->n < c->cap && !(t->chain_flags & PHI_FFIRST))
+		return PHI_MORE;
+
+	ffstr_null(&t->data_out);
+	if (c->n != 0) {
+		if (c->interleaved)
+			ffstr_set(&t->data_out, c->buf, c->n * c->sample_size);
+		else
+			ffstr_set(&t->data_out, c->chan, c->n * c->sample_size);
+		t->audio.pos = c->pos;
+		c->n = 0;
+	}
+
+	if ((t->chain_flags & PHI_FFIRST)
+		&& c->in_off == in_samples)
+		return PHI_DONE;
+	return PHI_DATA;
+}
+
+const phi_filter phi_pcm_batch = {
+	pcm_batch_open, pcm_batch_close, pcm_batch_process,
+	"pcm-batch"
+};
+
+#undef BATCH_MSEC
+#undef BATCH_CHANNELS_MAX
@@ -0,0 +1,257 @@
+/** phiola: multi-band biquad equalizer engine
+2026, Simon Zolin */
+
+/* Input: float32 samples, interleaved or non-interleaved, up to 8 channels.
+Each band is a 2nd order IIR filter (Audio EQ Cookbook by R. Bristow-Johnson): peaking, low-shelf, high-shelf.
+The bands are applied in series; direct form II transposed.
+The samples of all channels of one frame are processed together in a SIMD register,
+ so there's no dependency between the lanes:
+ SSE for up to 4 channels, AVX2 for up to 8 channels.
+The coefficients are calculated only when the bands are set. */
+
+#pragma once
+#include <afilter/pcm-simd.h>
+#include <math.h>
+
+#define BQ_BANDS_MAX  16
+
+enum BQ_TYPE {
+	BQ_PEAK,
+	BQ_LOWSHELF,
+	BQ_HIGHSHELF,
+};
+
+struct bq_band {
+	uint type; // enum BQ_TYPE
+	double freq; // Hz
+	double q; // Q-factor;  shelf: 0: use 'slope'
+	double slope; // shelf slope
+	double gain; // dB
+};
+
+struct bq_eq {
+	uint channels;
+	uint rate;
+	uint n; // number of bands
+	float k[BQ_BANDS_MAX][5][8]; // b0 b1 b2 a1 a2 (normalized by a0), the same value in all lanes
+	float z[BQ_BANDS_MAX][2][8]; // filter state for each lane
+};
+
+static inline void bq_init(struct bq_eq *q, uint channels, uint rate)
+{
+	ffmem_zero_obj(q);
+	q->channels = channels;
+	q->rate = rate;
+}
+
+/** Set the coefficients for the band */
+static inline void _bq_coef(struct bq_eq *q, uint i, const struct bq_band *b)
+{
+	double a = pow(10, b->gain / 40);
+	double w0 = 2 * M_PI * b->freq / q->rate;
+	double cs = cos(w0), sn = sin(w0), alpha;
+	double b0, b1, b2, a0, a1, a2;
+
+	if (b->type == BQ_PEAK) {
+		alpha = sn / (2 * b->q);
+		b0 = 1 + alpha * a;
+		b1 = -2 * cs;
+		b2 = 1 - alpha * a;
+		a0 = 1 + alpha / a;
+		a1 = -2 * cs;
+		a2 = 1 - alpha / a;
+
+	} else {
+		if (b->q != 0)
+			alpha = sn / (2 * b->q);
+		else
+			alpha = sn / 2 * sqrt((a + 1 / a) * (1 / b->slope - 1) + 2);
+		double sa = 2 * sqrt(a) * alpha;
+
+		if (b->type == BQ_LOWSHELF) {
+			b0 = a * ((a + 1) - (a - 1) * cs + sa);
+			b1 = 2 * a * ((a - 1) - (a + 1) * cs);
+			b2 = a * ((a + 1) - (a - 1) * cs - sa);
+			a0 = (a + 1) + (a - 1) * cs + sa;
+			a1 = -2 * ((a - 1) + (a + 1) * cs);
+			a2 = (a + 1) + (a - 1) * cs - sa;
+		} else {
+			b0 = a * ((a + 1) + (a - 1) * cs + sa);
+			b1 = -2 * a * ((a - 1) + (a + 1) * cs);
+			b2 = a * ((a + 1) + (a - 1) * cs - sa);
+			a0 = (a + 1) - (a - 1) * cs + sa;
+			a1 = 2 * ((a - 1) - (a + 1) * cs);
+			a2 = (a + 1) - (a - 1) * cs - sa;
+		}
+	}
+
+	const double k[5] = { b0 / a0, b1 / a0, b2 / a0, a1 / a0, a2 / a0 };
+	for (uint j = 0;  j < 5;  j++) {
+		for (uint l = 0;  l < 8;  l++) {
+			q->k[i][j][l] = k[j];
+		}
+	}
+}
+
+/** Set new bands.
+The state of the existing bands is preserved, so the settings can be changed during playback without a click.
+Return 0 on success */
+static inline int bq_set(struct bq_eq *q, const struct bq_band *bands, uint n)
+{
+	if (n > BQ_BANDS_MAX)
+		return -1;
+	for (uint i = 0;  i < n;  i++) {
+		if (!(bands[i].freq > 0 && bands[i].freq < q->rate / 2))
+			return -1;
+	}
+
+	for (uint i = 0;  i < n;  i++) {
+		_bq_coef(q, i, &bands[i]);
+	}
+	for (uint i = q->n;  i < n;  i++) {
+		ffmem_zero(q->z[i], sizeof(q->z[i]));
+	}
+	q->n = n;
+	return 0;
+}
+
+/** Flush denormal values in filter state: they are very slow to process */
+static inline void _bq_denormal(struct bq_eq *q)
+{
+	for (uint i = 0;  i < q->n;  i++) {
+		for (uint j = 0;  j < 2 * 8;  j++) {
+			float *z = &q->z[i][0][0] + j;
+			if (fabsf(*z) < 1e-15f)
+				*z = 0;
+		}
+	}
+}
+
+static inline void _bq_process_c(struct bq_eq *q, float **ch, uint step, ffsize frames)
+{
+	for (uint c = 0;  c < q->channels;  c++) {
+		float *d = ch[c];
+		for (uint i = 0;  i < q->n;  i++) {
+			float b0 = q->k[i][0][0], b1 = q->k[i][1][0], b2 = q->k[i][2][0], a1 = q->k[i][3][0], a2 = q->k[i][4][0];
+			float z0 = q->z[i][0][c], z1 = q->z[i][1][c];
+			for (ffsize j = 0;  j < frames;  j++) {
+				float x = d[j * step];
+				float y = b0 * x + z0;
+				z0 = b1 * x - a1 * y + z1;
+				z1 = b2 * x - a2 * y;
+				d[j * step] = y;
+			}
+			q->z[i][0][c] = z0;
+			q->z[i][1][c] = z1;
+		}
+	}
+}
+
+#ifdef PCM_SIMD_X86
+
+__attribute__((target("sse")))
+static void _bq_process_sse(struct bq_eq *q, float **ch, uint step, ffsize frames)
+{
+	uint nch = q->channels, n = q->n;
+	__m128 z0[BQ_BANDS_MAX], z1[BQ_BANDS_MAX];
+	for (uint i = 0;  i < n;  i++) {
+		z0[i] = _mm_loadu_ps(q->z[i][0]);
+		z1[i] = _mm_loadu_ps(q->z[i][1]);
+	}
+
+	float frame[4] = {};
+	for (ffsize j = 0;  j < frames;  j++) {
+		for (uint c = 0;  c < nch;  c++) {
+			frame[c] = ch[c][j * step];
+		}
+		__m128 x = _mm_loadu_ps(frame);
+
+		for (uint i = 0;  i < n;  i++) {
+			const float (*k)[8] = q->k[i];
+			__m128 y = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(k[0]), x), z0[i]);
+			z0[i] = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(_mm_loadu_ps(k[1]), x), _mm_mul_ps(_mm_loadu_ps(k[3]), y)), z1[i]);
+			z1[i] = _mm_sub_ps(_mm_mul_ps(_mm_loadu_ps(k[2]), x), _mm_mul_ps(_mm_loadu_ps(k[4]), y));
+			x = y;
+		}
+
+		_mm_storeu_ps(frame, x);
+		for (uint c = 0;  c < nch;  c++) {
+			ch[c][j * step] = frame[c];
+		}
+	}
+
+	for (uint i = 0;  i < n;  i++) {
+		_mm_storeu_ps(q->z[i][0], z0[i]);
+		_mm_storeu_ps(q->z[i][1], z1[i]);
+	}
+}
+
+__attribute__((target("avx2")))
+static void _bq_process_avx2(struct bq_eq *q, float **ch, uint step, ffsize frames)
+{
+	uint nch = q->channels, n = q->n;
+	__m256 z0[BQ_BANDS_MAX], z1[BQ_BANDS_MAX];
+	for (uint i = 0;  i < n;  i++) {
+		z0[i] = _mm256_loadu_ps(q->z[i][0]);
+		z1[i] = _mm256_loadu_ps(q->z[i][1]);
+	}
+
+	float frame[8] = {};
+	for (ffsize j = 0;  j < frames;  j++) {
+		for (uint c = 0;  c < nch;  c++) {
+			frame[c] = ch[c][j * step];
+		}
+		__m256 x = _mm256_loadu_ps(frame);
+
+		for (uint i = 0;  i < n;  i++) {
+			const float (*k)[8] = q->k[i];
+			__m256 y = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(k[0]), x), z0[i]);
+			z0[i] = _mm256_add_ps(_mm256_sub_ps(_mm256_mul_ps(_mm256_loadu_ps(k[1]), x), _mm256_mul_ps(_mm256_loadu_ps(k[3]), y)), z1[i]);
+			z1[i] = _mm256_sub_ps(_mm256_mul_ps(_mm256_loadu_ps(k[2]), x), _mm256_mul_ps(_mm256_loadu_ps(k[4]), y));
+			x = y;
+		}
+
+		_mm256_storeu_ps(frame, x);
+		for (uint c = 0;  c < nch;  c++) {
+			ch[c][j * step] = frame[c];
+		}
+	}
+
+	for (uint i = 0;  i < n;  i++) {
+		_mm256_storeu_ps(q->z[i][0], z0[i]);
+		_mm256_storeu_ps(q->z[i][1], z1[i]);
+	}
+}
+
+#endif // PCM_SIMD_X86
+
+/** Process float32 samples in-place */
+static inline void bq_process(struct bq_eq *q, int interleaved, void *data, ffsize frames)
+{
+	if (q->n == 0 || frames == 0)
+		return;
+
+	float *ch[8];
+	uint step = 1;
+	if (interleaved) {
+		for (uint c = 0;  c < q->channels;  c++) {
+			ch[c] = (float*)data + c;
+		}
+		step = q->channels;
+	} else {
+		ffmem_copy(ch, data, q->channels * sizeof(float*));
+	}
+
+#ifdef PCM_SIMD_X86
+	if (q->channels <= 4)
+		_bq_process_sse(q, ch, step, frames);
+	else if (pcm_simd_level() >= PCM_SIMD_AVX2)
+		_bq_process_avx2(q, ch, step, frames);
+	else
+		_bq_process_c(q, ch, step, frames);
+#else
+	_bq_process_c(q, ch, step, frames);
+#endif
+
+	_bq_denormal(q);
+}
@@ -5,11 +5,14 @@
 #include <util/util.h>
 #include <util/aformat.h>
 #include <ffaudio/pcm-convert.h>
+#include <afilter/pcm-simd.h>
 
 #define errlog(trk, ...)  phi_errlog(core, NULL, trk, __VA_ARGS__)
 #define dbglog(trk, ...)  phi_dbglog(core, NULL, trk, __VA_ARGS__)
 
 extern const phi_core *core;
+extern const phi_filter phi_resample;
+extern int phi_resample_supported(const phi_track *t, uint irate, uint orate);
 
 enum {
 	CONV_OUTBUF_MSEC = 500,
@@ -21,6 +24,9 @@ struct aconv {
 	ffstr in;
 	ffvec buf;
 	uint off;
+	pcm_simd_func simd; // vectorized conversion of sample format only
+	pcm_simd_ileave_func ileave; // vectorized (de)interleaving only
+	uint in_place :1; // output sample size <= input sample size: may convert in-place
 };
 
 static void* aconv_open(phi_track *t)
@@ -32,7 +38,7 @@ static void* aconv_open(phi_track *t)
 static void aconv_close(void *ctx, phi_track *t)
 {
 	struct aconv *c = ctx;
-	phi_track_free(t, c->buf.ptr);
+	phi_track_buf_free(t, c->buf.ptr);
 	phi_track_free(t, c);
 }
 
@@ -65,7 +71,27 @@ static int aconv_prepare(struct aconv *c, phi_track *t)
 	c->fi = *(struct pcm_af*)&t->aconv.in;
 	c->fo = *(struct pcm_af*)&t->aconv.out;
 
-	if (c->fi.rate != c->fo.rate) {
+	if (c->fi.rate != c->fo.rate
+		&& phi_resample_supported(t, c->fi.rate, c->fo.rate)) {
+		if (!core->track->filter(t, &phi_resample, 0))
+			return PHI_ERR;
+
+		// We convert format and channels, the next module converts sample rate, e.g.:
+		// [... --(int16/44.1/2)-> conv --(float/44.1/2)-> resample --(float/48/2)-> ... ]
+		c->fo.format = PHI_PCM_FLOAT32;
+		c->fo.rate = c->fi.rate;
+		t->aconv.in = *(struct phi_af*)&c->fo;
+		t->aconv.in.channels = c->fo.channels & PCM_CHAN_MASK;
+
+		if (c->fi.format == c->fo.format
+			&& c->fi.channels == c->fo.channels
+			&& c->fi.interleaved == c->fo.interleaved) {
+			// Next module is converting sample rate
+			t->data_out = t->data_in;
+			return PHI_DONE;
+		}
+
+	} else if (c->fi.rate != c->fo.rate) {
 		if (!core->track->filter(t, core->mod("af-soxr.conv"), 0))
 			return PHI_ERR;
 
@@ -94,6 +120,22 @@ static int aconv_prepare(struct aconv *c, phi_track *t)
 	if (r != 0)
 		return PHI_ERR;
 
+	const char *isa;
+	if (c->fi.channels == c->fo.channels
+		&& c->fi.interleaved == c->fo.interleaved
+		&& c->fi.rate == c->fo.rate
+		&& (c->simd = pcm_simd_find(c->fi.format, c->fo.format, &isa))) {
+		dbglog(t, "using %s conversion", isa);
+		c->in_place = ((c->fo.format & 0xff) <= (c->fi.format & 0xff));
+
+	} else if (c->fi.channels == c->fo.channels
+		&& c->fi.format == c->fo.format
+		&& c->fi.interleaved != c->fo.interleaved
+		&& c->fi.rate == c->fo.rate
+		&& (c->ileave = pcm_simd_ileave_find(c->fi.format, c->fi.interleaved, &isa))) {
+		dbglog(t, "using %s (de)interleaving", isa);
+	}
+
 	// Allow no more than 16MB per 1 second of 64-bit 7.1 audio: 0x00ffffff/(64/8*8)=262143
 	if (c->fo.rate > 262143) {
 		errlog(t, "too large sample rate: %u", c->fo.rate);
@@ -102,17 +144,42 @@ static int aconv_prepare(struct aconv *c, phi_track *t)
 
 	uint out_ch = c->fo.channels & PCM_CHAN_MASK;
 	c->out_samp_size = pcm_size(c->fo.format, out_ch);
+	return PHI_DATA;
+}
+
+/** Allocate output buffer on first use */
+static int aconv_buf(struct aconv *c, phi_track *t)
+{
+	uint out_ch = c->fo.channels & PCM_CHAN_MASK;
 	size_t cap = msec_to_samples(CONV_OUTBUF_MSEC, c->fo.rate) * c->out_samp_size;
-	uint n = cap;
+	size_t n = cap;
 	if (!c->fo.interleaved)
 		n = sizeof(void*) * out_ch + cap;
-	c->buf.ptr = phi_track_alloc(t, n);
+	if (NULL == (c->buf.ptr = phi_track_buf_alloc(t, n)))
+		return -1;
 	c->buf.cap = n;
 	if (!c->fo.interleaved) {
 		arrp_setbuf((void**)c->buf.ptr, out_ch, c->buf.ptr + sizeof(void*) * out_ch, cap / out_ch);
 	}
 	c->buf.len = cap / c->out_samp_size;
+	return 0;
+}
+
+/** Convert sample format in the input buffer: the output data is returned in the same buffer */
+static int aconv_in_place(struct aconv *c, phi_track *t)
+{
+	ffsize samples = t->data_in.len / pcm_size1(&c->fi);
+	if (c->fi.interleaved) {
+		c->simd((void*)t->data_in.ptr, t->data_in.ptr, samples * c->fi.channels);
+	} else {
+		for (uint i = 0;  i < c->fi.channels;  i++) {
+			void *ch = ((void**)t->data_in.ptr)[i];
+			c->simd(ch, ch, samples);
+		}
+	}
 
+	ffstr_set(&t->data_out, t->data_in.ptr, samples * c->out_samp_size);
+	c->in.len = 0;
 	return PHI_DATA;
 }
 
@@ -129,10 +196,21 @@ static int aconv_process(void *ctx, phi_track *t)
 	}
 
 	if (t->data_in.len) {
+		if (c->in_place
+			&& (t->chain_flags & PHI_FWRITABLE))
+			return aconv_in_place(c, t);
+
 		c->in = t->data_in;
 		c->off = 0;
 	}
 
+	if (c->buf.ptr == NULL) {
+		if (c->in.len == 0)
+			return (t->chain_flags & PHI_FFIRST) ? PHI_DONE : PHI_MORE;
+		if (aconv_buf(c, t))
+			return PHI_ERR;
+	}
+
 	samples = (uint)ffmin(c->in.len / pcm_size1(&c->fi), c->buf.len);
 	if (samples == 0) {
 		if (t->chain_flags & PHI_FFIRST)
@@ -147,7 +225,19 @@ static int aconv_process(void *ctx, phi_track *t)
 		data = in;
 	}
 
-	if (0 != pcm_convert(&c->fo, c->buf.ptr, &c->fi, data, samples)) {
+	if (c->simd) {
+		if (c->fi.interleaved) {
+			c->simd(c->buf.ptr, data, samples * c->fi.channels);
+		} else {
+			for (uint i = 0;  i < c->fi.channels;  i++) {
+				c->simd(((void**)c->buf.ptr)[i], ((void**)data)[i], samples);
+			}
+		}
+
+	} else if (c->ileave) {
+		c->ileave(c->buf.ptr, data, c->fi.channels, samples);
+
+	} else if (0 != pcm_convert(&c->fo, c->buf.ptr, &c->fi, data, samples)) {
 		return PHI_ERR;
 	}
 
@@ -159,5 +249,6 @@ static int aconv_process(void *ctx, phi_track *t)
 
 const phi_filter phi_aconv = {
 	aconv_open, aconv_close, aconv_process,
-	"audio-conv"
+	"audio-conv",
+	PHI_FILTER_OWN_OUTPUT
 };
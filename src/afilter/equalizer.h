@@ -0,0 +1,321 @@
+/** phiola: parametric equalizer
+2026, Simon Zolin */
+
+/* Configuration: the same as for SoX equalizer:
+	[type=band|bass|treble] [frequency=HZ] [width=N[q|o|h|k|s]] gain=DB [, ...]
+Live update: the new settings passed via phi_equalizer_if.update() are applied
+ by the tracks that are currently being processed.
+While there are no bands, the data is passed through untouched in its original format;
+ when the bands are set, the audio is converted to float32 before the filter
+ and back to the original format after it. */
+
+#include <afilter/biquad.h>
+#include <afilter/pcm-writable.h>
+#include <ffbase/args.h>
+
+struct eq_live {
+	fflock lock;
+	uint version;
+	char *conf;
+};
+static struct eq_live eq_live;
+
+enum EQ_STATE {
+	EQ_INIT,
+	EQ_CONV, // waiting for float32 input
+	EQ_RUN,
+	EQ_BYPASS, // no bands: the input isn't float32 and it isn't converted
+	EQ_CONV_LIVE, // the bands are set via live update: waiting for float32 input
+};
+
+struct eq {
+	uint state; // enum EQ_STATE
+	struct phi_af orig_fmt; // EQ_BYPASS: the input format
+	uint version;
+	uint frame_size;
+	struct phi_af fmt;
+	struct bq_eq bq;
+	struct pcm_wbuf wbuf;
+};
+
+static void eq_live_update(const char *conf)
+{
+	fflock_lock(&eq_live.lock);
+	ffmem_free(eq_live.conf);
+	eq_live.conf = ffsz_dup((conf) ? conf : "");
+	FFINT_WRITEONCE(eq_live.version, eq_live.version + 1);
+	fflock_unlock(&eq_live.lock);
+}
+
+static const phi_equalizer_if phi_equalizer = {
+	eq_live_update
+};
+
+static void eq_live_free()
+{
+	ffmem_free(eq_live.conf);
+	eq_live.conf = NULL;
+}
+
+struct eq_band_conf {
+	const char *type, *frequency, *width, *gain;
+};
+
+#define O(m)  (void*)(ffsize)FF_OFF(struct eq_band_conf, m)
+static const struct ffarg eq_band_args[] = {
+	{ "frequency",	's',	O(frequency) },
+	{ "gain",		's',	O(gain) },
+	{ "type",		's',	O(type) },
+	{ "width",		's',	O(width) },
+	{}
+};
+#undef O
+
+/** Parse "N[q|o|h|k|s]" */
+static int eq_width(struct bq_band *b, const char *sz)
+{
+	ffstr s = FFSTR_INITZ(sz);
+	double d;
+	char unit = (s.len && !(s.ptr[s.len - 1] >= '0' && s.ptr[s.len - 1] <= '9')) ? s.ptr[--s.len] : 'h';
+	if (!ffstr_to_float(&s, &d) || d <= 0)
+		return -1;
+
+	b->q = 0;
+	switch (unit) {
+	case 'q':
+		b->q = d;  break;
+	case 'o':
+		b->q = sqrt(pow(2, d)) / (pow(2, d) - 1);  break;
+	case 'h':
+		b->q = b->freq / d;  break;
+	case 'k':
+		b->q = b->freq / (d * 1000);  break;
+	case 's':
+		if (b->type == BQ_PEAK || d > 1)
+			return -1;
+		b->slope = d;  break;
+	default:
+		return -1;
+	}
+	return 0;
+}
+
+/**
+Return 1: empty */
+static int eq_band_parse(phi_track *t, char *sz, struct bq_band *b)
+{
+	struct eq_band_conf bc = {};
+	struct ffargs a = {};
+	if (ffargs_process_line(&a, eq_band_args, &bc, FFARGS_O_PARTIAL | FFARGS_O_DUPLICATES, sz)) {
+		errlog(t, "%s", a.error);
+		return -1;
+	}
+	if (!a.argi)
+		return 1;
+
+	static const struct {
+		char name[7];
+		u_char type;
+		ushort freq;
+	} eq_types[] = {
+		{ "band",	BQ_PEAK,		0 },
+		{ "bass",	BQ_LOWSHELF,	100 },
+		{ "treble",	BQ_HIGHSHELF,	3000 },
+	};
+	uint i = 0;
+	if (bc.type) {
+		for (i = 0;  i < FF_COUNT(eq_types);  i++) {
+			if (ffsz_eq(bc.type, eq_types[i].name))
+				break;
+		}
+		if (i == FF_COUNT(eq_types))
+			return -1;
+	}
+
+	ffmem_zero_obj(b);
+	b->type = eq_types[i].type;
+	b->freq = eq_types[i].freq;
+	b->slope = 0.5;
+
+	ffstr s;
+	if (!bc.gain)
+		return -1;
+	ffstr_setz(&s, bc.gain);
+	if (!ffstr_to_float(&s, &b->gain))
+		return -1;
+
+	if (bc.frequency) {
+		ffstr_setz(&s, bc.frequency);
+		if (!ffstr_to_float(&s, &b->freq))
+			return -1;
+	}
+
+	if (b->type == BQ_PEAK) {
+		if (!bc.frequency || !bc.width)
+			return -1;
+	}
+	if (bc.width && eq_width(b, bc.width))
+		return -1;
+	return 0;
+}
+
+/** Parse configuration and set new coefficients */
+static int eq_conf(struct eq *c, phi_track *t, const char *conf)
+{
+	struct bq_band bands[BQ_BANDS_MAX];
+	uint n = 0;
+	char *args = ffsz_dup(conf);
+	ffstr s = FFSTR_INITZ(args), sc;
+	dbglog(t, "conf: '%S'", &s);
+	int r = -1;
+
+	while (s.len) {
+		ffstr_skipchar(&s, ' ');
+		ffstr_splitby(&s, ',', &sc, &s);
+		sc.ptr[sc.len] = '\0';
+
+		if (n == BQ_BANDS_MAX)
+			goto end;
+		switch (eq_band_parse(t, sc.ptr, &bands[n])) {
+		case 0:
+			dbglog(t, "band #%u: type:%u  frequency:%F  Q:%F  gain:%F"
+				, n + 1, bands[n].type, bands[n].freq, bands[n].q, bands[n].gain);
+			n++;
+			break;
+		case 1:
+			break;
+		default:
+			goto end;
+		}
+	}
+
+	if (bq_set(&c->bq, bands, n))
+		goto end;
+	r = 0;
+
+end:
+	if (r)
+		errlog(t, "Equalizer: incorrect parameters");
+	ffmem_free(args);
+	return r;
+}
+
+static void* eq_open(phi_track *t)
+{
+	struct eq *c = phi_track_allocT(t, struct eq);
+	c->version = FFINT_READONCE(eq_live.version);
+	return c;
+}
+
+static void eq_close(void *ctx, phi_track *t)
+{
+	struct eq *c = ctx;
+	pcm_wbuf_free(&c->wbuf, t);
+	phi_track_free(t, c);
+}
+
+static int eq_input_conversion(phi_track *t)
+{
+	if (!core->track->filter(t, core->mod("afilter.conv"), PHI_TF_PREV))
+		return PHI_ERR;
+
+	t->aconv.in = (t->oaudio.format.format) ? t->oaudio.format : t->audio.format;
+	t->aconv.out = t->aconv.in;
+	t->aconv.out.format = PHI_PCM_FLOAT32;
+	t->oaudio.format = t->aconv.out;
+	t->data_out = t->data_in;
+	return PHI_BACK;
+}
+
+/** Apply the settings from phi_equalizer_if.update() */
+static void eq_live_apply(struct eq *c, phi_track *t)
+{
+	fflock_lock(&eq_live.lock);
+	char *conf = ffsz_dup(eq_live.conf);
+	c->version = eq_live.version;
+	fflock_unlock(&eq_live.lock);
+
+	if (eq_conf(c, t, conf))
+		c->bq.n = 0; // bypass
+	ffmem_free(conf);
+}
+
+static int eq_process(void *ctx, phi_track *t)
+{
+	struct eq *c = ctx;
+	const struct phi_af *af = (t->oaudio.format.format) ? &t->oaudio.format : &t->audio.format;
+
+	switch (c->state) {
+	case EQ_INIT:
+	case EQ_CONV:
+		if (af->channels > 8 || af->rate == 0) {
+			errlog(t, "input audio format not supported");
+			return PHI_ERR;
+		}
+
+		c->fmt = *af;
+		bq_init(&c->bq, af->channels, af->rate);
+		if (eq_conf(c, t, (t->conf.afilter.equalizer) ? t->conf.afilter.equalizer : "")) {
+			t->error = PHI_E_FILTER_CONF;
+			return PHI_ERR;
+		}
+
+		if (af->format != PHI_PCM_FLOAT32) {
+			if (c->state == EQ_INIT) {
+				if (c->bq.n == 0) {
+					c->orig_fmt = *af;
+					c->state = EQ_BYPASS;
+					break;
+				}
+				c->state = EQ_CONV;
+				return eq_input_conversion(t);
+			}
+			errlog(t, "input audio format not supported");
+			return PHI_ERR;
+		}
+
+		c->frame_size = pcm_size1(af);
+		c->state = EQ_RUN;
+		break;
+
+	case EQ_CONV_LIVE:
+		if (af->format != PHI_PCM_FLOAT32) {
+			errlog(t, "input audio format not supported");
+			return PHI_ERR;
+		}
+
+		// [... -> conv --(float32)-> eq --(float32)-> conv --(original format)-> ...]
+		if (!core->track->filter(t, core->mod("afilter.conv"), 0))
+			return PHI_ERR;
+		c->fmt = *af;
+		c->frame_size = pcm_size1(af);
+		t->aconv.in = *af;
+		t->aconv.out = c->orig_fmt;
+		t->oaudio.format = c->orig_fmt;
+		c->state = EQ_RUN;
+		break;
+	}
+
+	if (FFINT_READONCE(eq_live.version) != c->version) {
+		eq_live_apply(c, t);
+		if (c->state == EQ_BYPASS && c->bq.n) {
+			c->state = EQ_CONV_LIVE;
+			return eq_input_conversion(t);
+		}
+	}
+
+	if (t->data_in.len && c->bq.n) {
+		if (pcm_wbuf_get(&c->wbuf, t, &c->fmt))
+			return PHI_ERR;
+		bq_process(&c->bq, c->fmt.interleaved, (void*)t->data_in.ptr, t->data_in.len / c->frame_size);
+	}
+
+	t->data_out = t->data_in;
+	return (t->chain_flags & PHI_FFIRST) ? PHI_DONE : PHI_OK;
+}
+
+static const phi_filter phi_eq = {
+	eq_open, eq_close, eq_process,
+	"equalizer",
+	PHI_FILTER_INPLACE
+};
@@ -3,6 +3,8 @@
 
 #include <track.h>
 #include <util/util.h>
+#include <afilter/pcm-stat.h>
+#include <afilter/pcm-writable.h>
 #include <ffaudio/pcm-gain.h>
 
 extern const phi_core *core;
@@ -11,7 +13,9 @@ extern const phi_core *core;
 struct gain {
 	struct pcm_af af;
 	uint sample_size;
+	uint fused :1; // pcm_gain_stat() supports this format
 	double db, gain;
+	struct pcm_wbuf wbuf;
 };
 
 static void* gain_open(phi_track *t)
@@ -20,6 +24,7 @@ static void* gain_open(phi_track *t)
 	const struct phi_af *af = (t->oaudio.format.format) ? &t->oaudio.format : &t->audio.format;
 	c->sample_size = pcm_size1(af);
 	c->af = *(struct pcm_af*)af;
+	c->fused = !pcm_gain_stat(af, 1, NULL, 0, NULL);
 	t->oaudio.gain_db = (t->oaudio.gain_db) ? t->oaudio.gain_db : t->conf.afilter.gain_db;
 	c->db = -t->oaudio.gain_db;
 	return c;
@@ -28,6 +33,7 @@ static void* gain_open(phi_track *t)
 static void gain_close(void *ctx, phi_track *t)
 {
 	struct gain *c = ctx;
+	pcm_wbuf_free(&c->wbuf, t);
 	phi_track_free(t, c);
 }
 
@@ -41,7 +47,13 @@ static int gain_process(void *ctx, phi_track *t)
 			c->gain = db_gain(db);
 			dbglog(t, "gain: %.02FdB %.02F", db, c->gain);
 		}
-		pcm_gain(&c->af, c->gain, t->data_in.ptr, (void*)t->data_in.ptr, t->data_in.len / c->sample_size);
+		if (pcm_wbuf_get(&c->wbuf, t, (struct phi_af*)&c->af))
+			return PHI_ERR;
+		ffsize samples = t->data_in.len / c->sample_size;
+		if (c->fused)
+			pcm_gain_stat((struct phi_af*)&c->af, c->gain, (void*)t->data_in.ptr, samples, NULL);
+		else
+			pcm_gain(&c->af, c->gain, t->data_in.ptr, (void*)t->data_in.ptr, samples);
 	}
 
 	t->data_out = t->data_in;
@@ -50,5 +62,6 @@ static int gain_process(void *ctx, phi_track *t)
 
 const phi_filter phi_gain = {
 	gain_open, gain_close, gain_process,
-	"gain"
+	"gain",
+	PHI_FILTER_INPLACE
 };
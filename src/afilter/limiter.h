@@ -0,0 +1,180 @@
+/** phiola: lookahead peak limiter
+2026, Simon Zolin */
+
+/* Input: interleaved float64.
+The signal is delayed by 'lookahead' samples, so the gain can be reduced smoothly before a peak arrives:
+1. The peak of each frame is estimated with 2x oversampling (4-tap half-sample interpolation),
+    so most inter-sample peaks are caught.
+2. Required gain: min(1, ceiling / peak).
+3. Sliding minimum of the required gain over the last (lookahead + 1) frames:
+    monotonic queue, O(1) per frame.
+4. Moving average over the last 'lookahead' values of (3):
+    the gain ramps down smoothly and is never higher than required at the peak.
+5. Release: the gain recovers exponentially.
+The processing is done in-place; the last 'lookahead' frames are returned by limiter_flush(). */
+
+#pragma once
+#include <math.h>
+
+struct limiter {
+	uint channels;
+	uint la; // lookahead (frames)
+	double ceiling; // linear
+	double release; // recovery coefficient per frame
+	double gain;
+
+	double *delay; // [la * channels]
+	uint delay_pos;
+	double hist[3][8]; // the last 3 input frames (for interpolation)
+
+	// sliding minimum
+	double *q_val;
+	uint64 *q_idx;
+	uint q_head, q_n, q_cap;
+	uint64 n;
+
+	// moving average
+	double *avg; // [la]
+	double avg_sum;
+	uint avg_pos;
+};
+
+/** Set the initial state: no gain reduction, empty delay line */
+static inline void _limiter_state_init(struct limiter *l)
+{
+	l->gain = 1;
+	ffmem_zero(l->delay, l->la * l->channels * sizeof(double));
+	l->delay_pos = 0;
+	ffmem_zero(l->hist, sizeof(l->hist));
+
+	l->q_head = l->q_n = 0;
+	l->n = 0;
+
+	for (uint i = 0;  i < l->la;  i++) {
+		l->avg[i] = 1;
+	}
+	l->avg_sum = l->la;
+	l->avg_pos = 0;
+}
+
+/**
+lookahead_msec: 1..10 (larger values are limited to 10)
+ceiling_db: max. output peak level (dBFS)
+Return 0 on success */
+static inline int limiter_init(struct limiter *l, uint channels, uint rate, uint lookahead_msec, double ceiling_db)
+{
+	if (channels > 8 || lookahead_msec == 0)
+		return -1;
+
+	ffmem_zero_obj(l);
+	l->channels = channels;
+	l->la = ffmax(rate * ffmin(lookahead_msec, 10) / 1000, 1);
+	l->ceiling = pow(10, ceiling_db / 20);
+	l->release = 1 - exp(-1.0 / (rate * 0.050)); // 50ms time constant
+	l->q_cap = l->la + 1;
+
+	l->delay = ffmem_calloc(l->la * channels, sizeof(double));
+	l->avg = ffmem_alloc(l->la * sizeof(double));
+	l->q_val = ffmem_alloc(l->q_cap * sizeof(double));
+	l->q_idx = ffmem_alloc(l->q_cap * sizeof(uint64));
+	_limiter_state_init(l);
+	return 0;
+}
+
+static inline void limiter_close(struct limiter *l)
+{
+	ffmem_free(l->delay);
+	ffmem_free(l->avg);
+	ffmem_free(l->q_val);
+	ffmem_free(l->q_idx);
+}
+
+/** Get the peak level of the current frame including the estimated inter-sample peak before it */
+static inline double _limiter_peak(struct limiter *l, const double *frame)
+{
+	double peak = 0;
+	for (uint c = 0;  c < l->channels;  c++) {
+		double x0 = l->hist[0][c], x1 = l->hist[1][c], x2 = l->hist[2][c], x3 = frame[c];
+		double mid = (9 * (x1 + x2) - (x0 + x3)) * (1.0 / 16); // value between x1 and x2
+		peak = ffmax(peak, ffmax(fabs(mid), fabs(x3)));
+		l->hist[0][c] = x1;
+		l->hist[1][c] = x2;
+		l->hist[2][c] = x3;
+	}
+	return peak;
+}
+
+/** Add value to the sliding-minimum queue and get the minimum over the window */
+static inline double _limiter_min(struct limiter *l, double v)
+{
+	// remove the value that is out of the window
+	if (l->q_n != 0 && l->q_idx[l->q_head] + l->q_cap <= l->n) {
+		l->q_head = (l->q_head + 1) % l->q_cap;
+		l->q_n--;
+	}
+
+	// remove the values that can't be the minimum anymore
+	while (l->q_n != 0) {
+		uint last = (l->q_head + l->q_n - 1) % l->q_cap;
+		if (l->q_val[last] < v)
+			break;
+		l->q_n--;
+	}
+
+	uint i = (l->q_head + l->q_n) % l->q_cap;
+	l->q_val[i] = v;
+	l->q_idx[i] = l->n;
+	l->q_n++;
+
+	l->n++;
+	return l->q_val[l->q_head];
+}
+
+static inline double _limiter_gain(struct limiter *l, double peak)
+{
+	double g = (peak > l->ceiling) ? l->ceiling / peak : 1;
+	g = _limiter_min(l, g);
+
+	l->avg_sum += g - l->avg[l->avg_pos];
+	l->avg[l->avg_pos] = g;
+	l->avg_pos = (l->avg_pos + 1) % l->la;
+	g = ffmin(l->avg_sum / l->la, 1);
+
+	if (g < l->gain)
+		l->gain = g;
+	else
+		l->gain += (g - l->gain) * l->release;
+	return l->gain;
+}
+
+/** Process the frames in-place: the output is delayed by 'lookahead' frames */
+static inline void limiter_process(struct limiter *l, double *data, ffsize frames)
+{
+	uint nch = l->channels;
+	for (ffsize i = 0;  i < frames;  i++) {
+		double *frame = data + i * nch;
+		double g = _limiter_gain(l, _limiter_peak(l, frame));
+
+		double *d = l->delay + l->delay_pos * nch;
+		for (uint c = 0;  c < nch;  c++) {
+			double out = d[c] * g;
+			d[c] = frame[c];
+			frame[c] = out;
+		}
+		l->delay_pos = (l->delay_pos + 1) % l->la;
+	}
+}
+
+/** Get the remaining frames at the end of stream.
+dst: [lookahead * channels] */
+static inline void limiter_flush(struct limiter *l, double *dst)
+{
+	ffmem_zero(dst, l->la * l->channels * sizeof(double));
+	limiter_process(l, dst, l->la);
+}
+
+/** Drop the delayed data and the gain state (e.g. after seeking) */
+static inline void limiter_reset(struct limiter *l)
+{
+	_limiter_state_init(l);
+}
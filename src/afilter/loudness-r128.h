@@ -0,0 +1,137 @@
+/** phiola: native loudness analyzer
+2026, Simon Zolin */
+
+/* Accepts any PCM format supported by r128.h, so no conversion to float64 is needed.
+Several tracks may be analyzed in parallel on different workers:
+ when a track is finished, its block energies are merged into the album data of its queue.
+The album data is returned and reset by phi_loudness_album_if.get(). */
+
+#include <afilter/r128.h>
+
+struct r128_album {
+	phi_queue_id q;
+	ffvec blocks; // double[]
+	double peak;
+	uint tracks;
+};
+
+static struct {
+	fflock lock;
+	ffvec albums; // struct r128_album[]
+} r128_albums;
+
+struct loudness_r128 {
+	struct phi_af fmt;
+	uint sample_size;
+	struct r128 r;
+};
+
+static void* ldr_open(phi_track *t)
+{
+	const struct phi_af *af = (t->oaudio.format.format) ? &t->oaudio.format : &t->audio.format;
+	if (!r128_format_supported(af) || af->rate == 0) {
+		errlog(t, "input audio format not supported");
+		return PHI_OPEN_ERR;
+	}
+
+	struct loudness_r128 *c = phi_track_allocT(t, struct loudness_r128);
+	c->fmt = *af;
+	c->sample_size = pcm_size1(af);
+	r128_init(&c->r, af->channels, af->rate);
+	return c;
+}
+
+static void ldr_close(void *ctx, phi_track *t)
+{
+	struct loudness_r128 *c = ctx;
+	r128_close(&c->r);
+	phi_track_free(t, c);
+}
+
+/** Find album data for the queue */
+static struct r128_album* ldr_album_find(phi_queue_id q)
+{
+	struct r128_album *a;
+	FFSLICE_WALK(&r128_albums.albums, a) {
+		if (a->q == q)
+			return a;
+	}
+	return NULL;
+}
+
+static void ldr_album_add(phi_track *t, const struct r128 *r)
+{
+	phi_queue_id q = NULL;
+	if (t->qent) {
+		const phi_queue_if *qif = core->mod("core.queue");
+		q = qif->queue(t->qent);
+	}
+
+	fflock_lock(&r128_albums.lock);
+	struct r128_album *a = ldr_album_find(q);
+	if (a == NULL) {
+		a = ffvec_zpushT(&r128_albums.albums, struct r128_album);
+		a->q = q;
+	}
+	ffvec_add(&a->blocks, r->blocks.ptr, r->blocks.len, sizeof(double));
+	a->peak = ffmax(a->peak, r->peak);
+	a->tracks++;
+	fflock_unlock(&r128_albums.lock);
+}
+
+static uint ldr_album_get(phi_queue_id q, double *loudness, double *peak)
+{
+	uint n = 0;
+	fflock_lock(&r128_albums.lock);
+	struct r128_album *a = ldr_album_find(q);
+	if (a != NULL) {
+		*loudness = r128_integrated(a->blocks.ptr, a->blocks.len);
+		*peak = a->peak;
+		n = a->tracks;
+		ffvec_free(&a->blocks);
+		ffslice_rmT((ffslice*)&r128_albums.albums, a - (struct r128_album*)r128_albums.albums.ptr, 1, struct r128_album);
+	}
+	fflock_unlock(&r128_albums.lock);
+	return n;
+}
+
+static const phi_loudness_album_if phi_loudness_album = {
+	ldr_album_get
+};
+
+static void ldr_album_free()
+{
+	struct r128_album *a;
+	FFSLICE_WALK(&r128_albums.albums, a) {
+		ffvec_free(&a->blocks);
+	}
+	ffvec_free(&r128_albums.albums);
+}
+
+static int ldr_process(void *ctx, phi_track *t)
+{
+	struct loudness_r128 *c = ctx;
+	t->data_out = t->data_in;
+
+	r128_process(&c->r, &c->fmt, t->data_in.ptr, t->data_in.len / c->sample_size);
+	t->oaudio.loudness_momentary = r128_momentary(&c->r);
+
+	if (t->chain_flags & PHI_FFIRST) {
+		double global = r128_integrated(c->r.blocks.ptr, c->r.blocks.len);
+		t->oaudio.loudness = global;
+		t->oaudio.loudness_peak = c->r.peak;
+		dbglog(t, "loudness: %f  blocks:%L", global, c->r.blocks.len);
+		if (t->conf.afilter.loudness_summary)
+			userlog(t, "Loudness: %f", global);
+		if (!t->error)
+			ldr_album_add(t, &c->r);
+		return PHI_DONE;
+	}
+	return PHI_OK;
+}
+
+static const phi_filter phi_loudness_r128 = {
+	ldr_open, ldr_close, ldr_process,
+	"loudness",
+	PHI_FILTER_INPLACE
+};
@@ -2,6 +2,7 @@
 2025, Simon Zolin */
 
 #include <track.h>
+#include <afilter/pcm-writable.h>
 #include <ffsys/std.h>
 #include <ffbase/args.h>
 
@@ -39,6 +40,7 @@ struct noise_gate {
 	unsigned sample_size;
 	unsigned state;
 	unsigned opened;
+	struct pcm_wbuf wbuf;
 };
 
 static void* noise_gate_open(phi_track *t)
@@ -65,6 +67,7 @@ static void* noise_gate_open(phi_track *t)
 static void noise_gate_close(void *ctx, phi_track *t)
 {
 	struct noise_gate *c = ctx;
+	pcm_wbuf_free(&c->wbuf, t);
 	phi_track_free(t, c);
 }
 
@@ -113,6 +116,8 @@ static int noise_gate_process(void *ctx, phi_track *t)
 		c->state = 2;
 	}
 
+	if (pcm_wbuf_get(&c->wbuf, t, &t->oaudio.format))
+		return PHI_ERR;
 	double *d = (double*)t->data_in.ptr;
 	size_t samples = t->data_in.len / c->sample_size;
 	for (size_t i = 0;  i < samples;  i++, d += c->channels) {
@@ -152,5 +157,6 @@ static int noise_gate_process(void *ctx, phi_track *t)
 
 const phi_filter phi_noise_gate = {
 	noise_gate_open, noise_gate_close, noise_gate_process,
-	"noise-gate"
+	"noise-gate",
+	PHI_FILTER_INPLACE
 };
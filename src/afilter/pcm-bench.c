@@ -0,0 +1,172 @@
+/** phiola: benchmark: vectorized vs. scalar PCM conversion
+2026, Simon Zolin
+
+First, checks that the vectorized functions produce exactly the same output as the scalar ones.
+Then, prints the speed of each function in millions of values per second.
+Usage:
+	pcm-bench [VALUES]
+*/
+
+#include <phiola.h>
+#include <afilter/pcm-simd.h>
+#include <ffsys/time.h>
+#include <ffsys/std.h>
+#include <ffbase/string.h>
+
+static const char pcm_simd_names[][8] = {
+	"i16>f32", "f32>i16", "i24>f32", "f32>i24",
+	"i32>f32", "f32>i32", "f64>f32", "f32>f64",
+};
+
+/** Fill the buffer with the values which test rounding and clipping */
+static void test_fill(void *buf, uint ifunc, ffsize n)
+{
+	static const float vals[] = {
+		0, 1, -1, 0.5, -0.5, 1.0001, -1.0001, 2, -2, 0.99999994, -0.99999994,
+		1.0 / 65536, -1.0 / 65536, 1.5 / 32768, 2.5 / 32768, -1.5 / 32768,
+		1.5 / 8388608, 2.5 / 8388608, 0.5 / 2147483648.0,
+	};
+	uint seed = 1;
+	for (ffsize i = 0;  i < n;  i++) {
+		seed = seed * 1103515245 + 12345;
+		float f = (i < FF_COUNT(vals)) ? vals[i] : (int)seed * (1.25f / 2147483648.0f);
+		switch (ifunc) {
+		case PCM_SIMD_F32_I16:
+		case PCM_SIMD_F32_I24:
+		case PCM_SIMD_F32_I32:
+		case PCM_SIMD_F32_F64:
+			((float*)buf)[i] = f; break;
+		case PCM_SIMD_F64_F32:
+			((double*)buf)[i] = (double)f + (double)(int)seed / (1ULL << 60); break;
+		case PCM_SIMD_I16_F32:
+			((short*)buf)[i] = seed >> 16; break;
+		case PCM_SIMD_I24_F32:
+			int_htol24((u_char*)buf + i * 3, seed >> 8); break;
+		case PCM_SIMD_I32_F32:
+			((int*)buf)[i] = seed; break;
+		}
+	}
+}
+
+/** Check the functions against the scalar ones,
+ including the tail values that don't fill a whole vector.
+Return 0 on success */
+static int test(const struct pcm_simd *impl)
+{
+	double in[48], out[48], out_c[48];
+	for (uint f = 0;  f < PCM_SIMD_N;  f++) {
+		for (ffsize n = 0;  n <= 40;  n++) {
+			test_fill(in, f, n);
+			ffmem_fill(out, 0xcc, sizeof(out));
+			ffmem_fill(out_c, 0xcc, sizeof(out_c));
+			pcm_simd_scalar.funcs[f](out_c, in, n);
+			impl->funcs[f](out, in, n);
+			if (ffmem_cmp(out, out_c, sizeof(out))) {
+				ffstdout_fmt("%s: %s: FAILED with %L values\n", impl->isa, pcm_simd_names[f], n);
+				return -1;
+			}
+		}
+	}
+
+	int ni[2][48], ni_c[2][48], il[96], il_c[96];
+	for (uint ch = 1;  ch <= 2;  ch++) {
+		for (ffsize n = 0;  n <= 40;  n++) {
+			test_fill(il, PCM_SIMD_I32_F32, n * ch);
+			void *ptrs[2] = { ni[0], ni[1] }, *ptrs_c[2] = { ni_c[0], ni_c[1] };
+			ffmem_fill(ni, 0xcc, sizeof(ni));
+			ffmem_fill(ni_c, 0xcc, sizeof(ni_c));
+			pcm_simd_scalar.deileave(ptrs_c, il, ch, n);
+			impl->deileave(ptrs, il, ch, n);
+
+			ffmem_fill(il, 0xcc, sizeof(il));
+			ffmem_fill(il_c, 0xcc, sizeof(il_c));
+			pcm_simd_scalar.ileave(il_c, ptrs_c, ch, n);
+			impl->ileave(il, ptrs, ch, n);
+
+			if (ffmem_cmp(ni, ni_c, sizeof(ni)) || ffmem_cmp(il, il_c, sizeof(il))) {
+				ffstdout_fmt("%s: (de)interleave: FAILED with %u channels, %L samples\n", impl->isa, ch, n);
+				return -1;
+			}
+		}
+	}
+	return 0;
+}
+
+static uint64 nsec_since(fftime t1)
+{
+	fftime t2;
+	fftime_now(&t2);
+	fftime_sub(&t2, &t1);
+	return (uint64)t2.sec * 1000000000 + t2.nsec;
+}
+
+#define ROUNDS  16
+
+/** Print the speed of each function */
+static void bench(const struct pcm_simd *impl, ffsize n)
+{
+	void *in = ffmem_alloc(n * 8), *out = ffmem_alloc(n * 8);
+	fftime t1;
+	for (uint f = 0;  f < PCM_SIMD_N;  f++) {
+		test_fill(in, f, n);
+		fftime_now(&t1);
+		for (uint i = 0;  i < ROUNDS;  i++) {
+			impl->funcs[f](out, in, n);
+		}
+		uint64 ns = nsec_since(t1);
+		ffstdout_fmt("%s: %s: %UM values/sec\n"
+			, impl->isa, pcm_simd_names[f], (uint64)n * ROUNDS * 1000 / ffmax(ns, 1));
+	}
+
+	// stereo
+	void *ptrs[2] = { out, (int*)out + n / 2 };
+	fftime_now(&t1);
+	for (uint i = 0;  i < ROUNDS;  i++) {
+		impl->deileave(ptrs, in, 2, n / 2);
+	}
+	uint64 ns = nsec_since(t1);
+	ffstdout_fmt("%s: deinterleave: %UM values/sec\n"
+		, impl->isa, (uint64)n * ROUNDS * 1000 / ffmax(ns, 1));
+
+	fftime_now(&t1);
+	for (uint i = 0;  i < ROUNDS;  i++) {
+		impl->ileave(in, ptrs, 2, n / 2);
+	}
+	ns = nsec_since(t1);
+	ffstdout_fmt("%s: interleave: %UM values/sec\n"
+		, impl->isa, (uint64)n * ROUNDS * 1000 / ffmax(ns, 1));
+
+	ffmem_free(in);
+	ffmem_free(out);
+}
+
+int main(int argc, char **argv)
+{
+	uint n = 1024*1024;
+	ffstr s;
+	if (argc > 1) {
+		ffstr_setz(&s, argv[1]);
+		ffstr_toint(&s, &n, FFS_INT32);
+	}
+
+	const struct pcm_simd *impls[3] = { &pcm_simd_scalar };
+	uint n_impls = 1;
+	uint level = pcm_simd_level();
+#ifdef PCM_SIMD_X86
+	if (level >= PCM_SIMD_AVX2)
+		impls[n_impls++] = &pcm_simd_avx2;
+	if (level >= PCM_SIMD_AVX512)
+		impls[n_impls++] = &pcm_simd_avx512;
+#endif
+	(void)level;
+
+	for (uint i = 1;  i < n_impls;  i++) {
+		if (test(impls[i]))
+			return 1;
+	}
+
+	for (uint i = 0;  i < n_impls;  i++) {
+		bench(impls[i], n);
+	}
+	return 0;
+}
@@ -0,0 +1,495 @@
+/** phiola: vectorized PCM format conversion with run-time CPU detection
+2026, Simon Zolin */
+
+/* Each function converts 'n' values (samples * channels).
+The results are the same as with the scalar functions from pcm.h:
+ float -> integer: scale, clip, round to nearest even.
+Supported: int16/int24/int32 <-> float32, float32 <-> float64.
+(De)interleaving functions convert 'n' samples of 32-bit values (float32, int32);
+ the vectorized version is used for stereo.
+Channel mixing is performed by pcm_convert().
+Correctness check and benchmark: pcm-bench.c */
+
+#pragma once
+#include <afilter/pcm.h>
+
+#if (defined FF_AMD64 || defined FF_X86) && defined __GNUC__
+	#define PCM_SIMD_X86
+	#include <immintrin.h>
+#endif
+
+typedef void (*pcm_simd_func)(void *dst, const void *src, ffsize n);
+
+/** (De)interleave 32-bit samples.
+Interleave: src: void*[], dst: interleaved.
+Deinterleave: src: interleaved, dst: void*[]. */
+typedef void (*pcm_simd_ileave_func)(void *dst, const void *src, uint channels, ffsize n);
+
+static void pcm_i16_f32_c(void *dst, const void *src, ffsize n)
+{
+	const short *s = src;
+	float *d = dst;
+	for (ffsize i = 0;  i < n;  i++) {
+		d[i] = s[i] * (float)(1 / max16f);
+	}
+}
+
+static void pcm_f32_i16_c(void *dst, const void *src, ffsize n)
+{
+	const float *s = src;
+	short *d = dst;
+	for (ffsize i = 0;  i < n;  i++) {
+		d[i] = pcm_flt_16le(s[i]);
+	}
+}
+
+static void pcm_i32_f32_c(void *dst, const void *src, ffsize n)
+{
+	const int *s = src;
+	float *d = dst;
+	for (ffsize i = 0;  i < n;  i++) {
+		d[i] = pcm_32_flt(s[i]);
+	}
+}
+
+static void pcm_f32_i32_c(void *dst, const void *src, ffsize n)
+{
+	const float *s = src;
+	int *d = dst;
+	for (ffsize i = 0;  i < n;  i++) {
+		d[i] = pcm_flt_32(s[i]);
+	}
+}
+
+static void pcm_i24_f32_c(void *dst, const void *src, ffsize n)
+{
+	const u_char *s = src;
+	float *d = dst;
+	for (ffsize i = 0;  i < n;  i++) {
+		d[i] = pcm_24_flt(int_ltoh24s(s + i * 3));
+	}
+}
+
+static void pcm_f32_i24_c(void *dst, const void *src, ffsize n)
+{
+	const float *s = src;
+	u_char *d = dst;
+	for (ffsize i = 0;  i < n;  i++) {
+		int_htol24(d + i * 3, pcm_flt_24(s[i]));
+	}
+}
+
+static void pcm_f64_f32_c(void *dst, const void *src, ffsize n)
+{
+	const double *s = src;
+	float *d = dst;
+	for (ffsize i = 0;  i < n;  i++) {
+		d[i] = s[i];
+	}
+}
+
+static void pcm_f32_f64_c(void *dst, const void *src, ffsize n)
+{
+	const float *s = src;
+	double *d = dst;
+	for (ffsize i = 0;  i < n;  i++) {
+		d[i] = s[i];
+	}
+}
+
+static void pcm_ileave32_c(void *dst, const void *src, uint channels, ffsize n)
+{
+	const int **s = (const int**)src;
+	int *d = dst;
+	for (uint c = 0;  c < channels;  c++) {
+		for (ffsize i = 0;  i < n;  i++) {
+			d[i * channels + c] = s[c][i];
+		}
+	}
+}
+
+static void pcm_deileave32_c(void *dst, const void *src, uint channels, ffsize n)
+{
+	const int *s = src;
+	int **d = dst;
+	for (uint c = 0;  c < channels;  c++) {
+		for (ffsize i = 0;  i < n;  i++) {
+			d[c][i] = s[i * channels + c];
+		}
+	}
+}
+
+#ifdef PCM_SIMD_X86
+
+__attribute__((target("avx2")))
+static void pcm_ileave32_avx2(void *dst, const void *src, uint channels, ffsize n)
+{
+	if (channels != 2) {
+		pcm_ileave32_c(dst, src, channels, n);
+		return;
+	}
+
+	const float *l = ((const float**)src)[0], *r = ((const float**)src)[1];
+	float *d = dst;
+	ffsize i = 0;
+	for (;  i + 8 <= n;  i += 8) {
+		__m256 vl = _mm256_loadu_ps(l + i), vr = _mm256_loadu_ps(r + i);
+		// per 128-bit lane: L0 R0 L1 R1 | L4 R4 L5 R5;  L2 R2 L3 R3 | L6 R6 L7 R7
+		__m256 lo = _mm256_unpacklo_ps(vl, vr), hi = _mm256_unpackhi_ps(vl, vr);
+		_mm256_storeu_ps(d + i * 2, _mm256_permute2f128_ps(lo, hi, 0x20));
+		_mm256_storeu_ps(d + i * 2 + 8, _mm256_permute2f128_ps(lo, hi, 0x31));
+	}
+	const void *tail[2] = { l + i, r + i };
+	pcm_ileave32_c(d + i * 2, tail, 2, n - i);
+}
+
+__attribute__((target("avx2")))
+static void pcm_deileave32_avx2(void *dst, const void *src, uint channels, ffsize n)
+{
+	if (channels != 2) {
+		pcm_deileave32_c(dst, src, channels, n);
+		return;
+	}
+
+	const float *s = src;
+	float *l = ((float**)dst)[0], *r = ((float**)dst)[1];
+	ffsize i = 0;
+	for (;  i + 8 <= n;  i += 8) {
+		__m256 a = _mm256_loadu_ps(s + i * 2), b = _mm256_loadu_ps(s + i * 2 + 8);
+		// per 128-bit lane: L0 L1 L4 L5 | L2 L3 L6 L7: restore the order of 64-bit pairs
+		__m256 vl = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(2,0,2,0));
+		__m256 vr = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3,1,3,1));
+		_mm256_storeu_ps(l + i, _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(vl), 0xd8)));
+		_mm256_storeu_ps(r + i, _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(vr), 0xd8)));
+	}
+	void *tail[2] = { l + i, r + i };
+	pcm_deileave32_c(tail, s + i * 2, 2, n - i);
+}
+
+__attribute__((target("avx2")))
+static void pcm_i16_f32_avx2(void *dst, const void *src, ffsize n)
+{
+	const short *s = src;
+	float *d = dst;
+	const __m256 k = _mm256_set1_ps((float)(1 / max16f));
+	ffsize i = 0;
+	for (;  i + 8 <= n;  i += 8) {
+		__m256i v = _mm256_cvtepi16_epi32(_mm_loadu_si128((__m128i*)(s + i)));
+		_mm256_storeu_ps(d + i, _mm256_mul_ps(_mm256_cvtepi32_ps(v), k));
+	}
+	pcm_i16_f32_c(d + i, s + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static void pcm_f32_i16_avx2(void *dst, const void *src, ffsize n)
+{
+	const float *s = src;
+	short *d = dst;
+	const __m256 k = _mm256_set1_ps(max16f)
+		, lo = _mm256_set1_ps(-max16f)
+		, hi = _mm256_set1_ps(max16f - 1);
+	ffsize i = 0;
+	for (;  i + 16 <= n;  i += 16) {
+		__m256 a = _mm256_mul_ps(_mm256_loadu_ps(s + i), k);
+		__m256 b = _mm256_mul_ps(_mm256_loadu_ps(s + i + 8), k);
+		a = _mm256_min_ps(_mm256_max_ps(a, lo), hi);
+		b = _mm256_min_ps(_mm256_max_ps(b, lo), hi);
+		__m256i r = _mm256_packs_epi32(_mm256_cvtps_epi32(a), _mm256_cvtps_epi32(b));
+		r = _mm256_permute4x64_epi64(r, 0xd8); // packs works within 128-bit lanes
+		_mm256_storeu_si256((__m256i*)(d + i), r);
+	}
+	pcm_f32_i16_c(d + i, s + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static void pcm_i32_f32_avx2(void *dst, const void *src, ffsize n)
+{
+	const int *s = src;
+	float *d = dst;
+	const __m256 k = _mm256_set1_ps((float)(1 / max32f));
+	ffsize i = 0;
+	for (;  i + 8 <= n;  i += 8) {
+		__m256i v = _mm256_loadu_si256((__m256i*)(s + i));
+		_mm256_storeu_ps(d + i, _mm256_mul_ps(_mm256_cvtepi32_ps(v), k));
+	}
+	pcm_i32_f32_c(d + i, s + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static void pcm_f32_i32_avx2(void *dst, const void *src, ffsize n)
+{
+	const float *s = src;
+	int *d = dst;
+	const __m256 k = _mm256_set1_ps(max32f);
+	const __m256i max = _mm256_set1_epi32(0x7fffffff);
+	ffsize i = 0;
+	for (;  i + 8 <= n;  i += 8) {
+		__m256 v = _mm256_mul_ps(_mm256_loadu_ps(s + i), k);
+		// 2^31 - 1 isn't representable as float: values >= 2^31 would overflow to INT_MIN
+		__m256 over = _mm256_cmp_ps(v, k, _CMP_GE_OQ);
+		__m256i r = _mm256_blendv_epi8(_mm256_cvtps_epi32(v), max, _mm256_castps_si256(over));
+		_mm256_storeu_si256((__m256i*)(d + i), r);
+	}
+	pcm_f32_i32_c(d + i, s + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static void pcm_i24_f32_avx2(void *dst, const void *src, ffsize n)
+{
+	const u_char *s = src;
+	float *d = dst;
+	// Move each 3-byte sample to the high bytes of a 32-bit lane; the arithmetic shift extends the sign
+	const __m256i shuf = _mm256_setr_epi8(
+		-1,0,1,2, -1,3,4,5, -1,6,7,8, -1,9,10,11,
+		-1,0,1,2, -1,3,4,5, -1,6,7,8, -1,9,10,11);
+	const __m256 k = _mm256_set1_ps((float)(1 / max24f));
+	ffsize i = 0;
+	for (;  i + 10 <= n;  i += 8) { // the second load reads 4 bytes past the 8th sample
+		__m256i v = _mm256_inserti128_si256(
+			_mm256_castsi128_si256(_mm_loadu_si128((__m128i*)(s + i * 3)))
+			, _mm_loadu_si128((__m128i*)(s + i * 3 + 12)), 1);
+		v = _mm256_srai_epi32(_mm256_shuffle_epi8(v, shuf), 8);
+		_mm256_storeu_ps(d + i, _mm256_mul_ps(_mm256_cvtepi32_ps(v), k));
+	}
+	pcm_i24_f32_c(d + i, s + i * 3, n - i);
+}
+
+__attribute__((target("avx2")))
+static void pcm_f32_i24_avx2(void *dst, const void *src, ffsize n)
+{
+	const float *s = src;
+	u_char *d = dst;
+	const __m256 k = _mm256_set1_ps(max24f)
+		, lo = _mm256_set1_ps(-max24f)
+		, hi = _mm256_set1_ps(max24f - 1);
+	const __m256i shuf = _mm256_setr_epi8(
+		0,1,2, 4,5,6, 8,9,10, 12,13,14, -1,-1,-1,-1,
+		0,1,2, 4,5,6, 8,9,10, 12,13,14, -1,-1,-1,-1);
+	ffsize i = 0;
+	for (;  i + 10 <= n;  i += 8) { // the second store writes 4 bytes past the 8th sample
+		__m256 v = _mm256_mul_ps(_mm256_loadu_ps(s + i), k);
+		v = _mm256_min_ps(_mm256_max_ps(v, lo), hi);
+		__m256i r = _mm256_shuffle_epi8(_mm256_cvtps_epi32(v), shuf);
+		_mm_storeu_si128((__m128i*)(d + i * 3), _mm256_castsi256_si128(r));
+		_mm_storeu_si128((__m128i*)(d + i * 3 + 12), _mm256_extracti128_si256(r, 1));
+	}
+	pcm_f32_i24_c(d + i * 3, s + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static void pcm_f64_f32_avx2(void *dst, const void *src, ffsize n)
+{
+	const double *s = src;
+	float *d = dst;
+	ffsize i = 0;
+	for (;  i + 8 <= n;  i += 8) {
+		__m128 a = _mm256_cvtpd_ps(_mm256_loadu_pd(s + i));
+		__m128 b = _mm256_cvtpd_ps(_mm256_loadu_pd(s + i + 4));
+		_mm256_storeu_ps(d + i, _mm256_set_m128(b, a));
+	}
+	pcm_f64_f32_c(d + i, s + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static void pcm_f32_f64_avx2(void *dst, const void *src, ffsize n)
+{
+	const float *s = src;
+	double *d = dst;
+	ffsize i = 0;
+	for (;  i + 8 <= n;  i += 8) {
+		__m256 v = _mm256_loadu_ps(s + i);
+		_mm256_storeu_pd(d + i, _mm256_cvtps_pd(_mm256_castps256_ps128(v)));
+		_mm256_storeu_pd(d + i + 4, _mm256_cvtps_pd(_mm256_extractf128_ps(v, 1)));
+	}
+	pcm_f32_f64_c(d + i, s + i, n - i);
+}
+
+__attribute__((target("avx512f")))
+static void pcm_i16_f32_avx512(void *dst, const void *src, ffsize n)
+{
+	const short *s = src;
+	float *d = dst;
+	const __m512 k = _mm512_set1_ps((float)(1 / max16f));
+	ffsize i = 0;
+	for (;  i + 16 <= n;  i += 16) {
+		__m512i v = _mm512_cvtepi16_epi32(_mm256_loadu_si256((__m256i*)(s + i)));
+		_mm512_storeu_ps(d + i, _mm512_mul_ps(_mm512_cvtepi32_ps(v), k));
+	}
+	pcm_i16_f32_c(d + i, s + i, n - i);
+}
+
+__attribute__((target("avx512f")))
+static void pcm_f32_i16_avx512(void *dst, const void *src, ffsize n)
+{
+	const float *s = src;
+	short *d = dst;
+	const __m512 k = _mm512_set1_ps(max16f)
+		, lo = _mm512_set1_ps(-max16f)
+		, hi = _mm512_set1_ps(max16f - 1);
+	ffsize i = 0;
+	for (;  i + 16 <= n;  i += 16) {
+		__m512 v = _mm512_mul_ps(_mm512_loadu_ps(s + i), k);
+		v = _mm512_min_ps(_mm512_max_ps(v, lo), hi);
+		_mm256_storeu_si256((__m256i*)(d + i), _mm512_cvtsepi32_epi16(_mm512_cvtps_epi32(v)));
+	}
+	pcm_f32_i16_c(d + i, s + i, n - i);
+}
+
+__attribute__((target("avx512f")))
+static void pcm_i32_f32_avx512(void *dst, const void *src, ffsize n)
+{
+	const int *s = src;
+	float *d = dst;
+	const __m512 k = _mm512_set1_ps((float)(1 / max32f));
+	ffsize i = 0;
+	for (;  i + 16 <= n;  i += 16) {
+		__m512i v = _mm512_loadu_si512(s + i);
+		_mm512_storeu_ps(d + i, _mm512_mul_ps(_mm512_cvtepi32_ps(v), k));
+	}
+	pcm_i32_f32_c(d + i, s + i, n - i);
+}
+
+__attribute__((target("avx512f")))
+static void pcm_f32_i32_avx512(void *dst, const void *src, ffsize n)
+{
+	const float *s = src;
+	int *d = dst;
+	const __m512 k = _mm512_set1_ps(max32f);
+	const __m512i max = _mm512_set1_epi32(0x7fffffff);
+	ffsize i = 0;
+	for (;  i + 16 <= n;  i += 16) {
+		__m512 v = _mm512_mul_ps(_mm512_loadu_ps(s + i), k);
+		__mmask16 over = _mm512_cmp_ps_mask(v, k, _CMP_GE_OQ);
+		__m512i r = _mm512_mask_mov_epi32(_mm512_cvtps_epi32(v), over, max);
+		_mm512_storeu_si512(d + i, r);
+	}
+	pcm_f32_i32_c(d + i, s + i, n - i);
+}
+
+#endif // PCM_SIMD_X86
+
+enum PCM_SIMD {
+	PCM_SIMD_I16_F32,
+	PCM_SIMD_F32_I16,
+	PCM_SIMD_I24_F32,
+	PCM_SIMD_F32_I24,
+	PCM_SIMD_I32_F32,
+	PCM_SIMD_F32_I32,
+	PCM_SIMD_F64_F32,
+	PCM_SIMD_F32_F64,
+	PCM_SIMD_N,
+};
+
+enum PCM_SIMD_LEVEL {
+	PCM_SIMD_SCALAR,
+	PCM_SIMD_AVX2,
+	PCM_SIMD_AVX512,
+};
+
+struct pcm_simd {
+	uint level; // enum PCM_SIMD_LEVEL
+	const char *isa;
+	pcm_simd_func funcs[PCM_SIMD_N];
+	pcm_simd_ileave_func ileave, deileave;
+};
+
+static const struct pcm_simd *_pcm_simd;
+
+static const struct pcm_simd pcm_simd_scalar = {
+	PCM_SIMD_SCALAR, "scalar", {
+		pcm_i16_f32_c, pcm_f32_i16_c, pcm_i24_f32_c, pcm_f32_i24_c,
+		pcm_i32_f32_c, pcm_f32_i32_c, pcm_f64_f32_c, pcm_f32_f64_c,
+	},
+	pcm_ileave32_c, pcm_deileave32_c,
+};
+
+#ifdef PCM_SIMD_X86
+static const struct pcm_simd pcm_simd_avx2 = {
+	PCM_SIMD_AVX2, "AVX2", {
+		pcm_i16_f32_avx2, pcm_f32_i16_avx2, pcm_i24_f32_avx2, pcm_f32_i24_avx2,
+		pcm_i32_f32_avx2, pcm_f32_i32_avx2, pcm_f64_f32_avx2, pcm_f32_f64_avx2,
+	},
+	pcm_ileave32_avx2, pcm_deileave32_avx2,
+};
+// AVX-512 CPUs support AVX2: int24 and float64 conversions and (de)interleaving use AVX2 functions
+static const struct pcm_simd pcm_simd_avx512 = {
+	PCM_SIMD_AVX512, "AVX-512", {
+		pcm_i16_f32_avx512, pcm_f32_i16_avx512, pcm_i24_f32_avx2, pcm_f32_i24_avx2,
+		pcm_i32_f32_avx512, pcm_f32_i32_avx512, pcm_f64_f32_avx2, pcm_f32_f64_avx2,
+	},
+	pcm_ileave32_avx2, pcm_deileave32_avx2,
+};
+#endif
+
+/** Select the functions for the current CPU */
+static void pcm_simd_init()
+{
+	const struct pcm_simd *impl = &pcm_simd_scalar;
+
+#ifdef PCM_SIMD_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512f"))
+		impl = &pcm_simd_avx512;
+	else if (__builtin_cpu_supports("avx2"))
+		impl = &pcm_simd_avx2;
+#endif
+
+	FFINT_WRITEONCE(_pcm_simd, impl);
+}
+
+/** Get the conversion function for the specified formats.
+Return NULL if there's no vectorized implementation */
+static inline pcm_simd_func pcm_simd_find(uint ifmt, uint ofmt, const char **isa)
+{
+	if (FFINT_READONCE(_pcm_simd) == NULL)
+		pcm_simd_init();
+
+	int i = -1;
+	switch (ifmt) {
+	case PHI_PCM_16:
+		if (ofmt == PHI_PCM_FLOAT32) i = PCM_SIMD_I16_F32;
+		break;
+	case PHI_PCM_24:
+		if (ofmt == PHI_PCM_FLOAT32) i = PCM_SIMD_I24_F32;
+		break;
+	case PHI_PCM_32:
+		if (ofmt == PHI_PCM_FLOAT32) i = PCM_SIMD_I32_F32;
+		break;
+	case PHI_PCM_FLOAT32:
+		if (ofmt == PHI_PCM_16) i = PCM_SIMD_F32_I16;
+		else if (ofmt == PHI_PCM_24) i = PCM_SIMD_F32_I24;
+		else if (ofmt == PHI_PCM_32) i = PCM_SIMD_F32_I32;
+		else if (ofmt == PHI_PCM_FLOAT64) i = PCM_SIMD_F32_F64;
+		break;
+	case PHI_PCM_FLOAT64:
+		if (ofmt == PHI_PCM_FLOAT32) i = PCM_SIMD_F64_F32;
+		break;
+	}
+	if (i < 0)
+		return NULL;
+
+	*isa = _pcm_simd->isa;
+	return _pcm_simd->funcs[i];
+}
+
+/** Get the function that (de)interleaves the samples of the specified format.
+Return NULL if the format isn't supported */
+static inline pcm_simd_ileave_func pcm_simd_ileave_find(uint fmt, uint interleaved, const char **isa)
+{
+	if (FFINT_READONCE(_pcm_simd) == NULL)
+		pcm_simd_init();
+
+	if (!(fmt == PHI_PCM_FLOAT32 || fmt == PHI_PCM_32))
+		return NULL;
+
+	*isa = _pcm_simd->isa;
+	return (interleaved) ? _pcm_simd->deileave : _pcm_simd->ileave;
+}
+
+/** Get the instruction set level supported by CPU: enum PCM_SIMD_LEVEL */
+static inline uint pcm_simd_level()
+{
+	if (FFINT_READONCE(_pcm_simd) == NULL)
+		pcm_simd_init();
+	return _pcm_simd->level;
+}
@@ -0,0 +1,273 @@
+/** phiola: apply gain and collect per-channel statistics in a single pass
+2026, Simon Zolin */
+
+/* Supported formats: int16, int24, int32, float32, float64; interleaved and non-interleaved.
+A value is counted as clipped if its normalized magnitude (after gain) is >= 1.0.
+Integer samples are saturated when the gain is applied. */
+
+#pragma once
+#include <afilter/pcm.h>
+#include <afilter/pcm-simd.h>
+
+struct pcm_stat_ch {
+	double max; // max. absolute value (normalized)
+	double sumsq; // sum of squares (normalized)
+	uint64 clipped;
+};
+
+struct pcm_stat {
+	uint64 samples;
+	struct pcm_stat_ch ch[8];
+};
+
+static inline void _pcm_stat_add(struct pcm_stat_ch *c, double v)
+{
+	double a = fabs(v);
+	if (a >= 1)
+		c->clipped++;
+	if (c->max < a)
+		c->max = a;
+	c->sumsq += v * v;
+}
+
+#ifdef PCM_SIMD_X86
+
+/** Per-lane results of a vectorized loop */
+struct _pcm_stat_lanes {
+	float max[8];
+	double sumsq[8];
+	uint clipped[8];
+};
+
+/* v: normalized values after gain */
+#define _PCM_STAT_AVX2_ACC(v) \
+do { \
+	__m256 a = _mm256_andnot_ps(sign, v); \
+	max = _mm256_max_ps(max, a); \
+	clip = _mm256_sub_epi32(clip, _mm256_castps_si256(_mm256_cmp_ps(a, one, _CMP_GE_OQ))); \
+	__m256d lo = _mm256_cvtps_pd(_mm256_castps256_ps128(v)); \
+	__m256d hi = _mm256_cvtps_pd(_mm256_extractf128_ps(v, 1)); \
+	sq_lo = _mm256_add_pd(sq_lo, _mm256_mul_pd(lo, lo)); \
+	sq_hi = _mm256_add_pd(sq_hi, _mm256_mul_pd(hi, hi)); \
+} while (0)
+
+#define _PCM_STAT_AVX2_VARS \
+	const __m256 sign = _mm256_set1_ps(-0.0f), one = _mm256_set1_ps(1); \
+	__m256 max = _mm256_setzero_ps(); \
+	__m256d sq_lo = _mm256_setzero_pd(), sq_hi = _mm256_setzero_pd(); \
+	__m256i clip = _mm256_setzero_si256()
+
+#define _PCM_STAT_AVX2_STORE(l) \
+do { \
+	_mm256_storeu_ps((l)->max, max); \
+	_mm256_storeu_pd((l)->sumsq, sq_lo); \
+	_mm256_storeu_pd((l)->sumsq + 4, sq_hi); \
+	_mm256_storeu_si256((__m256i*)(l)->clipped, clip); \
+} while (0)
+
+/** Process 'n' float32 values; the tail (n % 8) is left for the caller.
+Return the number of processed values */
+__attribute__((target("avx2")))
+static ffsize _pcm_stat_f32_avx2(float *d, ffsize n, float gain, struct _pcm_stat_lanes *l)
+{
+	_PCM_STAT_AVX2_VARS;
+	const __m256 g = _mm256_set1_ps(gain);
+	ffsize i = 0;
+	for (;  i + 8 <= n;  i += 8) {
+		__m256 v = _mm256_loadu_ps(d + i);
+		if (gain != 1) {
+			v = _mm256_mul_ps(v, g);
+			_mm256_storeu_ps(d + i, v);
+		}
+		_PCM_STAT_AVX2_ACC(v);
+	}
+	_PCM_STAT_AVX2_STORE(l);
+	return i;
+}
+
+__attribute__((target("avx2")))
+static ffsize _pcm_stat_i16_avx2(short *d, ffsize n, float gain, struct _pcm_stat_lanes *l)
+{
+	_PCM_STAT_AVX2_VARS;
+	const __m256 g = _mm256_set1_ps(gain * (float)(1 / max16f))
+		, k = _mm256_set1_ps(max16f)
+		, lo = _mm256_set1_ps(-max16f)
+		, hi = _mm256_set1_ps(max16f - 1);
+	ffsize i = 0;
+	for (;  i + 8 <= n;  i += 8) {
+		__m256i s = _mm256_cvtepi16_epi32(_mm_loadu_si128((__m128i*)(d + i)));
+		__m256 v = _mm256_mul_ps(_mm256_cvtepi32_ps(s), g);
+		if (gain != 1) {
+			__m256 o = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(v, k), lo), hi);
+			s = _mm256_cvtps_epi32(o);
+			s = _mm256_permute4x64_epi64(_mm256_packs_epi32(s, s), 0xd8);
+			_mm_storeu_si128((__m128i*)(d + i), _mm256_castsi256_si128(s));
+		}
+		_PCM_STAT_AVX2_ACC(v);
+	}
+	_PCM_STAT_AVX2_STORE(l);
+	return i;
+}
+
+#undef _PCM_STAT_AVX2_ACC
+#undef _PCM_STAT_AVX2_VARS
+#undef _PCM_STAT_AVX2_STORE
+
+/** Merge per-lane results: lane #i belongs to channel #(i % nch) */
+static inline void _pcm_stat_lanes_add(struct pcm_stat_ch *ch, uint nch, const struct _pcm_stat_lanes *l)
+{
+	for (uint i = 0;  i < 8;  i++) {
+		struct pcm_stat_ch *c = &ch[i % nch];
+		if (c->max < l->max[i])
+			c->max = l->max[i];
+		c->sumsq += l->sumsq[i];
+		c->clipped += l->clipped[i];
+	}
+}
+
+/** Use AVX2 for float32 and int16.
+Interleaved data: the number of channels must divide the vector width.
+Return the number of samples processed */
+static inline ffsize _pcm_gain_stat_avx2(const struct phi_af *fmt, double gain, union pcmdata d, ffsize samples, struct pcm_stat *st)
+{
+	if (!((fmt->format == PHI_PCM_FLOAT32 || fmt->format == PHI_PCM_16)
+		&& pcm_simd_level() >= PCM_SIMD_AVX2))
+		return 0;
+
+	uint nch = fmt->channels;
+	struct _pcm_stat_lanes l;
+	ffsize n, done = samples;
+
+	if (fmt->interleaved) {
+		if (8 % nch)
+			return 0;
+		if (fmt->format == PHI_PCM_FLOAT32)
+			n = _pcm_stat_f32_avx2(d.f, samples * nch, gain, &l);
+		else
+			n = _pcm_stat_i16_avx2(d.sh, samples * nch, gain, &l);
+		_pcm_stat_lanes_add(st->ch, nch, &l);
+		return n / nch;
+	}
+
+	for (uint ich = 0;  ich < nch;  ich++) {
+		if (fmt->format == PHI_PCM_FLOAT32)
+			n = _pcm_stat_f32_avx2(d.pf[ich], samples, gain, &l);
+		else
+			n = _pcm_stat_i16_avx2(d.psh[ich], samples, gain, &l);
+		_pcm_stat_lanes_add(&st->ch[ich], 1, &l);
+		done = ffmin(done, n);
+	}
+	return done;
+}
+
+#endif // PCM_SIMD_X86
+
+/** Apply gain (in-place) and update statistics.
+gain: 1: don't modify data
+st: (optional) statistics
+Return 0 on success;
+  1: format isn't supported */
+static inline int pcm_gain_stat(const struct phi_af *fmt, double gain, void *data, ffsize samples, struct pcm_stat *st)
+{
+	struct pcm_stat tmp;
+	uint nch = fmt->channels, step = 1;
+	ffsize i, off = 0;
+	void *ni[8];
+	union pcmdata d;
+	d.b = data;
+
+	switch (fmt->format) {
+	case PHI_PCM_16:
+	case PHI_PCM_24:
+	case PHI_PCM_32:
+	case PHI_PCM_FLOAT32:
+	case PHI_PCM_FLOAT64:
+		break;
+	default:
+		return 1;
+	}
+	if (nch > 8)
+		return 1;
+	if (data == NULL)
+		return 0;
+
+	if (st == NULL) {
+		ffmem_zero_obj(&tmp);
+		st = &tmp;
+	}
+	st->samples += samples;
+
+#ifdef PCM_SIMD_X86
+	off = _pcm_gain_stat_avx2(fmt, gain, d, samples, st);
+	if (off == samples)
+		return 0;
+#endif
+
+	if (fmt->interleaved) {
+		d.pb = pcm_setni(ni, d.b, fmt->format, nch);
+		step = nch;
+	}
+
+	for (uint ich = 0;  ich != nch;  ich++) {
+		struct pcm_stat_ch *c = &st->ch[ich];
+
+		switch (fmt->format) {
+		case PHI_PCM_16:
+			for (i = off;  i != samples;  i++) {
+				double v = pcm_16le_flt(d.psh[ich][i * step]) * gain;
+				if (gain != 1)
+					d.psh[ich][i * step] = pcm_flt_16le(v);
+				_pcm_stat_add(c, v);
+			}
+			break;
+
+		case PHI_PCM_24:
+			for (i = off;  i != samples;  i++) {
+				double v = pcm_24_flt(int_ltoh24s(&d.pb[ich][i * step * 3])) * gain;
+				if (gain != 1)
+					int_htol24(&d.pb[ich][i * step * 3], pcm_flt_24(v));
+				_pcm_stat_add(c, v);
+			}
+			break;
+
+		case PHI_PCM_32:
+			for (i = off;  i != samples;  i++) {
+				double v = pcm_32_flt(d.pin[ich][i * step]) * gain;
+				if (gain != 1)
+					d.pin[ich][i * step] = pcm_flt_32(v);
+				_pcm_stat_add(c, v);
+			}
+			break;
+
+		case PHI_PCM_FLOAT32:
+			for (i = off;  i != samples;  i++) {
+				float v = d.pf[ich][i * step] * (float)gain;
+				if (gain != 1)
+					d.pf[ich][i * step] = v;
+				_pcm_stat_add(c, v);
+			}
+			break;
+
+		case PHI_PCM_FLOAT64:
+			for (i = off;  i != samples;  i++) {
+				double v = d.pd[ich][i * step] * gain;
+				if (gain != 1)
+					d.pd[ich][i * step] = v;
+				_pcm_stat_add(c, v);
+			}
+			break;
+		}
+	}
+	return 0;
+}
+
+/** Get the highest peak among all channels */
+static inline double pcm_stat_maxpeak(const struct pcm_stat *st, uint channels)
+{
+	double max = 0;
+	for (uint i = 0;  i < channels;  i++) {
+		if (max < st->ch[i].max)
+			max = st->ch[i].max;
+	}
+	return max;
+}
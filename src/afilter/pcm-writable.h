@@ -0,0 +1,53 @@
+/** phiola: afilter: writable input data for in-place filters
+2026, Simon Zolin */
+
+/* A filter modifies 'data_in' in-place only if PHI_FWRITABLE is set.
+Otherwise (e.g. memory-mapped file data) the input is copied to the filter's buffer
+ which then becomes the filter's own output (PHI_FOWN_OUTPUT). */
+
+#pragma once
+#include <track.h>
+
+struct pcm_wbuf {
+	void *buf;
+	ffsize cap;
+	void *ptrs[8]; // non-interleaved data: pointers to the channels within 'buf'
+};
+
+/** Make 'data_in' writable: copy it to the filter's buffer if necessary.
+Return 0 on success */
+static inline int pcm_wbuf_get(struct pcm_wbuf *w, phi_track *t, const struct phi_af *af)
+{
+	if ((t->chain_flags & PHI_FWRITABLE) || t->data_in.len == 0)
+		return 0;
+
+	ffsize n = t->data_in.len;
+	if (w->cap < n) {
+		phi_track_buf_free(t, w->buf);
+		w->cap = 0;
+		if (NULL == (w->buf = phi_track_buf_alloc(t, n)))
+			return -1;
+		w->cap = n;
+	}
+
+	if (af->interleaved) {
+		ffmem_copy(w->buf, t->data_in.ptr, n);
+		t->data_in.ptr = w->buf;
+	} else {
+		ffsize channel_len = n / af->channels;
+		for (uint i = 0;  i < af->channels;  i++) {
+			w->ptrs[i] = (char*)w->buf + channel_len * i;
+			ffmem_copy(w->ptrs[i], ((void**)t->data_in.ptr)[i], channel_len);
+		}
+		t->data_in.ptr = (void*)w->ptrs;
+	}
+	t->chain_flags |= PHI_FOWN_OUTPUT;
+	return 0;
+}
+
+static inline void pcm_wbuf_free(struct pcm_wbuf *w, phi_track *t)
+{
+	phi_track_buf_free(t, w->buf);
+	w->buf = NULL;
+	w->cap = 0;
+}
@@ -2,33 +2,29 @@
 2019, Simon Zolin */
 
 #include <track.h>
-#include <afilter/pcm.h>
+#include <afilter/pcm-stat.h>
 
 extern const phi_core *core;
 #define errlog(t, ...)  phi_errlog(core, NULL, t, __VA_ARGS__)
 #define userlog(t, ...)  phi_userlog(core, NULL, t, __VA_ARGS__)
 
 struct peaks {
-	uint channels;
-	uint64 total;
-
-	struct {
-		double max;
-		uint64 clipped;
-	} ch[8];
+	struct phi_af fmt;
+	uint sample_size;
+	struct pcm_stat st;
 };
 
 static void* peaks_open(phi_track *t)
 {
-	if (!(t->oaudio.format.interleaved
-		&& t->oaudio.format.format == PHI_PCM_FLOAT64
-		&& t->oaudio.format.channels <= 8)) {
+	const struct phi_af *af = (t->oaudio.format.format) ? &t->oaudio.format : &t->audio.format;
+	if (pcm_gain_stat(af, 1, NULL, 0, NULL)) {
 		errlog(t, "invalid input format");
 		return PHI_OPEN_ERR;
 	}
 
 	struct peaks *p = phi_track_allocT(t, struct peaks);
-	p->channels = t->oaudio.format.channels;
+	p->fmt = *af;
+	p->sample_size = pcm_size1(af);
 	return p;
 }
 
@@ -39,38 +35,22 @@ static void peaks_close(struct peaks *p, phi_track *t)
 
 static int peaks_process(struct peaks *p, phi_track *t)
 {
-	ffsize i, c, samples;
-
-	samples = t->data_in.len / 8 / p->channels;
-	p->total += samples;
-
-	const double *data = (void*)t->data_in.ptr;
-	for (c = 0;  c != p->channels;  c++) {
-		for (i = 0;  i != samples;  i++) {
-			double d = data[i * p->channels + c];
-
-			if (d >= 1 || d <= -1)
-				p->ch[c].clipped++;
-
-			d = fabs(d);
-			if (p->ch[c].max < d)
-				p->ch[c].max = d;
-		}
-	}
+	pcm_gain_stat(&p->fmt, 1, (void*)t->data_in.ptr, t->data_in.len / p->sample_size, &p->st);
 
 	t->data_out = t->data_in;
 
 	if (t->chain_flags & PHI_FFIRST) {
 		ffvec buf = {};
 		ffvec_addfmt(&buf, "\nPCM peaks (%,U total samples):\n"
-			, p->total);
-
-		if (p->total != 0) {
-			for (c = 0;  c != p->channels;  c++) {
-
-				double hi = gain_db(p->ch[c].max);
-				ffvec_addfmt(&buf, "Channel #%L: max peak: %.2FdB  Clipped: %U\n"
-					, c + 1, hi, p->ch[c].clipped);
+			, p->st.samples);
+
+		if (p->st.samples != 0) {
+			for (uint c = 0;  c != p->fmt.channels;  c++) {
+				const struct pcm_stat_ch *ch = &p->st.ch[c];
+				double hi = gain_db(ch->max);
+				double rms = gain_db(sqrt(ch->sumsq / p->st.samples));
+				ffvec_addfmt(&buf, "Channel #%u: max peak: %.2FdB  RMS: %.2FdB  Clipped: %U\n"
+					, c + 1, hi, rms, ch->clipped);
 			}
 		}
 
@@ -83,5 +63,6 @@ static int peaks_process(struct peaks *p, phi_track *t)
 
 const phi_filter phi_peaks = {
 	peaks_open, (void*)peaks_close, (void*)peaks_process,
-	"peaks"
+	"peaks",
+	PHI_FILTER_INPLACE
 };
@@ -0,0 +1,380 @@
+/** phiola: polyphase sample rate converter for fixed ratios
+2026, Simon Zolin */
+
+/* Output rate / input rate = L / M (reduced fraction).
+The prototype low-pass filter (windowed sinc, Kaiser window) has L*T coefficients
+ and is split into L phases of T coefficients.
+The last coefficient is 0: the filter length is odd (L*T - 1) and it's symmetric around
+ the coefficient #D = (L*T - 2) / 2, so the filter delay is exactly D (linear phase).
+Output sample #k is the dot product of phase ((k*M + D) % L)
+ with the T input samples ending at ((k*M + D) / L),
+ so the output isn't delayed relative to the input.
+The coefficients of each phase are stored in reverse order:
+ the dot product is calculated over contiguous memory (AVX2).
+The tables are built once for each (L, M, quality) and shared by all converters. */
+
+#pragma once
+#include <afilter/pcm-simd.h>
+#include <ffbase/lock.h>
+#include <ffbase/vector.h>
+#include <math.h>
+
+enum POLYPHASE_Q {
+	POLYPHASE_FAST, // 16 taps
+	POLYPHASE_MEDIUM, // 32 taps
+	POLYPHASE_HIGH, // 64 taps
+};
+
+struct polyphase_table {
+	uint L, M, quality;
+	uint taps; // per phase; multiple of 8
+	float *coef; // [L][taps]
+};
+
+static struct {
+	fflock lock;
+	ffvec tables; // struct polyphase_table*[]: up to 30 rate pairs * 3 qualities
+} _polyphase;
+
+static inline uint _polyphase_gcd(uint a, uint b)
+{
+	while (b) {
+		uint r = a % b;
+		a = b;
+		b = r;
+	}
+	return a;
+}
+
+/** Return 1 if the rate pair is supported */
+static inline int polyphase_supported(uint irate, uint orate)
+{
+	static const uint rates[] = { 44100, 48000, 88200, 96000, 176400, 192000 };
+	uint n = 0;
+	for (uint i = 0;  i < FF_COUNT(rates);  i++) {
+		if (irate == rates[i])
+			n++;
+		if (orate == rates[i])
+			n++;
+	}
+	return (n == 2 && irate != orate);
+}
+
+/** Modified Bessel function of the first kind, order 0 */
+static inline double _polyphase_i0(double x)
+{
+	double sum = 1, term = 1;
+	for (uint k = 1;  k < 50;  k++) {
+		term *= (x / (2 * k)) * (x / (2 * k));
+		sum += term;
+		if (term < sum * 1e-12)
+			break;
+	}
+	return sum;
+}
+
+static struct polyphase_table* _polyphase_build(uint L, uint M, uint quality)
+{
+	static const struct {
+		u_char taps;
+		float rolloff; // pass band / Nyquist frequency
+		float beta; // Kaiser window
+	} q[] = {
+		{ 16, 0.85, 6 },
+		{ 32, 0.91, 8 },
+		{ 64, 0.945, 10 },
+	};
+
+	struct polyphase_table *pt = ffmem_new(struct polyphase_table);
+	if (pt == NULL)
+		return NULL;
+	pt->L = L;
+	pt->M = M;
+	pt->quality = quality;
+
+	// decimation: the filter is longer by M/L to keep the same transition band
+	uint taps = q[quality].taps;
+	if (M > L)
+		taps = (taps * M + L - 1) / L;
+	taps = ffint_align_ceil2(taps, 8);
+	pt->taps = taps;
+
+	// cut-off frequency relative to the input sample rate
+	double fc = 0.5 * q[quality].rolloff * ((M > L) ? (double)L / M : 1);
+	uint n = L * taps - 1;
+	double center = (n - 1) / 2.0, beta = q[quality].beta;
+
+	double i0b = _polyphase_i0(beta);
+	if (NULL == (pt->coef = ffmem_alloc(L * taps * sizeof(float)))) {
+		ffmem_free(pt);
+		return NULL;
+	}
+
+	for (uint p = 0;  p < L;  p++) {
+		float *c = pt->coef + p * taps;
+		double sum = 0;
+		for (uint j = 0;  j < taps;  j++) {
+			uint i = p + j * L; // index in the prototype filter
+			if (i == n) {
+				c[taps - 1 - j] = 0;
+				continue;
+			}
+			double x = (i - center) / L; // input samples
+			double s = (x == 0) ? 2 * fc : sin(2 * M_PI * fc * x) / (M_PI * x);
+			double w = (i - center) / center;
+			double h = s * _polyphase_i0(beta * sqrt(1 - w * w)) / i0b;
+			c[taps - 1 - j] = h;
+			sum += h;
+		}
+		for (uint j = 0;  j < taps;  j++) {
+			c[j] /= sum; // unity gain at DC for each phase
+		}
+	}
+	return pt;
+}
+
+/** Get the table for the specified rates (build it if necessary) */
+static inline const struct polyphase_table* polyphase_table(uint irate, uint orate, uint quality)
+{
+	uint g = _polyphase_gcd(irate, orate);
+	uint L = orate / g, M = irate / g;
+	quality = ffmin(quality, POLYPHASE_HIGH);
+	struct polyphase_table *pt = NULL;
+
+	fflock_lock(&_polyphase.lock);
+	struct polyphase_table **it;
+	FFSLICE_WALK(&_polyphase.tables, it) {
+		if ((*it)->L == L && (*it)->M == M && (*it)->quality == quality) {
+			pt = *it;
+			goto end;
+		}
+	}
+	if (NULL == (it = ffvec_pushT(&_polyphase.tables, struct polyphase_table*)))
+		goto end;
+	if (NULL == (pt = _polyphase_build(L, M, quality))) {
+		_polyphase.tables.len--;
+		goto end;
+	}
+	*it = pt;
+
+end:
+	fflock_unlock(&_polyphase.lock);
+	return pt;
+}
+
+static inline void polyphase_tables_free()
+{
+	struct polyphase_table **it;
+	FFSLICE_WALK(&_polyphase.tables, it) {
+		ffmem_free((*it)->coef);
+		ffmem_free(*it);
+	}
+	ffvec_free(&_polyphase.tables);
+}
+
+static float _polyphase_dot_c(const float *c, const float *x, uint n)
+{
+	float s[8] = {};
+	for (uint i = 0;  i < n;  i += 8) {
+		for (uint j = 0;  j < 8;  j++) {
+			s[j] += c[i + j] * x[i + j];
+		}
+	}
+	return ((s[0] + s[4]) + (s[1] + s[5])) + ((s[2] + s[6]) + (s[3] + s[7]));
+}
+
+#ifdef PCM_SIMD_X86
+
+/** Produce 'n' output samples of one channel */
+__attribute__((target("avx2")))
+static void _polyphase_run_avx2(const struct polyphase_table *pt, const float *x, float *out, ffsize out_step, ffsize n, uint64 m, uint p, uint64 base)
+{
+	uint taps = pt->taps, L = pt->L, M = pt->M;
+	for (ffsize k = 0;  k < n;  k++) {
+		const float *c = pt->coef + p * taps;
+		const float *w = x + (m - base) - (taps - 1);
+		__m256 a0 = _mm256_setzero_ps(), a1 = _mm256_setzero_ps();
+		uint i = 0;
+		for (;  i + 16 <= taps;  i += 16) {
+			a0 = _mm256_add_ps(a0, _mm256_mul_ps(_mm256_loadu_ps(c + i), _mm256_loadu_ps(w + i)));
+			a1 = _mm256_add_ps(a1, _mm256_mul_ps(_mm256_loadu_ps(c + i + 8), _mm256_loadu_ps(w + i + 8)));
+		}
+		if (i < taps)
+			a0 = _mm256_add_ps(a0, _mm256_mul_ps(_mm256_loadu_ps(c + i), _mm256_loadu_ps(w + i)));
+		a0 = _mm256_add_ps(a0, a1);
+		__m128 s = _mm_add_ps(_mm256_castps256_ps128(a0), _mm256_extractf128_ps(a0, 1));
+		s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+		s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+		out[k * out_step] = _mm_cvtss_f32(s);
+
+		p += M;
+		m += p / L;
+		p %= L;
+	}
+}
+
+#endif
+
+static void _polyphase_run_c(const struct polyphase_table *pt, const float *x, float *out, ffsize out_step, ffsize n, uint64 m, uint p, uint64 base)
+{
+	uint taps = pt->taps, L = pt->L, M = pt->M;
+	for (ffsize k = 0;  k < n;  k++) {
+		out[k * out_step] = _polyphase_dot_c(pt->coef + p * taps, x + (m - base) - (taps - 1), taps);
+		p += M;
+		m += p / L;
+		p %= L;
+	}
+}
+
+struct polyphase {
+	const struct polyphase_table *pt;
+	uint channels;
+	void (*run)(const struct polyphase_table *pt, const float *x, float *out, ffsize out_step, ffsize n, uint64 m, uint p, uint64 base);
+
+	/* Input samples of each channel: x[base .. base + len).
+	Stream position 0 is at index (taps - 1): the preceding samples are zeros. */
+	float *x[8];
+	ffsize len, cap;
+	uint64 base;
+
+	uint64 m; // index of the last input sample for the next output sample
+	uint p; // phase for the next output sample
+	uint64 in_total, out_total;
+};
+
+/** Drop the input history and start a new stream (e.g. after seeking) */
+static inline void polyphase_reset(struct polyphase *ps)
+{
+	uint taps = ps->pt->taps, L = ps->pt->L;
+	ps->len = taps - 1;
+	ps->base = 0;
+	for (uint i = 0;  i < ps->channels;  i++) {
+		ffmem_zero(ps->x[i], ps->len * sizeof(float));
+	}
+
+	// filter delay in the upsampled domain
+	uint64 d = ((uint64)L * taps - 2) / 2;
+	ps->m = (taps - 1) + d / L;
+	ps->p = d % L;
+	ps->in_total = ps->out_total = 0;
+}
+
+/**
+Return 0 on success */
+static inline int polyphase_init(struct polyphase *ps, uint channels, uint irate, uint orate, uint quality)
+{
+	ffmem_zero_obj(ps);
+	if (channels > 8 || !polyphase_supported(irate, orate))
+		return -1;
+	if (!(ps->pt = polyphase_table(irate, orate, quality)))
+		return -1;
+	ps->channels = channels;
+
+	ps->run = _polyphase_run_c;
+#ifdef PCM_SIMD_X86
+	if (pcm_simd_level() >= PCM_SIMD_AVX2)
+		ps->run = _polyphase_run_avx2;
+#endif
+
+	ps->cap = 4096;
+	for (uint i = 0;  i < channels;  i++) {
+		ps->x[i] = ffmem_alloc(ps->cap * sizeof(float));
+	}
+	polyphase_reset(ps);
+	return 0;
+}
+
+static inline void polyphase_close(struct polyphase *ps)
+{
+	for (uint i = 0;  i < ps->channels;  i++) {
+		ffmem_free(ps->x[i]);
+	}
+}
+
+/** Get the max. number of output samples for 'n' more input samples */
+static inline ffsize polyphase_out_max(const struct polyphase *ps, ffsize n)
+{
+	return (ffsize)((uint64)n * ps->pt->L / ps->pt->M) + 2;
+}
+
+/** Add float32 input samples.
+data: interleaved: float[]; non-interleaved: float*[]
+n: 0: end of input (the remaining output is flushed) */
+static inline void polyphase_input(struct polyphase *ps, const void *data, int interleaved, ffsize n)
+{
+	uint taps = ps->pt->taps;
+	if (n == 0) {
+		// enough zeros to get the rest of the output;
+		//  polyphase_output() won't produce more than (input * L / M) samples
+		n = taps;
+		data = NULL;
+	} else {
+		ps->in_total += n;
+	}
+
+	// drop the samples that aren't needed anymore
+	uint64 keep_from = ps->m - (taps - 1);
+	if (keep_from > ps->base) {
+		ffsize drop = ffmin(keep_from - ps->base, ps->len);
+		for (uint c = 0;  c < ps->channels;  c++) {
+			ffmem_move(ps->x[c], ps->x[c] + drop, (ps->len - drop) * sizeof(float));
+		}
+		ps->len -= drop;
+		ps->base += drop;
+	}
+
+	if (ps->len + n > ps->cap) {
+		ps->cap = ffmax(ps->len + n, ps->cap * 2);
+		for (uint c = 0;  c < ps->channels;  c++) {
+			ps->x[c] = ffmem_realloc(ps->x[c], ps->cap * sizeof(float));
+		}
+	}
+
+	for (uint c = 0;  c < ps->channels;  c++) {
+		float *d = ps->x[c] + ps->len;
+		if (data == NULL) {
+			ffmem_zero(d, n * sizeof(float));
+		} else if (interleaved) {
+			const float *s = (float*)data + c;
+			for (ffsize i = 0;  i < n;  i++) {
+				d[i] = s[i * ps->channels];
+			}
+		} else {
+			ffmem_copy(d, ((float**)data)[c], n * sizeof(float));
+		}
+	}
+	ps->len += n;
+}
+
+/** Produce output samples.
+out: interleaved: float[]; non-interleaved: float*[]
+Return the number of output samples */
+static inline ffsize polyphase_output(struct polyphase *ps, void *out, int interleaved, ffsize cap)
+{
+	const struct polyphase_table *pt = ps->pt;
+	uint64 end = ps->base + ps->len; // the first sample that isn't available
+
+	// the number of output samples that can be produced with the available input:
+	//  m + (k * M + p) / L < end
+	ffsize n = 0;
+	if (ps->m < end)
+		n = ((end - ps->m) * pt->L - ps->p + pt->M - 1) / pt->M;
+	uint64 out_max = (ps->in_total * pt->L + pt->M - 1) / pt->M;
+	n = ffmin(n, out_max - ps->out_total);
+	n = ffmin(n, cap);
+	if (n == 0)
+		return 0;
+
+	for (uint c = 0;  c < ps->channels;  c++) {
+		if (interleaved)
+			ps->run(pt, ps->x[c], (float*)out + c, ps->channels, n, ps->m, ps->p, ps->base);
+		else
+			ps->run(pt, ps->x[c], ((float**)out)[c], 1, n, ps->m, ps->p, ps->base);
+	}
+
+	uint64 q = (uint64)n * pt->M + ps->p;
+	ps->m += q / pt->L;
+	ps->p = q % pt->L;
+	ps->out_total += n;
+	return n;
+}
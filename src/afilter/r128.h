@@ -0,0 +1,256 @@
+/** phiola: EBU R128 integrated loudness
+2026, Simon Zolin */
+
+/* ITU-R BS.1770-4:
+. K-weighting: high-shelf + high-pass biquad filters per channel
+. Mean square of the weighted sum of channels is calculated for each 400ms block (75% overlap)
+. Integrated loudness: mean of blocks above the absolute (-70 LUFS) and the relative (-10 LU) gates
+
+The energies of all blocks are stored,
+ so the results of several analyzers can be merged exactly (e.g. for album loudness). */
+
+#pragma once
+#include <afilter/pcm.h>
+#include <ffbase/vector.h>
+
+#define R128_ABS_GATE  (-70.0)
+#define R128_REL_GATE  (-10.0)
+
+struct r128_biquad {
+	double b0, b1, b2, a1, a2;
+};
+
+struct r128 {
+	uint channels;
+	uint sub_samples; // samples in 100ms
+	uint sub_pos;
+	uint sub_n; // number of complete 100ms sub-blocks
+	double sub_e[4]; // energies of the last 4 sub-blocks
+	double weight[8];
+	struct r128_biquad shelf, hpass;
+	double z[8][4]; // filter state for each channel
+	double peak; // max. absolute sample value
+
+	ffvec blocks; // double[]: mean square of each 400ms block
+};
+
+static inline double r128_lufs(double e)
+{
+	return -0.691 + 10 * log10(e);
+}
+
+static inline double r128_energy(double lufs)
+{
+	return pow(10, (lufs + 0.691) / 10);
+}
+
+static inline void r128_init(struct r128 *r, uint channels, uint rate)
+{
+	ffmem_zero_obj(r);
+	r->channels = ffmin(channels, 8);
+	r->sub_samples = (rate + 5) / 10;
+
+	for (uint i = 0;  i < r->channels;  i++) {
+		r->weight[i] = 1;
+	}
+	if (channels == 6 || channels == 8) {
+		// L R C LFE Ls Rs [Lb Rb]
+		r->weight[3] = 0;
+		for (uint i = 4;  i < r->channels;  i++) {
+			r->weight[i] = 1.41;
+		}
+	}
+
+	double f0 = 1681.974450955533
+		, g = 3.999843853973347
+		, q = 0.7071752369554196;
+	double k = tan(M_PI * f0 / rate);
+	double vh = pow(10, g / 20);
+	double vb = pow(vh, 0.4996667741545416);
+	double a0 = 1 + k / q + k * k;
+	r->shelf.b0 = (vh + vb * k / q + k * k) / a0;
+	r->shelf.b1 = 2 * (k * k - vh) / a0;
+	r->shelf.b2 = (vh - vb * k / q + k * k) / a0;
+	r->shelf.a1 = 2 * (k * k - 1) / a0;
+	r->shelf.a2 = (1 - k / q + k * k) / a0;
+
+	f0 = 38.13547087602444;
+	q = 0.5003270373238773;
+	k = tan(M_PI * f0 / rate);
+	a0 = 1 + k / q + k * k;
+	r->hpass.b0 = 1;
+	r->hpass.b1 = -2;
+	r->hpass.b2 = 1;
+	r->hpass.a1 = 2 * (k * k - 1) / a0;
+	r->hpass.a2 = (1 - k / q + k * k) / a0;
+}
+
+static inline void r128_close(struct r128 *r)
+{
+	ffvec_free(&r->blocks);
+}
+
+/** Direct form II transposed */
+static inline double _r128_biquad(const struct r128_biquad *f, double *z, double x)
+{
+	double y = f->b0 * x + z[0];
+	z[0] = f->b1 * x - f->a1 * y + z[1];
+	z[1] = f->b2 * x - f->a2 * y;
+	return y;
+}
+
+/** Convert samples [i..i+n) of one channel to float64 */
+static inline void _r128_load(double *dst, const struct phi_af *fmt, union pcmdata d, uint ich, ffsize i, ffsize n)
+{
+	ffsize step = 1, k;
+	if (fmt->interleaved) {
+		step = fmt->channels;
+		i = i * step + ich;
+	}
+
+	switch (fmt->format) {
+	case PHI_PCM_16: {
+		const short *s = (fmt->interleaved) ? d.sh + i : d.psh[ich] + i;
+		for (k = 0;  k < n;  k++) {
+			dst[k] = pcm_16le_flt(s[k * step]);
+		}
+		break;
+	}
+	case PHI_PCM_24: {
+		const char *s = (fmt->interleaved) ? d.b + i * 3 : d.pb[ich] + i * 3;
+		for (k = 0;  k < n;  k++) {
+			dst[k] = pcm_24_flt(int_ltoh24s(&s[k * step * 3]));
+		}
+		break;
+	}
+	case PHI_PCM_32: {
+		const int *s = (fmt->interleaved) ? d.in + i : d.pin[ich] + i;
+		for (k = 0;  k < n;  k++) {
+			dst[k] = pcm_32_flt(s[k * step]);
+		}
+		break;
+	}
+	case PHI_PCM_FLOAT32: {
+		const float *s = (fmt->interleaved) ? d.f + i : d.pf[ich] + i;
+		for (k = 0;  k < n;  k++) {
+			dst[k] = s[k * step];
+		}
+		break;
+	}
+	case PHI_PCM_FLOAT64: {
+		const double *s = (fmt->interleaved) ? d.d + i : d.pd[ich] + i;
+		for (k = 0;  k < n;  k++) {
+			dst[k] = s[k * step];
+		}
+		break;
+	}
+	}
+}
+
+/** Return 1 if the format is supported */
+static inline int r128_format_supported(const struct phi_af *fmt)
+{
+	switch (fmt->format) {
+	case PHI_PCM_16:
+	case PHI_PCM_24:
+	case PHI_PCM_32:
+	case PHI_PCM_FLOAT32:
+	case PHI_PCM_FLOAT64:
+		return (fmt->channels <= 8);
+	}
+	return 0;
+}
+
+/** Process PCM samples (interleaved or non-interleaved) */
+static inline void r128_process(struct r128 *r, const struct phi_af *fmt, const void *data, ffsize samples)
+{
+	union pcmdata d;
+	d.b = (char*)data;
+
+	for (ffsize i = 0;  i < samples;  ) {
+		ffsize n = ffmin(samples - i, r->sub_samples - r->sub_pos);
+
+		double e = 0;
+		for (uint ich = 0;  ich < r->channels;  ich++) {
+			double *z = r->z[ich], sum = 0, buf[256];
+			for (ffsize j = i;  j < i + n;  ) {
+				ffsize k, nb = ffmin(i + n - j, FF_COUNT(buf));
+				_r128_load(buf, fmt, d, ich, j, nb);
+				for (k = 0;  k < nb;  k++) {
+					double a = fabs(buf[k]);
+					if (r->peak < a)
+						r->peak = a;
+				}
+				j += nb;
+				if (r->weight[ich] == 0)
+					continue;
+
+				for (k = 0;  k < nb;  k++) {
+					double y = _r128_biquad(&r->shelf, &z[0], buf[k]);
+					y = _r128_biquad(&r->hpass, &z[2], y);
+					sum += y * y;
+				}
+			}
+			e += sum * r->weight[ich];
+		}
+
+		r->sub_e[3] += e;
+		r->sub_pos += n;
+		i += n;
+
+		if (r->sub_pos == r->sub_samples) {
+			r->sub_pos = 0;
+			r->sub_n++;
+			if (r->sub_n >= 4) {
+				double block = (r->sub_e[0] + r->sub_e[1] + r->sub_e[2] + r->sub_e[3])
+					/ (4 * r->sub_samples);
+				*ffvec_pushT(&r->blocks, double) = block;
+			}
+			r->sub_e[0] = r->sub_e[1];
+			r->sub_e[1] = r->sub_e[2];
+			r->sub_e[2] = r->sub_e[3];
+			r->sub_e[3] = 0;
+		}
+	}
+}
+
+/** Get the loudness of the last 400ms block (LUFS) */
+static inline double r128_momentary(const struct r128 *r)
+{
+	if (r->blocks.len == 0)
+		return -INFINITY;
+	return r128_lufs(((double*)r->blocks.ptr)[r->blocks.len - 1]);
+}
+
+/** Get integrated loudness (LUFS) from block energies */
+static inline double r128_integrated(const double *blocks, ffsize n)
+{
+	double abs_gate = r128_energy(R128_ABS_GATE);
+	double sum = 0;
+	ffsize i, k = 0;
+	for (i = 0;  i < n;  i++) {
+		if (blocks[i] >= abs_gate) {
+			sum += blocks[i];
+			k++;
+		}
+	}
+	if (k == 0)
+		return -INFINITY;
+
+	double rel_gate = sum / k * pow(10, R128_REL_GATE / 10);
+	double gate = ffmax(abs_gate, rel_gate);
+	sum = 0;
+	k = 0;
+	for (i = 0;  i < n;  i++) {
+		if (blocks[i] >= gate) {
+			sum += blocks[i];
+			k++;
+		}
+	}
+	if (k == 0)
+		return -INFINITY;
+	return r128_lufs(sum / k);
+}
+
+#undef R128_ABS_GATE
+#undef R128_REL_GATE
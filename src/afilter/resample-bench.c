@@ -0,0 +1,139 @@
+/** phiola: benchmark: polyphase resampler vs. soxr
+2026, Simon Zolin
+
+Converts the same float32 stereo signal with the polyphase resampler (each quality)
+ and with soxr (default quality), and prints the speed in input samples per second.
+Usage:
+	resample-bench [SECONDS]
+*/
+
+#include <phiola.h>
+#include <afilter/polyphase.h>
+#include <soxr/soxr-phi.h>
+#include <ffsys/time.h>
+#include <ffsys/std.h>
+#include <ffbase/string.h>
+
+#define CHANNELS  2
+#define CHUNK  4096 // samples per call
+
+static uint64 nsec_since(fftime t1)
+{
+	fftime t2;
+	fftime_now(&t2);
+	fftime_sub(&t2, &t1);
+	return (uint64)t2.sec * 1000000000 + t2.nsec;
+}
+
+/** Return output samples; 0 on error */
+static ffsize run_polyphase(const float *in, ffsize n, uint irate, uint orate, uint quality, float *out, ffsize cap)
+{
+	struct polyphase ps;
+	if (polyphase_init(&ps, CHANNELS, irate, orate, quality))
+		return 0;
+
+	ffsize total = 0;
+	for (ffsize i = 0;  i < n;  i += CHUNK) {
+		polyphase_input(&ps, in + i * CHANNELS, 1, ffmin(CHUNK, n - i));
+		total += polyphase_output(&ps, out + total * CHANNELS, 1, cap - total);
+	}
+	polyphase_input(&ps, NULL, 1, 0);
+	total += polyphase_output(&ps, out + total * CHANNELS, 1, cap - total);
+	polyphase_close(&ps);
+	return total;
+}
+
+static ffsize run_soxr(const float *in, ffsize n, uint irate, uint orate, float *out, ffsize cap)
+{
+	struct soxr_conf conf = {
+		.i_rate = irate,
+		.o_rate = orate,
+		.i_format = SOXR_F32,
+		.o_format = SOXR_F32,
+		.i_interleaved = 1,
+		.o_interleaved = 1,
+		.channels = CHANNELS,
+	};
+	soxr_ctx *sx;
+	if (phi_soxr_create(&sx, &conf))
+		return 0;
+
+	const uint ss = CHANNELS * sizeof(float);
+	ffsize total = 0;
+	for (ffsize i = 0;  ;  i += CHUNK) {
+		const void *data = in + i * CHANNELS;
+		ffsize len = ffmin(CHUNK, n - i) * ss, off = 0;
+		if (i >= n) {
+			data = NULL; // flush
+			len = 0;
+		}
+		for (;;) {
+			int r = phi_soxr_convert(sx, data, len, &off, out + total * CHANNELS, (cap - total) * ss);
+			if (r < 0) {
+				total = 0;
+				goto end;
+			}
+			total += r / ss;
+			if (r == 0 && off == len)
+				break;
+		}
+		if (data == NULL)
+			break;
+	}
+
+end:
+	phi_soxr_destroy(sx);
+	return total;
+}
+
+int main(int argc, char **argv)
+{
+	uint sec = 60;
+	ffstr s;
+	if (argc > 1) {
+		ffstr_setz(&s, argv[1]);
+		ffstr_toint(&s, &sec, FFS_INT32);
+	}
+
+	static const uint pairs[][2] = {
+		{ 44100, 48000 },
+		{ 48000, 44100 },
+		{ 96000, 44100 },
+	};
+	static const char names[][8] = { "fast", "medium", "high" };
+
+	for (uint ip = 0;  ip < FF_COUNT(pairs);  ip++) {
+		uint irate = pairs[ip][0], orate = pairs[ip][1];
+		ffsize n = (ffsize)irate * sec;
+		ffsize cap = (ffsize)orate * sec + CHUNK * 2;
+		float *in = ffmem_alloc(n * CHANNELS * sizeof(float));
+		float *out = ffmem_alloc(cap * CHANNELS * sizeof(float));
+		ffmem_zero(out, cap * CHANNELS * sizeof(float)); // don't measure page faults
+		for (ffsize i = 0;  i < n;  i++) {
+			in[i * 2] = sin(2 * M_PI * 1000 * i / irate) * 0.5;
+			in[i * 2 + 1] = sin(2 * M_PI * 440 * i / irate) * 0.5;
+		}
+
+		fftime t1;
+		for (uint q = POLYPHASE_FAST;  q <= POLYPHASE_HIGH;  q++) {
+			polyphase_table(irate, orate, q); // don't measure building the table
+			fftime_now(&t1);
+			ffsize r = run_polyphase(in, n, irate, orate, q, out, cap);
+			uint64 ns = nsec_since(t1);
+			ffstdout_fmt("%u -> %u: polyphase (%s): %L samples  %UM samples/sec\n"
+				, irate, orate, names[q], r, (uint64)n * 1000 / ffmax(ns, 1));
+		}
+
+		fftime_now(&t1);
+		ffsize r = run_soxr(in, n, irate, orate, out, cap);
+		uint64 ns = nsec_since(t1);
+		ffstdout_fmt("%u -> %u: soxr: %L samples  %UM samples/sec\n"
+			, irate, orate, r, (uint64)n * 1000 / ffmax(ns, 1));
+
+		ffmem_free(in);
+		ffmem_free(out);
+	}
+
+	polyphase_tables_free();
+	return 0;
+}
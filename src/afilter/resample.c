@@ -0,0 +1,136 @@
+/** phiola: afilter: polyphase sample rate convertor
+2026, Simon Zolin */
+
+/* Converts sample rate of float32 audio for the common rate pairs (see polyphase_supported()).
+Previous filter must deal with sample format and channel conversion;
+ if the output sample format isn't float32, the next filter converts it. */
+
+#include <track.h>
+#include <util/util.h>
+#include <afilter/polyphase.h>
+
+extern const phi_core *core;
+#define errlog(t, ...)  phi_errlog(core, NULL, t, __VA_ARGS__)
+#define dbglog(t, ...)  phi_dbglog(core, NULL, t, __VA_ARGS__)
+
+enum {
+	RSMP_OUTBUF_MSEC = 500,
+};
+
+struct resample {
+	struct polyphase ps;
+	struct phi_af fmt;
+	uint frame_size;
+	uint flush :1;
+	ffsize cap; // samples
+	void *buf;
+	void *buf_v[8];
+};
+
+/** Return 1 if polyphase resampler can be used for these rates */
+int phi_resample_supported(const phi_track *t, uint irate, uint orate)
+{
+	return t->conf.afilter.resampler != PHI_RESAMPLE_SOXR
+		&& polyphase_supported(irate, orate);
+}
+
+void phi_resample_free()
+{
+	polyphase_tables_free();
+}
+
+static void* rsmp_open(phi_track *t)
+{
+	static const u_char quality[] = {
+		POLYPHASE_HIGH, // PHI_RESAMPLE_DEFAULT
+		POLYPHASE_FAST,
+		POLYPHASE_MEDIUM,
+		POLYPHASE_HIGH,
+	};
+	struct resample *c = phi_track_allocT(t, struct resample);
+	c->fmt = t->aconv.in;
+	struct phi_af oaf = t->aconv.out;
+	uint q = quality[ffmin(t->conf.afilter.resampler, FF_COUNT(quality) - 1)];
+
+	if (c->fmt.format != PHI_PCM_FLOAT32
+		|| polyphase_init(&c->ps, c->fmt.channels, c->fmt.rate, oaf.rate, q)) {
+		errlog(t, "polyphase resampler: conversion not supported: %u -> %u", c->fmt.rate, oaf.rate);
+		goto end;
+	}
+	dbglog(t, "polyphase resampler: %u -> %u  taps:%u  %s"
+		, c->fmt.rate, oaf.rate, c->ps.pt->taps
+		, (c->ps.run == _polyphase_run_c) ? "C" : "AVX2");
+
+	c->frame_size = pcm_size1(&c->fmt);
+	c->cap = msec_to_samples(RSMP_OUTBUF_MSEC, oaf.rate);
+	uint channel_len = c->cap * sizeof(float);
+	if (NULL == (c->buf = phi_track_buf_alloc(t, channel_len * c->fmt.channels)))
+		goto end;
+	if (!c->fmt.interleaved) {
+		for (uint i = 0;  i < c->fmt.channels;  i++) {
+			c->buf_v[i] = (char*)c->buf + channel_len * i;
+		}
+	}
+
+	if (oaf.format != PHI_PCM_FLOAT32
+		|| oaf.interleaved != c->fmt.interleaved) {
+		// [... -> resample --(float/48/2)-> conv --(int16/48/2)-> ... ]
+		if (!core->track->filter(t, core->mod("afilter.conv"), 0))
+			goto end;
+		t->aconv.in = c->fmt;
+		t->aconv.in.rate = oaf.rate;
+	}
+	return c;
+
+end:
+	polyphase_close(&c->ps);
+	phi_track_buf_free(t, c->buf);
+	t->error = PHI_E_ACONV;
+	phi_track_free(t, c);
+	return PHI_OPEN_ERR;
+}
+
+static void rsmp_close(void *ctx, phi_track *t)
+{
+	struct resample *c = ctx;
+	polyphase_close(&c->ps);
+	phi_track_buf_free(t, c->buf);
+	phi_track_free(t, c);
+}
+
+static int rsmp_process(void *ctx, phi_track *t)
+{
+	struct resample *c = ctx;
+
+	if (t->audio.seek_req) {
+		// the samples before the seek position must not affect the output after it
+		polyphase_reset(&c->ps);
+		return PHI_MORE;
+	}
+
+	if (t->chain_flags & PHI_FFWD) {
+		ffsize n = t->data_in.len / c->frame_size;
+		if (n)
+			polyphase_input(&c->ps, t->data_in.ptr, c->fmt.interleaved, n);
+		t->data_in.len = 0;
+
+		if ((t->chain_flags & PHI_FFIRST) && !c->flush) {
+			c->flush = 1;
+			polyphase_input(&c->ps, NULL, 0, 0);
+		}
+	}
+
+	void *out = (c->fmt.interleaved) ? c->buf : c->buf_v;
+	ffsize n = polyphase_output(&c->ps, out, c->fmt.interleaved, c->cap);
+	if (n == 0)
+		return (c->flush) ? PHI_DONE : PHI_MORE;
+
+	ffstr_set(&t->data_out, out, n * c->frame_size);
+	return PHI_DATA;
+}
+
+const phi_filter phi_resample = {
+	rsmp_open, rsmp_close, rsmp_process,
+	"resample",
+	PHI_FILTER_OWN_OUTPUT
+};
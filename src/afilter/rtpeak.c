@@ -2,7 +2,7 @@
 2015,2022, Simon Zolin */
 
 #include <track.h>
-#include <afilter/pcm_maxpeak.h>
+#include <afilter/pcm-stat.h>
 
 extern const phi_core *core;
 #define errlog(t, ...)  phi_errlog(core, NULL, t, __VA_ARGS__)
@@ -16,8 +16,8 @@ static void* rtpeak_open(phi_track *t)
 {
 	struct rtpeak *p = phi_track_allocT(t, struct rtpeak);
 	p->fmt = t->audio.format;
-	if (0 != pcm_maxpeak(&p->fmt, NULL, 0, NULL)) {
-		errlog(t, "pcm_maxpeak(): format not supported");
+	if (0 != pcm_gain_stat(&p->fmt, 1, NULL, 0, NULL)) {
+		errlog(t, "pcm_gain_stat(): format not supported");
 		phi_track_free(t, p);
 		return PHI_OPEN_ERR;
 	}
@@ -34,9 +34,9 @@ static int rtpeak_process(void *ctx, phi_track *t)
 {
 	struct rtpeak *p = ctx;
 
-	double maxpeak = 0;
-	pcm_maxpeak(&p->fmt, t->data_in.ptr, t->data_in.len / pcm_size1(&p->fmt), &maxpeak);
-	double db = gain_db(maxpeak);
+	struct pcm_stat st = {};
+	pcm_gain_stat(&p->fmt, 1, (void*)t->data_in.ptr, t->data_in.len / pcm_size1(&p->fmt), &st);
+	double db = gain_db(pcm_stat_maxpeak(&st, p->fmt.channels));
 	t->audio.maxpeak_db = db;
 	dbglog(t, "maxpeak:%.2F", db);
 
@@ -46,5 +46,6 @@ static int rtpeak_process(void *ctx, phi_track *t)
 
 const phi_filter phi_rtpeak = {
 	rtpeak_open, rtpeak_close, rtpeak_process,
-	"rtpeak"
+	"rtpeak",
+	PHI_FILTER_INPLACE
 };
@@ -0,0 +1,185 @@
+/** phiola: silence detector
+2026, Simon Zolin */
+
+/* The RMS level of all channels is measured over consecutive windows (10ms).
+A window is silent if its level is below the threshold.
+Supported formats: int16, int24, int32, float32, float64; interleaved and non-interleaved.
+The sum of squares is calculated with AVX2 for int16 and float32. */
+
+#pragma once
+#include <afilter/pcm.h>
+#include <afilter/pcm-simd.h>
+
+struct sdet {
+	uint channels;
+	uint sample_size; // one channel
+	uint window; // frames
+	double threshold; // mean square
+	uint64 pos; // frames analyzed
+	uint wpos; // frames in the current window
+	double sum; // sum of squares in the current window
+};
+
+/** Return 1 if the format is supported */
+static inline int sdet_format_supported(const struct phi_af *fmt)
+{
+	switch (fmt->format) {
+	case PHI_PCM_16:
+	case PHI_PCM_24:
+	case PHI_PCM_32:
+	case PHI_PCM_FLOAT32:
+	case PHI_PCM_FLOAT64:
+		return (fmt->channels != 0 && fmt->channels <= 8);
+	}
+	return 0;
+}
+
+/**
+threshold_db: max. RMS level of silence (dBFS) */
+static inline void sdet_init(struct sdet *d, const struct phi_af *fmt, double threshold_db)
+{
+	ffmem_zero_obj(d);
+	d->channels = fmt->channels;
+	d->sample_size = pcm_bits(fmt->format) / 8;
+	d->window = ffmax(fmt->rate / 100, 1);
+	d->threshold = pow(10, threshold_db / 10);
+}
+
+static double _sdet_sumsq_c(uint format, const void *data, ffsize n)
+{
+	double sum = 0;
+	union pcmdata d;
+	d.b = (char*)data;
+	switch (format) {
+	case PHI_PCM_16:
+		for (ffsize i = 0;  i < n;  i++) {
+			double v = d.sh[i];
+			sum += v * v;
+		}
+		return sum * (1 / (max16f * max16f));
+
+	case PHI_PCM_24:
+		for (ffsize i = 0;  i < n;  i++) {
+			double v = int_ltoh24s(&d.b[i * 3]);
+			sum += v * v;
+		}
+		return sum * (1 / (max24f * max24f));
+
+	case PHI_PCM_32:
+		for (ffsize i = 0;  i < n;  i++) {
+			double v = d.in[i];
+			sum += v * v;
+		}
+		return sum * (1 / (max32f * max32f));
+
+	case PHI_PCM_FLOAT32:
+		for (ffsize i = 0;  i < n;  i++) {
+			double v = d.f[i];
+			sum += v * v;
+		}
+		return sum;
+
+	case PHI_PCM_FLOAT64:
+		for (ffsize i = 0;  i < n;  i++) {
+			sum += d.d[i] * d.d[i];
+		}
+		return sum;
+	}
+	return 0;
+}
+
+#ifdef PCM_SIMD_X86
+
+__attribute__((target("avx2")))
+static double _sdet_sumsq_f32_avx2(const float *d, ffsize n)
+{
+	__m256 acc = _mm256_setzero_ps();
+	ffsize i = 0;
+	for (;  i + 8 <= n;  i += 8) {
+		__m256 v = _mm256_loadu_ps(d + i);
+		acc = _mm256_add_ps(acc, _mm256_mul_ps(v, v));
+	}
+
+	float lanes[8];
+	_mm256_storeu_ps(lanes, acc);
+	double sum = 0;
+	for (uint k = 0;  k < 8;  k++) {
+		sum += lanes[k];
+	}
+	return sum + _sdet_sumsq_c(PHI_PCM_FLOAT32, d + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static double _sdet_sumsq_i16_avx2(const short *d, ffsize n)
+{
+	// a*a + b*b <= 2^31: the result of madd is treated as unsigned
+	__m256i acc = _mm256_setzero_si256();
+	ffsize i = 0;
+	for (;  i + 16 <= n;  i += 16) {
+		__m256i v = _mm256_loadu_si256((__m256i*)(d + i));
+		__m256i m = _mm256_madd_epi16(v, v);
+		acc = _mm256_add_epi64(acc, _mm256_cvtepu32_epi64(_mm256_castsi256_si128(m)));
+		acc = _mm256_add_epi64(acc, _mm256_cvtepu32_epi64(_mm256_extracti128_si256(m, 1)));
+	}
+
+	uint64 lanes[4];
+	_mm256_storeu_si256((__m256i*)lanes, acc);
+	double sum = (double)(lanes[0] + lanes[1] + lanes[2] + lanes[3]) * (1 / (max16f * max16f));
+	return sum + _sdet_sumsq_c(PHI_PCM_16, d + i, n - i);
+}
+
+#endif // PCM_SIMD_X86
+
+/** Get the sum of squares of 'n' normalized values */
+static inline double _sdet_sumsq(uint format, const void *data, ffsize n)
+{
+#ifdef PCM_SIMD_X86
+	if (pcm_simd_level() >= PCM_SIMD_AVX2) {
+		if (format == PHI_PCM_FLOAT32)
+			return _sdet_sumsq_f32_avx2(data, n);
+		else if (format == PHI_PCM_16)
+			return _sdet_sumsq_i16_avx2(data, n);
+	}
+#endif
+	return _sdet_sumsq_c(format, data, n);
+}
+
+/** Analyze the frames [off..off+n) up to the end of the current window.
+data: interleaved: sample[]; non-interleaved: sample*[]
+silent: [output] -1: the window isn't complete yet;  0: the window contains a signal;  1: the window is silent
+Return the number of frames processed */
+static inline ffsize sdet_process(struct sdet *d, const struct phi_af *fmt, const void *data, ffsize off, ffsize n, int *silent)
+{
+	n = ffmin(n, d->window - d->wpos);
+	if (fmt->interleaved) {
+		const char *p = (char*)data + off * d->sample_size * d->channels;
+		d->sum += _sdet_sumsq(fmt->format, p, n * d->channels);
+	} else {
+		for (uint c = 0;  c < d->channels;  c++) {
+			const char *p = ((char**)data)[c] + off * d->sample_size;
+			d->sum += _sdet_sumsq(fmt->format, p, n);
+		}
+	}
+
+	d->pos += n;
+	d->wpos += n;
+	*silent = -1;
+	if (d->wpos == d->window) {
+		*silent = (d->sum / (d->window * d->channels) < d->threshold);
+		d->wpos = 0;
+		d->sum = 0;
+	}
+	return n;
+}
+
+/** Analyze the incomplete window at the end of stream.
+Return the number of frames in the window;
+ silent: [output] 0: the window contains a signal;  1: the window is silent */
+static inline uint sdet_finish(struct sdet *d, int *silent)
+{
+	uint n = d->wpos;
+	*silent = (n == 0 || d->sum / (n * d->channels) < d->threshold);
+	d->wpos = 0;
+	d->sum = 0;
+	return n;
+}
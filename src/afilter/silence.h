@@ -0,0 +1,327 @@
+/** phiola: silence detection and trimming
+2026, Simon Zolin */
+
+/* Silence is a sequence of silent windows (see silence-detect.h) not shorter than 'duration'.
+. trim: remove leading and trailing silence
+. report: print the time ranges of silence
+. phi_track_conf.split_silence: 'split' filter starts a new file after each silence
+   (the first data of the new file is marked with phi_track.audio.split_gap);
+   with 'trim' the silence between the files is removed.
+The input is processed incrementally:
+ the frames of the current window are held until the window is analyzed.
+In 'trim' mode the frames of the window being analyzed and the silence after the signal
+ are held until the signal is found again,
+ so the memory usage depends on the duration of the silence, not of the whole input.
+The held silence is limited to 'duration' or SIL_HOLD_MAX_MSEC, whichever is larger:
+ the older frames of a longer silence are passed through,
+ so such trailing silence is shortened rather than removed. */
+
+#include <afilter/silence-detect.h>
+#include <ffsys/std.h>
+#include <ffbase/args.h>
+
+#define SIL_HOLD_MAX_MSEC  60000
+
+static int sil_arg_help()
+{
+	static const char help[] = "\n\
+Silence options:\n\
+  threshold   Integer (dB) (=50)\n\
+  duration    Integer (msec) (=1000)\n\
+  trim        Remove leading and trailing silence\n\
+  report      Print the time ranges of silence\n\
+\n";
+	ffstdout_write(help, FF_COUNT(help));
+	return 1;
+}
+
+struct silence_conf {
+	uint threshold_db;
+	uint duration_msec;
+	u_char trim;
+	u_char report;
+};
+
+#define O(m)  (void*)(ffsize)FF_OFF(struct silence_conf, m)
+static const struct ffarg silence_conf_args[] = {
+	{ "duration",	'u',	O(duration_msec) },
+	{ "help",		'0',	sil_arg_help },
+	{ "report",		'1',	O(report) },
+	{ "threshold",	'u',	O(threshold_db) },
+	{ "trim",		'1',	O(trim) },
+	{}
+};
+#undef O
+
+enum SIL_STATE {
+	SIL_LEAD, // (trim) before the first signal
+	SIL_SIGNAL,
+	SIL_GAP, // after the signal
+};
+
+struct silence {
+	struct silence_conf conf;
+	struct sdet d;
+	struct phi_af fmt;
+	uint frame_size;
+	uint planes, plane_size; // interleaved: 1, frame_size;  non-interleaved: channels, sample_size
+	uint state; // enum SIL_STATE
+	uint hold_needed :1;
+	uint split :1;
+	uint eos :1;
+	uint64 min_frames;
+	uint64 hold_max; // (trim) max. frames of silence to hold
+	uint64 run_start, run_len; // current silent run (frames)
+
+	ffstr in; // input data
+	ffsize off; // frames processed
+
+	ffvec hold[8]; // held frames of each plane
+	ffsize hold_n; // frames
+	ffsize hold_send; // the frames [0..hold_send) are ready to be sent
+	ffsize hold_off; // frames sent
+	ffsize hold_split; // send the frames from this position to a new file.  -1: none
+	void *out_ptrs[8];
+};
+
+static void* sil_open(phi_track *t)
+{
+	const struct phi_af *af = (t->oaudio.format.format) ? &t->oaudio.format : &t->audio.format;
+	if (!sdet_format_supported(af) || af->rate == 0) {
+		errlog(t, "input audio format not supported");
+		return PHI_OPEN_ERR;
+	}
+
+	struct silence_conf cc = {
+		.threshold_db = 50,
+		.duration_msec = 1000,
+	};
+	struct ffargs a = {};
+	if (ffargs_process_line(&a, silence_conf_args, &cc, FFARGS_O_PARTIAL | FFARGS_O_DUPLICATES, (t->conf.afilter.silence) ? t->conf.afilter.silence : "")) {
+		errlog(t, "%s", a.error);
+		return PHI_OPEN_ERR;
+	}
+
+	struct silence *c = phi_track_allocT(t, struct silence);
+	c->conf = cc;
+	c->fmt = *af;
+	c->frame_size = pcm_size1(af);
+	c->planes = (af->interleaved) ? 1 : af->channels;
+	c->plane_size = (af->interleaved) ? c->frame_size : pcm_bits(af->format) / 8;
+	c->split = t->conf.split_silence;
+	c->hold_needed = (c->conf.trim || c->split);
+	c->state = (c->conf.trim) ? SIL_LEAD : SIL_SIGNAL;
+	c->min_frames = ffmax(pcm_samples(c->conf.duration_msec, af->rate), 1);
+	c->hold_max = ffmax(c->min_frames, pcm_samples(SIL_HOLD_MAX_MSEC, af->rate));
+	c->hold_split = -1;
+	sdet_init(&c->d, af, -(int)c->conf.threshold_db);
+	return c;
+}
+
+static void sil_close(void *ctx, phi_track *t)
+{
+	struct silence *c = ctx;
+	for (uint i = 0;  i < c->planes;  i++) {
+		ffvec_free(&c->hold[i]);
+	}
+	phi_track_free(t, c);
+}
+
+static void sil_report(struct silence *c, phi_track *t)
+{
+	if (c->run_len < c->min_frames)
+		return;
+
+	uint rate = c->fmt.rate;
+	dbglog(t, "silence: %U..%U", c->run_start, c->run_start + c->run_len);
+	if (c->conf.report)
+		userlog(t, "Silence: %.3F - %.3F sec"
+			, (double)c->run_start / rate, (double)(c->run_start + c->run_len) / rate);
+}
+
+/** Set output data: the frames [off..off+n) */
+static void sil_out(struct silence *c, phi_track *t, const void *data, ffsize off, ffsize n)
+{
+	if (c->fmt.interleaved) {
+		ffstr_set(&t->data_out, (char*)data + off * c->frame_size, n * c->frame_size);
+		return;
+	}
+
+	for (uint i = 0;  i < c->planes;  i++) {
+		c->out_ptrs[i] = ((char**)data)[i] + off * c->plane_size;
+	}
+	ffstr_set(&t->data_out, c->out_ptrs, n * c->frame_size);
+}
+
+static void sil_hold_add(struct silence *c, ffsize off, ffsize n)
+{
+	for (uint i = 0;  i < c->planes;  i++) {
+		const char *p = (c->fmt.interleaved) ? c->in.ptr : ((char**)c->in.ptr)[i];
+		ffvec_add(&c->hold[i], p + off * c->plane_size, n * c->plane_size, 1);
+	}
+	c->hold_n += n;
+}
+
+/** Remove the first 'n' frames from the hold buffer */
+static void sil_hold_shift(struct silence *c, ffsize n)
+{
+	for (uint i = 0;  i < c->planes;  i++) {
+		ffslice_rm((ffslice*)&c->hold[i], 0, n * c->plane_size, 1);
+	}
+	c->hold_n -= n;
+}
+
+/** Handle the analyzed window of 'n' frames (the last frames in the input) */
+static void sil_window(struct silence *c, phi_track *t, int silent, ffsize n)
+{
+	if (silent) {
+		if (c->state == SIL_SIGNAL) {
+			c->state = SIL_GAP;
+			c->run_start = c->d.pos - n;
+			c->run_len = 0;
+		}
+		c->run_len += n;
+
+		if (c->hold_needed
+			&& !(c->conf.trim && c->state != SIL_SIGNAL))
+			c->hold_send = c->hold_n; // no need to hold the silence
+
+		if (c->state == SIL_LEAD && c->hold_needed)
+			sil_hold_shift(c, c->hold_n); // leading silence is removed
+
+		else if (c->state == SIL_GAP && c->conf.trim
+			&& c->hold_n > c->hold_max)
+			c->hold_send = c->hold_n - c->hold_max; // pass the older frames through
+		return;
+	}
+
+	if (c->state == SIL_SIGNAL) {
+		c->hold_send = c->hold_n; // the held window is not silent
+		return;
+	}
+
+	// the signal after the silence
+	sil_report(c, t);
+	if (c->state == SIL_GAP
+		&& c->split
+		&& c->run_len >= c->min_frames
+		&& c->hold_needed) {
+		ffsize silence = c->hold_n - n;
+		if (c->conf.trim) {
+			sil_hold_shift(c, silence);
+			silence = 0;
+		}
+		c->hold_split = silence;
+	}
+	c->hold_send = c->hold_n;
+	c->state = SIL_SIGNAL;
+	c->run_len = 0;
+}
+
+static void sil_finish(struct silence *c, phi_track *t)
+{
+	int silent;
+	uint n = sdet_finish(&c->d, &silent);
+	if (n)
+		sil_window(c, t, silent, n);
+
+	if (c->state != SIL_SIGNAL) {
+		sil_report(c, t);
+		// trailing silence is removed in 'trim' mode
+		for (uint i = 0;  i < c->planes;  i++) {
+			c->hold[i].len = c->hold_send * c->plane_size;
+		}
+		c->hold_n = c->hold_send;
+	}
+}
+
+static int sil_process(void *ctx, phi_track *t)
+{
+	struct silence *c = ctx;
+	int silent;
+
+	if (t->chain_flags & PHI_FFWD) {
+		c->in = t->data_in;
+		c->off = 0;
+	}
+
+	for (;;) {
+		if (c->hold_off < c->hold_send) {
+			// send the held frames
+			ffsize end = c->hold_send;
+			if (c->hold_split > c->hold_off && c->hold_split < end)
+				end = c->hold_split;
+			t->audio.split_gap = (c->hold_off == c->hold_split);
+
+			void *hold[8];
+			for (uint i = 0;  i < c->planes;  i++) {
+				hold[i] = c->hold[i].ptr;
+			}
+			sil_out(c, t, (c->fmt.interleaved) ? hold[0] : (void*)hold, c->hold_off, end - c->hold_off);
+			c->hold_off = end;
+			return PHI_DATA;
+		}
+
+		if (c->hold_send) {
+			sil_hold_shift(c, c->hold_send);
+			c->hold_send = 0;
+			c->hold_off = 0;
+			c->hold_split = -1;
+		}
+
+		ffsize total = c->in.len / c->frame_size;
+		if (c->off == total) {
+			if (!(t->chain_flags & PHI_FFIRST))
+				return PHI_MORE;
+			if (c->eos)
+				return PHI_DONE;
+			c->eos = 1;
+			sil_finish(c, t);
+			continue;
+		}
+
+		if ((c->state == SIL_SIGNAL && !c->hold_n) || !c->hold_needed) {
+			// pass the input data through
+			ffsize start = c->off, held = 0;
+			while (c->off < total) {
+				ffsize off = c->off;
+				ffsize n = sdet_process(&c->d, &c->fmt, c->in.ptr, off, total - off, &silent);
+				c->off += n;
+				if (silent < 0) {
+					if (c->conf.trim) {
+						// the window is incomplete: it may turn out to be the trailing silence
+						sil_hold_add(c, off, n);
+						held = n;
+					}
+					break;
+				}
+
+				uint st = c->state;
+				sil_window(c, t, silent, c->d.window);
+				if (st != c->state && c->hold_needed) {
+					if (c->conf.trim) {
+						// the silent window is held along with the frames after it
+						sil_hold_add(c, off, n);
+						held = n;
+					}
+					break; // the frames must be held from now on
+				}
+			}
+			t->audio.split_gap = 0;
+			sil_out(c, t, c->in.ptr, start, c->off - held - start);
+			return PHI_DATA;
+		}
+
+		// hold the frames until the window is analyzed
+		ffsize n = sdet_process(&c->d, &c->fmt, c->in.ptr, c->off, total - c->off, &silent);
+		sil_hold_add(c, c->off, n);
+		c->off += n;
+		if (silent >= 0)
+			sil_window(c, t, silent, c->d.window);
+	}
+}
+
+static const phi_filter phi_silence = {
+	sil_open, sil_close, sil_process,
+	"silence"
+};
@@ -103,5 +103,6 @@ static int pcm_skip_process(void *ctx, phi_track *t)
 
 const phi_filter phi_pcm_skip = {
 	pcm_skip_open, pcm_skip_close, pcm_skip_process,
-	"pcm-skip"
+	"pcm-skip",
+	PHI_FILTER_INPLACE
 };
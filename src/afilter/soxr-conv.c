@@ -79,7 +79,8 @@ static void* soxr_open(phi_track *t)
 	}
 	uint channel_len = oaf.rate * (oaf.format & 0xff) / 8;
 	c->buf_cap = channel_len * oaf.channels;
-	c->buf = phi_track_alloc(t, c->buf_cap);
+	if (NULL == (c->buf = phi_track_buf_alloc(t, c->buf_cap)))
+		goto end;
 	if (!oaf.interleaved) {
 		for (uint i = 0;  i < oaf.channels;  i++) {
 			c->buf_v[i] = (char*)c->buf + channel_len * i;
@@ -96,7 +97,7 @@ end:
 static void soxr_close(struct soxr *c, phi_track *t)
 {
 	phi_soxr_destroy(c->soxr);
-	phi_track_free(t, c->buf);
+	phi_track_buf_free(t, c->buf);
 	phi_track_free(t, c);
 }
 
@@ -136,7 +137,8 @@ static int soxr_conv(struct soxr *c, phi_track *t)
 
 const phi_filter phi_soxr = {
 	soxr_open, (void*)soxr_close, (void*)soxr_conv,
-	"soxr-convert"
+	"soxr-convert",
+	PHI_FILTER_OWN_OUTPUT
 };
 
 
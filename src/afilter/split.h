@@ -97,17 +97,19 @@ struct split {
 	ffstr	qdata;
 	uint	sample_size;
 	uint	split_next :1;
+	uint	split_gap :1;
 };
 
 static void* split_open(phi_track *t)
 {
-	if (t->conf.split_msec == 0)
+	if (t->conf.split_msec == 0 && !t->conf.split_silence)
 		return PHI_OPEN_SKIP;
 
 	struct split *c = phi_track_allocT(t, struct split);
 	c->split_by = msec_to_samples(t->conf.split_msec, t->audio.format.rate);
 	c->sample_size = pcm_size(t->audio.format.format, t->audio.format.channels);
 	c->split_next = 1;
+	t->worker_bound++; // the subtrack wakes us up
 	return c;
 }
 
@@ -119,6 +121,7 @@ static void split_close(void *ctx, phi_track *t)
 		c->brg->parent = NULL;
 		split_brg_unref(c->brg);
 	}
+	t->worker_bound--;
 	phi_track_free(t, c);
 }
 
@@ -176,6 +179,10 @@ static int split_process(void *ctx, phi_track *t)
 	if (!input.len) {
 		input = t->data_in;
 		t->data_in.len = 0;
+		if (t->audio.split_gap) {
+			t->audio.split_gap = 0;
+			c->split_gap = 1;
+		}
 	}
 
 	if (c->brg && split_brg_busy(c->brg))
@@ -191,6 +198,13 @@ static int split_process(void *ctx, phi_track *t)
 	if (t->audio.pos == ~0ULL)
 		pos = c->total / c->sample_size;
 
+	if (c->split_gap) {
+		// the previous filter has found silence before this data
+		c->split_gap = 0;
+		c->split_next = 1;
+		c->next_split = pos;
+	}
+
 	if (c->split_next) {
 		c->split_next = 0;
 		c->next_split += c->split_by;
@@ -199,7 +213,10 @@ static int split_process(void *ctx, phi_track *t)
 
 	t->data_out = input;
 
-	if (t->conf.stream_copy) {
+	if (c->split_by == 0) {
+		// split by silence only
+
+	} else if (t->conf.stream_copy) {
 		if (pos >= c->next_split) {
 			dbglog(t, "reached block with sample #%U", c->next_split);
 			c->split_next = 1;
@@ -85,5 +85,6 @@ static int until_process(void *ctx, phi_track *t)
 
 const phi_filter phi_until = {
 	until_open, until_close, until_process,
-	"until"
+	"until",
+	PHI_FILTER_INPLACE
 };
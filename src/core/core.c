@@ -337,6 +337,14 @@ static void core_task(uint worker, phi_task *pt, phi_task_func func, void *param
 	wrk_task(w, (fftask*)pt, func, param);
 }
 
+/** Wake up a track: used by track.c */
+void core_track_wake(uint worker, ffwakeq_node *n, phi_task_func func)
+{
+	PHI_ASSERT(worker < cc->wx.workers.len);
+	struct worker *w = ffslice_itemT(&cc->wx.workers, worker, struct worker);
+	wrk_wake(w, n, func);
+}
+
 static phi_kevent* core_kev_alloc(uint worker)
 {
 	PHI_ASSERT(worker < cc->wx.workers.len);
@@ -417,6 +425,12 @@ static void core_worker_release(uint worker)
 	wrkx_release(&cc->wx, worker);
 }
 
+static uint core_worker_move(uint worker)
+{
+	PHI_ASSERT(worker < cc->wx.workers.len);
+	return wrkx_move(&cc->wx, worker);
+}
+
 static int core_wrk_creating(uint iw)
 {
 	if (cc->kcq_lazy_start)
@@ -493,11 +507,11 @@ FF_EXPORT phi_core* phi_core_create(struct phi_core_conf *conf)
 	cc = ffmem_new(struct core_ctx);
 	ffvec_allocT(&cc->mods, 8, struct core_mod);
 	fftime_local(&cc->tz);
+	core->conf.workers = wrk_n(core->conf.workers);
 	tracks_init();
 	qm_init();
 	win_sleep_init();
 
-	core->conf.workers = wrk_n(core->conf.workers);
 	if (core->conf.io_workers == ~0U) {
 		core->conf.io_workers = core->conf.workers;
 		cc->kcq_lazy_start = 1;
@@ -622,4 +636,5 @@ static phi_core _core = {
 	.workers_available = core_workers_available,
 	.worker_assign = core_worker_assign,
 	.worker_release = core_worker_release,
+	.worker_move = core_worker_move,
 };
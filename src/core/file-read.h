@@ -3,40 +3,104 @@
 
 #include <util/fcache.h>
 #include <ffsys/file.h>
+#ifdef FF_UNIX
+#include <sys/mman.h>
+#endif
 
 #define ALIGN (4*1024)
+#define READAHEAD_MAX (4*1024*1024)
+#define MAP_WINDOW (8*1024*1024)
 
 struct file_r {
+	phi_track *trk;
 	fffd fd;
 	uint64 off_cur;
 	ffsize buf_cap;
 	struct fcache fcache;
+
+	phi_kevent *kev;
+	uint kev_worker;
+	struct fcache_buf *buf_pending; // buffer being filled by async operation
+	uint64 off_pending;
+	ffsize len_pending;
+	fftime t_start; // the time when we started async reading
+
+	// Sequential access detector
+	struct {
+		uint size; // current read-ahead window
+		uint size_max;
+	} ra;
+
+	// Memory-mapped file region
+	struct {
+		char *ptr;
+		ffsize len;
+		uint64 off;
+	} map;
+
 	uint eof :1;
+	uint mmap :1; // return data directly from the file mapping
+	uint async :1; // track is waiting for async signal
+	uint signalled :1; // async operation is ready
+	uint closed :1; // track is closed while async operation is in progress
 
 	struct {
 		fftime t_open, t_io;
 		uint64 io_bytes;
+		uint64 prefetches;
+		uint ra_max; // the largest read-ahead window used
+		uint maps;
 	} stats;
 };
 
+static void fr_read_done(void *param);
+static void fr_unmap(struct file_r *f);
+static void fr_kev_free(struct file_r *f);
+
+static void fr_free(struct file_r *f)
+{
+	fcache_destroy(&f->fcache);
+	fffile_close(f->fd);
+	ffmem_free(f);
+}
+
 static void fr_close(struct file_r *f, phi_track *t)
 {
-	dbglog(t, "open:%Ums  io:%Ums;%UKB/%U  cache-hits:%U"
+	dbglog(t, "open:%Ums  io:%Ums;%UKB/%U  cache-hits:%U  prefetch:%U  read-ahead:%uKB"
 		, fftime_to_msec(&f->stats.t_open)
 		, fftime_to_msec(&f->stats.t_io), f->stats.io_bytes / 1024, f->fcache.misses
-		, f->fcache.hits);
-	fcache_destroy(&f->fcache);
-	fffile_close(f->fd);
-	phi_track_free(t, f);
+		, f->fcache.hits, f->stats.prefetches, f->stats.ra_max / 1024);
+	if (f->mmap)
+		dbglog(t, "mapped regions:%u", f->stats.maps);
+	fr_unmap(f);
+
+	if (f->buf_pending && !f->signalled) {
+		// The kernel is still filling the buffer: the completion handler will free the object
+		dbglog(t, "%s: closing after async read completes", t->conf.ifile.name);
+		f->closed = 1;
+		f->trk = NULL;
+		t->worker_bound--;
+		return;
+	}
+
+	fr_kev_free(f);
+	fr_free(f);
 }
 
 static void* fr_open(phi_track *t)
 {
-	struct file_r *f = phi_track_allocT(t, struct file_r);
+	struct file_r *f = ffmem_new(struct file_r);
+	f->trk = t;
 	f->buf_cap = (t->conf.ifile.buf_size) ? t->conf.ifile.buf_size : 64*1024;
 	f->fd = FFFILE_NULL;
-	if (0 != fcache_init(&f->fcache, 2, f->buf_cap, ALIGN))
+#ifdef FF_UNIX
+	f->mmap = t->conf.ifile.mmap;
+#endif
+	if (!f->mmap
+		&& 0 != fcache_init(&f->fcache, 2, f->buf_cap, ALIGN))
 		goto end;
+	f->ra.size = f->buf_cap;
+	f->ra.size_max = ffmax(f->buf_cap, READAHEAD_MAX);
 
 	fftime t1;
 	frw_benchmark(&t1);
@@ -73,40 +137,248 @@ end:
 	return PHI_OPEN_ERR;
 }
 
+static void fr_read_done(void *param)
+{
+	struct file_r *f = param;
+	FF_ASSERT(f->buf_pending);
+	if (f->closed) {
+		core->kev_free(f->kev_worker, f->kev);
+		fr_free(f);
+		return;
+	}
+	f->signalled = 1;
+	if (f->async) {
+		f->async = 0;
+		core->track->wake(f->trk);
+	}
+}
+
+/** Grow read-ahead window while the track reads sequentially */
+static void fr_readahead_grow(struct file_r *f)
+{
+	if (f->ra.size == f->ra.size_max)
+		return;
+	f->ra.size = ffmin(f->ra.size * 2, f->ra.size_max);
+	f->stats.ra_max = ffmax(f->stats.ra_max, f->ra.size);
+	dbglog(f->trk, "read-ahead: %uKB", f->ra.size / 1024);
+}
+
+/** Get the number of bytes to read into the buffer; enlarge the buffer if necessary */
+static ffsize fr_read_size(struct file_r *f, struct fcache_buf *b)
+{
+	if (b->cap < f->ra.size)
+		fcache_buf_realloc(&f->fcache, b, f->ra.size); // on failure keep using the smaller buffer
+	return ffmin(b->cap, f->ra.size);
+}
+
+/** Allocate kernel event object for an async operation.
+It's held only while the operation is in progress, so the track may be moved to another worker. */
+static int fr_kev_alloc(struct file_r *f)
+{
+	if (f->kev)
+		return 0;
+	if (NULL == (f->kev = core->kev_alloc(f->trk->worker)))
+		return -1;
+	f->kev_worker = f->trk->worker;
+	f->kev->kcall.handler = fr_read_done;
+	f->kev->kcall.param = f;
+	f->trk->worker_bound++;
+	return 0;
+}
+
+static void fr_kev_free(struct file_r *f)
+{
+	if (!f->kev) return;
+
+	core->kev_free(f->kev_worker, f->kev);
+	f->kev = NULL;
+	f->trk->worker_bound--;
+}
+
+/** Read data from file into buffer.
+async: start asynchronous operation if possible
+Return 0: data is read;
+  -1: async operation is in progress;
+  1: error */
+static int fr_read(struct file_r *f, struct fcache_buf *b, uint64 off, ffsize n, uint async)
+{
+	fftime t1, t2;
+	ffssize r;
+	if (async && !fr_kev_alloc(f)) {
+		if (!f->buf_pending)
+			frw_benchmark(&f->t_start);
+		r = fffile_readat_async(f->fd, b->ptr, n, off, &f->kev->kcall);
+		if (r < 0 && fferr_last() == FFKCALL_EINPROGRESS) {
+			f->buf_pending = b;
+			f->off_pending = off;
+			f->len_pending = n;
+			b->len = 0;
+			b->off = 0;
+			dbglog(f->trk, "%s: read: in progress @%U", f->trk->conf.ifile.name, off);
+			return -1;
+		}
+		fr_kev_free(f);
+		t1 = f->t_start;
+
+	} else {
+		frw_benchmark(&t1);
+		r = fffile_readat(f->fd, b->ptr, n, off);
+	}
+
+	if (r < 0) {
+		syserrlog(f->trk, "%s: read", f->trk->conf.ifile.name);
+		return 1;
+	}
+	b->len = r;
+	b->off = off;
+	dbglog(f->trk, "%s: read: %L @%U", f->trk->conf.ifile.name, b->len, b->off);
+
+	if (frw_benchmark(&t2)) {
+		fftime_sub(&t2, &t1);
+		fftime_add(&f->stats.t_io, &t2);
+		f->stats.io_bytes += r;
+	}
+	return 0;
+}
+
+/** Get the result of the completed async operation */
+static int fr_read_complete(struct file_r *f)
+{
+	f->signalled = 0;
+	int r = fr_read(f, f->buf_pending, f->off_pending, f->len_pending, 1);
+	f->buf_pending = NULL;
+	return r;
+}
+
+/** Start reading the next block in background while the track processes the current one */
+static void fr_prefetch(struct file_r *f, phi_track *t, struct fcache_buf *cur)
+{
+	uint64 off = cur->off + cur->len;
+	if (f->buf_pending
+		|| cur->len == 0
+		|| off >= t->input.size)
+		return;
+
+	struct fcache_buf *b;
+	for (uint i = 0;  i < f->fcache.n;  i++) {
+		b = &f->fcache.bufs[i];
+		if (b->len && off == b->off)
+			return; // already cached
+	}
+
+	if (cur == (b = fcache_nextbuf(&f->fcache)))
+		b = fcache_nextbuf(&f->fcache); // don't overwrite the data we're returning
+
+	f->stats.prefetches++;
+	fr_read(f, b, off, fr_read_size(f, b), 1);
+	// Note: a synchronous error will be reported again on the next read attempt
+	fr_readahead_grow(f);
+}
+
+static void fr_unmap(struct file_r *f)
+{
+#ifdef FF_UNIX
+	if (f->map.ptr != NULL) {
+		munmap(f->map.ptr, f->map.len);
+		f->map.ptr = NULL;
+		f->map.len = 0;
+	}
+#endif
+}
+
+/** Map the file region containing data at `off`.
+Return 0 on success */
+static int fr_map(struct file_r *f, phi_track *t, uint64 off)
+{
+#ifdef FF_UNIX
+	fr_unmap(f);
+
+	uint64 off_al = ffint_align_floor2(off, MAP_WINDOW);
+	ffsize n = ffmin(MAP_WINDOW, t->input.size - off_al);
+	void *p = mmap(NULL, n, PROT_READ, MAP_SHARED, f->fd, off_al);
+	if (p == MAP_FAILED) {
+		syserrlog(t, "%s: mmap", t->conf.ifile.name);
+		return 1;
+	}
+	madvise(p, n, MADV_SEQUENTIAL);
+	madvise(p, n, MADV_WILLNEED);
+
+	f->map.ptr = p;
+	f->map.len = n;
+	f->map.off = off_al;
+	f->stats.maps++;
+	dbglog(t, "%s: mapped: %L @%U", t->conf.ifile.name, n, off_al);
+	return 0;
+#else
+	return 1;
+#endif
+}
+
+/** Return data directly from the file mapping, without copying.
+The mapping is read-only: the output isn't PHI_FWRITABLE,
+ so the filters that modify data in-place work on their own copy.
+Note: the file must not be truncated while it's mapped. */
+static int fr_map_process(struct file_r *f, phi_track *t)
+{
+	uint64 off = f->off_cur;
+	ffstr_null(&t->data_out);
+
+	if (off < t->input.size) {
+		if (!(off >= f->map.off && off < f->map.off + f->map.len)
+			&& fr_map(f, t, off))
+			return PHI_ERR;
+
+		ffstr_set(&t->data_out, f->map.ptr + (off - f->map.off), f->map.len - (off - f->map.off));
+		f->off_cur = f->map.off + f->map.len;
+	}
+
+	if (f->eof && t->data_out.len == 0)
+		return PHI_DONE;
+	f->eof = (t->data_out.len == 0);
+	return PHI_DATA;
+}
+
 static int fr_process(struct file_r *f, phi_track *t)
 {
 	if (t->input.seek != ~0ULL) {
 		f->off_cur = t->input.seek;
 		t->input.seek = ~0ULL;
 		dbglog(t, "%s: seek @%U(%xU)", t->conf.ifile.name, f->off_cur, f->off_cur);
+		f->ra.size = f->buf_cap; // random access: collapse read-ahead window
 	}
+
+	if (f->mmap)
+		return fr_map_process(f, t);
+
 	uint64 off = f->off_cur;
 
+	if (f->signalled) {
+		if (fr_read_complete(f))
+			return PHI_ERR;
+	}
+
 	struct fcache_buf *b;
 	if (NULL != (b = fcache_find(&f->fcache, off))) {
 		dbglog(t, "%s: cache hit: %L @%U", t->conf.ifile.name, b->len, b->off);
 		goto done;
 	}
 
-	b = fcache_nextbuf(&f->fcache);
+	if (f->buf_pending) {
+		// wait until the pending operation completes: we can't reuse its buffer
+		f->async = 1;
+		return PHI_ASYNC;
+	}
 
-	fftime t1, t2;
-	frw_benchmark(&t1);
+	b = fcache_nextbuf(&f->fcache);
 
 	ffuint64 off_al = ffint_align_floor2(off, ALIGN);
-	ffssize r = fffile_readat(f->fd, b->ptr, f->buf_cap, off_al);
-	if (r < 0) {
-		syserrlog(t, "%s: read", t->conf.ifile.name);
+	int r = fr_read(f, b, off_al, fr_read_size(f, b), t->input.allow_async);
+	if (r > 0)
 		return PHI_ERR;
-	}
-	b->len = r;
-	b->off = off_al;
-	dbglog(t, "%s: read: %L @%U", t->conf.ifile.name, b->len, b->off);
-
-	if (frw_benchmark(&t2)) {
-		fftime_sub(&t2, &t1);
-		fftime_add(&f->stats.t_io, &t2);
-		f->stats.io_bytes += r;
+	fr_readahead_grow(f);
+	if (r < 0) {
+		f->async = 1;
+		return PHI_ASYNC;
 	}
 
 done:
@@ -116,6 +388,9 @@ done:
 	if (f->eof && t->data_out.len == 0)
 		return PHI_DONE;
 	f->eof = (t->data_out.len == 0);
+
+	if (t->input.allow_async)
+		fr_prefetch(f, t, b);
 	return PHI_DATA;
 }
 
@@ -125,3 +400,5 @@ const phi_filter phi_file_r = {
 };
 
 #undef ALIGN
+#undef READAHEAD_MAX
+#undef MAP_WINDOW
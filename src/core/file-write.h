@@ -36,6 +36,29 @@ struct file_w {
 
 static void fw_write_done(void *param);
 
+/** Allocate kernel event object for an async operation.
+It's held only while the operation is in progress, so the track may be moved to another worker. */
+static int fw_kev_alloc(struct file_w *f)
+{
+	if (f->kev)
+		return 0;
+	if (NULL == (f->kev = core->kev_alloc(f->trk->worker)))
+		return -1;
+	f->kev->kcall.handler = fw_write_done;
+	f->kev->kcall.param = f;
+	f->trk->worker_bound++;
+	return 0;
+}
+
+static void fw_kev_free(struct file_w *f)
+{
+	if (!f->kev) return;
+
+	core->kev_free(f->trk->worker, f->kev);
+	f->kev = NULL;
+	f->trk->worker_bound--;
+}
+
 static void fw_close(void *ctx, phi_track *t)
 {
 	struct file_w *f = ctx;
@@ -76,7 +99,7 @@ static void fw_close(void *ctx, phi_track *t)
 	infolog(t, "%s: written %UKB", f->name, ffint_align_ceil2(f->size, 1024) / 1024);
 
 end:
-	core->kev_free(t->worker, f->kev);
+	fw_kev_free(f);
 	fcache_destroy(&f->bufs);
 	ffstr_free(&f->namebuf);
 	ffmem_free(f->filename_tmp);
@@ -252,11 +275,6 @@ static void* fw_open(phi_track *t)
 		fn = f->filename_tmp;
 	}
 
-	if (NULL == (f->kev = core->kev_alloc(t->worker)))
-		goto end;
-	f->kev->kcall.handler = fw_write_done;
-	f->kev->kcall.param = f;
-
 	fftime t1;
 	frw_benchmark(&t1);
 
@@ -311,8 +329,10 @@ static int fw_write(struct file_w *f, ffstr d, uint64 off, uint async)
 	async &= f->trk->output.allow_async;
 
 	ssize_t r;
-	if (async) {
+	if (async && !fw_kev_alloc(f)) {
 		r = fffile_writeat_async(f->fd, d.ptr, d.len, off, &f->kev->kcall);
+		if (!(r < 0 && fferr_last() == FFKCALL_EINPROGRESS))
+			fw_kev_free(f);
 	} else {
 		fftime t1, t2;
 		frw_benchmark(&t1);
@@ -0,0 +1,269 @@
+/** phiola: persistent metadata cache
+2026, Simon Zolin */
+
+/* The cache stores the tags and the duration of local files,
+ so the queue doesn't need to open and parse the file again while it's not modified.
+An entry is valid while the file size and modification time match.
+The entries of the deleted or modified files are removed when the cache is saved.
+
+File format (native byte order):
+	"PHIMETA2"
+	{
+		struct mc_rec
+		path[path_len]
+		meta[meta_len] // (key\0 value\0)...
+		padding[0..7]
+	}... */
+
+#include <ffsys/file.h>
+#include <ffbase/map.h>
+
+#define MC_MAGIC  "PHIMETA2"
+#define MC_FILE_LIMIT  (1*1024*1024*1024)
+
+struct mc_rec {
+	uint rec_len;
+	uint path_len;
+	uint meta_len;
+	uint length_msec;
+	uint64 file_size;
+	int64 mtime_sec;
+	uint mtime_nsec;
+	u_char reserved[4];
+};
+
+struct mc_ent {
+	struct mc_rec rec;
+	ffstr path, meta; // point either to the loaded file data or to 'buf'
+	char *buf;
+};
+
+struct meta_cache {
+	char *fn;
+	ffvec data; // file data
+	ffmap map; // path -> struct mc_ent*
+	fflock lock;
+	uint hits, misses, added;
+	uint modified :1;
+};
+
+static int mc_keyeq(void *opaque, const void *key, ffsize keylen, void *val)
+{
+	const struct mc_ent *ent = val;
+	return ffstr_eq(&ent->path, key, keylen);
+}
+
+static void mc_ent_free(struct mc_ent *ent)
+{
+	ffmem_free(ent->buf);
+	ffmem_free(ent);
+}
+
+/** Return 1 if the file hasn't been modified since the entry was added */
+static int mc_ent_match(const struct mc_ent *ent, const fffileinfo *fi)
+{
+	fftime mt = fffileinfo_mtime(fi);
+	return (ent->rec.file_size == fffileinfo_size(fi)
+		&& ent->rec.mtime_sec == mt.sec
+		&& ent->rec.mtime_nsec == mt.nsec);
+}
+
+/** Add new entry or replace the data of the existing one */
+static void mc_ent_add(struct meta_cache *mc, struct mc_ent *ent)
+{
+	struct mc_ent *old = ffmap_find(&mc->map, ent->path.ptr, ent->path.len, NULL);
+	if (old) {
+		ffmem_free(old->buf);
+		*old = *ent;
+		ffmem_free(ent);
+		return;
+	}
+	ffmap_add(&mc->map, ent->path.ptr, ent->path.len, ent);
+}
+
+/** Load cache from file */
+static void mc_load(struct meta_cache *mc)
+{
+	if (fffile_readwhole(mc->fn, &mc->data, MC_FILE_LIMIT))
+		return;
+
+	ffstr d = *(ffstr*)&mc->data;
+	if (!ffstr_match(&d, MC_MAGIC, 8)) {
+		errlog("%s: bad meta cache file", mc->fn);
+		return;
+	}
+	ffstr_shift(&d, 8);
+
+	while (d.len >= sizeof(struct mc_rec)) {
+		const struct mc_rec *r = (void*)d.ptr;
+		if (r->rec_len > d.len
+			|| sizeof(struct mc_rec) + r->path_len + r->meta_len > r->rec_len) {
+			errlog("%s: meta cache file is corrupted", mc->fn);
+			break;
+		}
+
+		struct mc_ent *ent = ffmem_new(struct mc_ent);
+		ent->rec = *r;
+		ffstr_set(&ent->path, d.ptr + sizeof(struct mc_rec), r->path_len);
+		ffstr_set(&ent->meta, ent->path.ptr + r->path_len, r->meta_len);
+		mc_ent_add(mc, ent);
+		ffstr_shift(&d, r->rec_len);
+	}
+
+	dbglog("%s: meta cache: loaded %u entries", mc->fn, (int)mc->map.len);
+}
+
+/** Save cache to file */
+static void mc_save(struct meta_cache *mc)
+{
+	if (!mc->modified)
+		return;
+
+	ffvec buf = {};
+	ffvec_add(&buf, MC_MAGIC, 8, 1);
+	uint n = 0, pruned = 0;
+
+	struct _ffmap_item *it;
+	FFMAP_WALK(&mc->map, it) {
+		if (!_ffmap_item_occupied(it))
+			continue;
+		const struct mc_ent *ent = it->val;
+
+		fffileinfo fi;
+		char *fn = ffsz_dupstr(&ent->path);
+		int valid = (!fffile_info_path(fn, &fi) && mc_ent_match(ent, &fi));
+		ffmem_free(fn);
+		if (!valid) {
+			pruned++;
+			continue;
+		}
+		n++;
+
+		struct mc_rec r = ent->rec;
+		r.path_len = ent->path.len;
+		r.meta_len = ent->meta.len;
+		r.rec_len = ffint_align_ceil2(sizeof(struct mc_rec) + r.path_len + r.meta_len, 8);
+		ffvec_grow(&buf, r.rec_len, 1);
+		char *p = (char*)buf.ptr + buf.len;
+		ffmem_zero(p, r.rec_len);
+		ffmem_copy(p, &r, sizeof(r));
+		ffmem_copy(p + sizeof(r), ent->path.ptr, r.path_len);
+		ffmem_copy(p + sizeof(r) + r.path_len, ent->meta.ptr, r.meta_len);
+		buf.len += r.rec_len;
+	}
+
+	char *fn_tmp = ffsz_allocfmt("%s.tmp", mc->fn);
+	if (fffile_writewhole(fn_tmp, buf.ptr, buf.len, 0)) {
+		syserrlog("file write: %s", fn_tmp);
+	} else if (fffile_rename(fn_tmp, mc->fn)) {
+		syserrlog("file rename: %s", mc->fn);
+	} else {
+		dbglog("%s: meta cache: saved %u entries, removed %u", mc->fn, n, pruned);
+	}
+	ffmem_free(fn_tmp);
+	ffvec_free(&buf);
+}
+
+static struct meta_cache* mc_create(const char *fn)
+{
+	struct meta_cache *mc = ffmem_new(struct meta_cache);
+	mc->fn = ffsz_dup(fn);
+	ffmap_init(&mc->map, mc_keyeq);
+	mc_load(mc);
+	return mc;
+}
+
+static void mc_free(struct meta_cache *mc)
+{
+	if (!mc) return;
+
+	dbglog("meta cache: hits:%u  misses:%u  added:%u", mc->hits, mc->misses, mc->added);
+	mc_save(mc);
+
+	struct _ffmap_item *it;
+	FFMAP_WALK(&mc->map, it) {
+		if (_ffmap_item_occupied(it))
+			mc_ent_free(it->val);
+	}
+	ffmap_free(&mc->map);
+	ffvec_free(&mc->data);
+	ffmem_free(mc->fn);
+	ffmem_free(mc);
+}
+
+/** Fill the entry with the cached data.
+Return 0 if found */
+static int mc_find(struct meta_cache *mc, struct phi_queue_entry *qe)
+{
+	fffileinfo fi;
+	if (fffile_info_path(qe->url, &fi))
+		return -1;
+
+	int rc = -1;
+	fflock_lock(&mc->lock);
+
+	ffsize len = ffsz_len(qe->url);
+	const struct mc_ent *ent = ffmap_find(&mc->map, qe->url, len, NULL);
+	if (!ent || !mc_ent_match(ent, &fi)) {
+		if (ent)
+			mc->modified = 1; // the entry will be replaced or removed on save
+		mc->misses++;
+		goto end;
+	}
+
+	fflock_lock((fflock*)&qe->lock);
+	core->metaif->destroy(&qe->meta);
+	ffstr d = ent->meta, k, v;
+	while (d.len) {
+		ffstr_splitby(&d, '\0', &k, &d);
+		ffstr_splitby(&d, '\0', &v, &d);
+		core->metaif->set(&qe->meta, k, v, 0);
+	}
+	qe->length_sec = ent->rec.length_msec / 1000;
+	fflock_unlock((fflock*)&qe->lock);
+
+	mc->hits++;
+	rc = 0;
+
+end:
+	fflock_unlock(&mc->lock);
+	return rc;
+}
+
+/** Add or replace the cache entry with the data from a meta-reading track */
+static void mc_add(struct meta_cache *mc, const struct phi_queue_entry *qe, const phi_track *t)
+{
+	ffvec meta = {};
+	uint i = 0;
+	ffstr k, v;
+	while (core->metaif->list(&qe->meta, &i, &k, &v, 0)) {
+		ffvec_addfmt(&meta, "%S%Z%S%Z", &k, &v);
+	}
+
+	ffsize path_len = ffsz_len(qe->url);
+	struct mc_ent *ent = ffmem_new(struct mc_ent);
+	char *p = ent->buf = ffmem_alloc(path_len + meta.len);
+	ffmem_copy(p, qe->url, path_len);
+	ffstr_set(&ent->path, p, path_len);
+	ffmem_copy(p + path_len, meta.ptr, meta.len);
+	ffstr_set(&ent->meta, p + path_len, meta.len);
+	ffvec_free(&meta);
+
+	fftime mt = t->input.mtime;
+	mt.sec -= FFTIME_1970_SECONDS; // file-read adds the offset
+	ent->rec.file_size = t->input.size;
+	ent->rec.mtime_sec = mt.sec;
+	ent->rec.mtime_nsec = mt.nsec;
+	ent->rec.length_msec = qe->length_sec * 1000;
+	if (t->audio.total != ~0ULL && t->audio.format.rate)
+		ent->rec.length_msec = samples_to_msec(t->audio.total, t->audio.format.rate);
+
+	fflock_lock(&mc->lock);
+	mc_ent_add(mc, ent);
+	mc->added++;
+	mc->modified = 1;
+	fflock_unlock(&mc->lock);
+}
+
+#undef MC_MAGIC
+#undef MC_FILE_LIMIT
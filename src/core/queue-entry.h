@@ -152,7 +152,13 @@ static void qe_close(void *f, phi_track *t)
 			flags |= Q_TKCL_STOP;
 		flags |= (!t->q_notified) ? Q_TKCL_NEXT : 0;
 		flags |= (t->meta_reading) ? Q_TKCL_META_READ : 0;
-		q_ent_closed(e->q, flags);
+		if (t->meta_reading
+			&& qm->meta_cache
+			&& !t->error
+			&& !e->pub.meta_priority
+			&& t->input.mtime.sec != 0) // local file
+			mc_add(qm->meta_cache, &e->pub, t);
+		q_ent_closed(e->q, e, flags);
 	}
 	qe_unref(e);
 }
@@ -198,7 +204,8 @@ static int qagt_process(void *f, phi_track *t)
 				core->metaif->copy(&e->pub.meta, &t->meta, 0); // Remember the tags we read from file
 				fflock_unlock((fflock*)&e->pub.lock);
 
-				qm->on_change(e->q, 'm', qe_index(e));
+				if (!t->meta_reading) // meta-reading tracks are reported by the main worker
+					qm->on_change(e->q, 'm', qe_index(e));
 				q_modified(e->q);
 			}
 		}
@@ -213,7 +220,7 @@ static int qagt_process(void *f, phi_track *t)
 		&& !(t->chain_flags & (PHI_FSTOP | PHI_FSTOP_AFTER)) // not stopped by user
 		&& t->playback) {
 		// Playback track is finishing
-		q_ent_closed(e->q, Q_TKCL_FIN);
+		q_ent_closed(e->q, e, Q_TKCL_FIN);
 		t->q_notified = 1;
 	}
 
@@ -231,6 +238,10 @@ enum {
 	FMC_DAN = 4,
 	FMC_UI = 6,
 	FMC_GAIN,
+	FMC_SIL,
+	FMC_SPLIT = 10,
+	FMC_WRITE,
+	FMC_OUTPUT,
 };
 static struct filter_map FF_STRUCTALIGN(64) convert_f_map[] = {
 	{ "",						1, &phi_queue_guard },
@@ -241,15 +252,17 @@ static struct filter_map FF_STRUCTALIGN(64) convert_f_map[] = {
 	{ "",						1, &queue_agent },
 	{ "",						1, NULL },
 	{ "afilter.gain",			0, NULL },
+	{ "afilter.silence",		0, NULL },
 	{ "afilter.auto-conv",		1, NULL },
+	{ "afilter.split",			0, NULL },
 	{ "format.auto-write",		1, NULL },
 	{ "core.auto-output",		1, NULL },
 	{ FM_END,					0, NULL }
 };
 
 enum {
-	FMA_UI = 5,
-	FMA_AC,
+	FMA_BATCH = 3,
+	FMA_UI = 6,
 	FMA_PK,
 	FMA_LD,
 };
@@ -257,12 +270,12 @@ static struct filter_map FF_STRUCTALIGN(64) analyze_f_map[] = {
 	{ "",						1, &phi_queue_guard },
 	{ "core.auto-input",		1, NULL },
 	{ "format.detect",			1, NULL },
+	{ "afilter.batch",			0, NULL },
 	{ "afilter.until",			1, NULL },
 	{ "",						1, &queue_agent },
 	{ "",						1, NULL },
-	{ "afilter.auto-conv-f",	0, NULL },
 	{ "afilter.peaks",			0, NULL },
-	{ "af-loudness.analyze",	0, NULL },
+	{ "afilter.loudness",		0, NULL },
 	{ FM_END,					0, NULL }
 };
 
@@ -289,7 +302,7 @@ static struct filter_map FF_STRUCTALIGN(64) play_f_map[] = {
 	{ "afilter.auto-conv-f",	0, NULL },
 	{ "af-loudness.analyze",	0, NULL },
 	{ "afilter.auto-norm",		0, NULL },
-	{ "af-sox.sox",				0, NULL },
+	{ "afilter.eq",				0, NULL },
 	{ "afilter.gain",			1, NULL },
 	{ "afilter.auto-conv",		1, NULL },
 	{ "core.tee",				0, NULL },
@@ -327,16 +340,22 @@ static int qe_play(struct q_entry *e, uint flags)
 		m[FMC_DAN].use = !!c.afilter.danorm;
 		m[FMC_UI].iface = ui_if;
 		m[FMC_GAIN].use = c.afilter.gain_db;
+		m[FMC_SIL].use = (c.afilter.silence || c.split_silence);
+		m[FMC_SPLIT].use = (c.split_msec || c.split_silence);
+		m[FMC_WRITE].use = !m[FMC_SPLIT].use;
+		m[FMC_OUTPUT].use = !m[FMC_SPLIT].use;
+		t->input.allow_async = 1;
 		t->output.allow_async = 1;
 
 	} else if (e->q->conf.analyze) {
 		FF_ASSERT(sizeof(m) >= sizeof(analyze_f_map));
 		ffmem_copy(m, analyze_f_map, sizeof(analyze_f_map));
 		gm = analyze_f_map;
+		m[FMA_BATCH].use = (c.afilter.peaks_info || c.afilter.loudness_summary);
 		m[FMA_UI].iface = ui_if;
-		m[FMA_AC].use = (c.afilter.peaks_info || c.afilter.loudness_summary);
 		m[FMA_PK].use = c.afilter.peaks_info;
 		m[FMA_LD].use = c.afilter.loudness_summary;
+		t->input.allow_async = 1;
 
 	} else {
 		FF_ASSERT(sizeof(m) >= sizeof(play_f_map));
@@ -349,7 +368,8 @@ static int qe_play(struct q_entry *e, uint flags)
 		m[FMP_AC].use = !!c.afilter.auto_normalizer;
 		m[FMP_LD].use = !!c.afilter.auto_normalizer;
 		m[FMP_AN].use = !!c.afilter.auto_normalizer;
-		m[FMP_EQ].use = !!c.afilter.equalizer;
+		// always in the chain, so that the settings can be enabled via phi_equalizer_if.update() while playing
+		m[FMP_EQ].use = 1;
 		ffsz_copyz(m[FMP_AO].name, sizeof(m[FMP_AO].name), core->conf.audio_out_module);
 
 		t->oaudio.clear = !!(flags & Q_PL_MANUAL);
@@ -469,11 +489,21 @@ end:
 	return rc;
 }
 
-static void qe_read_meta(struct q_entry *e)
+/** Read metadata from cache or start a meta-reading track.
+Return 0 if the track is started */
+static int qe_read_meta(struct q_entry *e)
 {
+	if (qm->meta_cache
+		&& !e->pub.meta_priority
+		&& !mc_find(qm->meta_cache, &e->pub)) {
+		qm->on_change(e->q, 'm', qe_index(e));
+		return 1;
+	}
+
 	struct phi_track_conf c = e->q->conf.tconf;
 	c.ifile.name = e->pub.url;
 	c.info_only = 1;
+	c.cross_worker_assign = 1; // read several files in parallel
 	phi_track *t = core->track->create(&c);
 	core->track->filter(t, &phi_queue_guard, 0);
 	core->track->filter(t, core->mod("core.auto-input"), 0);
@@ -486,6 +516,7 @@ static void qe_read_meta(struct q_entry *e)
 	t->meta_reading = 1;
 	t->qent = &e->pub;
 	core->track->start(t);
+	return 0;
 }
 
 static void qe_stop(struct q_entry *e)
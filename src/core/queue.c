@@ -22,6 +22,7 @@ struct queue_mgr {
 	uint random_ready :1;
 	on_change_t on_change;
 	struct q_entry *cursor;
+	struct meta_cache *meta_cache;
 };
 static struct queue_mgr *qm;
 
@@ -35,6 +36,9 @@ struct phi_queue {
 	uint cursor_index;
 	uint active_n, finished_n;
 	uint track_closed_flags;
+	uint meta_next; // index of the next entry to read meta from
+	uint meta_active; // N of meta-reading tracks in flight
+	ffvec meta_done; // struct q_entry*[]: entries whose meta-reading track has finished
 	uint closing :1;
 	uint random_split :1;
 	uint random_init :1;
@@ -61,10 +65,12 @@ enum Q_TKCL_F {
 	Q_TKCL_NEXT = 8,
 	Q_TKCL_FIN = 0x10,
 };
-static void q_ent_closed(struct phi_queue *q, uint flags);
+static void q_ent_closed(struct phi_queue *q, struct q_entry *e, uint flags);
 static void q_modified(struct phi_queue *q);
 static void q_rename_next(struct phi_queue *q);
+static void q_read_meta_next(struct phi_queue *q);
 
+#include <core/meta-cache.h>
 #include <core/queue-entry.h>
 
 static void q_on_change(phi_queue_id q, uint flags, uint pos){}
@@ -77,6 +83,7 @@ void qm_destroy()
 		q_free(*q);
 	}
 	ffvec_free(&qm->lists);
+	mc_free(qm->meta_cache);
 	ffmem_free(qm);
 }
 
@@ -163,6 +170,7 @@ static void q_free(struct phi_queue *q)
 		return;
 	}
 
+	ffvec_free(&q->meta_done);
 	ffmem_free(q->conf.tconf.ofile.name);
 	ffmem_free(q->conf.tconf.afilter.equalizer);
 	ffslice_free(&q->conf.tconf.tracks);
@@ -410,21 +418,23 @@ static void q_trk_closed(void *param)
 	fflock_lock(&q->lock);
 	uint n = FF_SWAP(&q->finished_n, 0);
 	uint flags = FF_SWAP(&q->track_closed_flags, 0);
+	ffvec meta_done = q->meta_done;
+	ffvec_null(&q->meta_done);
 	fflock_unlock(&q->lock);
 
 	q->active_n -= n;
 
-	if (flags & Q_TKCL_META_READ) {
-		struct q_entry *e = q->cursor;
-		if (!e)
-			return;
-		uint i = qe_index(e);
-		qm->on_change(q, 'm', i);
-		if (!(e = q_get(q, i + 1)))
-			return;
-		q->cursor = e;
-		qe_read_meta(e);
-		return;
+	if (meta_done.len) {
+		q->meta_active -= meta_done.len;
+		struct q_entry **it;
+		FFSLICE_WALK(&meta_done, it) {
+			int i = qe_index(*it);
+			if (i >= 0) // the entry is still in the list
+				qm->on_change(q, 'm', i);
+			qe_unref(*it);
+		}
+		ffvec_free(&meta_done);
+		q_read_meta_next(q);
 	}
 
 	if ((flags & (Q_TKCL_STOP | Q_TKCL_NEXT)) == Q_TKCL_NEXT) {
@@ -445,8 +455,9 @@ static void q_trk_closed(void *param)
 }
 
 /**
+e: the entry whose track has finished reading meta
 Thread: worker */
-static void q_ent_closed(struct phi_queue *q, uint flags)
+static void q_ent_closed(struct phi_queue *q, struct q_entry *e, uint flags)
 {
 	dbglog("%s  flags:%u", __func__, flags);
 
@@ -472,7 +483,14 @@ static void q_ent_closed(struct phi_queue *q, uint flags)
 	}
 
 	fflock_lock(&q->lock);
-	q->track_closed_flags = flags;
+	if (flags & Q_TKCL_META_READ) {
+		// several meta-reading tracks may finish before we handle the signal;
+		//  the main worker notifies about them (on_change('m'))
+		*ffvec_pushT(&q->meta_done, struct q_entry*) = qe_ref(e);
+	} else {
+		// a meta-reading track closed in the same batch must not hide these flags
+		q->track_closed_flags |= flags;
+	}
 	uint signal = (q->finished_n == 0);
 	q->finished_n++;
 	FF_ASSERT(q->finished_n <= q->active_n);
@@ -742,15 +760,35 @@ static void q_sort(phi_queue_id q, uint flags)
 	qm->on_change(q, 'u', 0);
 }
 
+/** Start reading meta from the next entries, keeping no more than 2 tracks per worker in flight.
+Thread: main */
+static void q_read_meta_next(struct phi_queue *q)
+{
+	uint window = ffmax(core->conf.workers, 1) * 2;
+	while (q->meta_active < window) {
+		struct q_entry *e = q_get(q, q->meta_next);
+		if (!e)
+			break;
+		q->meta_next++;
+		if (!qe_read_meta(e))
+			q->meta_active++;
+	}
+}
+
 static void q_read_meta(phi_queue_id q)
 {
 	if (!q) q = qm_default();
 
-	struct q_entry *e = q_get(q, 0);
-	if (!e) return;
+	q->meta_next = 0;
+	q_read_meta_next(q);
+}
 
-	q->cursor = e;
-	qe_read_meta(e);
+static int q_meta_cache(const char *filename)
+{
+	if (qm->meta_cache)
+		return -1;
+	qm->meta_cache = mc_create(filename);
+	return 0;
 }
 
 static void q_rename_next(struct phi_queue *q)
@@ -881,4 +919,5 @@ const phi_queue_if phi_queueif = {
 	(void*)qe_index,
 	(void*)qe_remove,
 	(void*)qe_rename,
+	q_meta_cache,
 };
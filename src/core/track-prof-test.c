@@ -0,0 +1,40 @@
+/** phiola: test: per-filter profiler
+2026, Simon Zolin
+
+Checks the histogram of the filter call durations.
+Usage:
+	track-prof-test
+*/
+
+#include <track.h>
+#include <ffsys/std.h>
+#include <ffbase/vector.h>
+
+const phi_core *core;
+#define infolog(t, ...)  phi_infolog(core, "track", t, __VA_ARGS__)
+
+#include <core/track-prof.h>
+
+#define x(expr) \
+	if (!(expr)) { \
+		ffstdout_fmt("FAILED: %s\n", #expr); \
+		return 1; \
+	}
+
+int main()
+{
+	x(prof_bucket(0) == 0);
+	x(prof_bucket(1) == 0);
+	x(prof_bucket(1000) == 9); // 1usec: 512..1023
+	x(prof_bucket(1024) == 10);
+	x(prof_bucket(1000000) == 19); // 1msec
+	x(prof_bucket(~0ULL) == 39);
+
+	struct filter_prof fp = {};
+	prof_call(&fp, 1000000, 0, 0);
+	x(fp.hist[19] == 1);
+	x(prof_percentile(&fp, 50) == 1048576);
+
+	ffstdout_fmt("OK\n");
+	return 0;
+}
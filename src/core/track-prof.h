@@ -0,0 +1,157 @@
+/** phiola: per-filter profiler
+2026, Simon Zolin */
+
+/* Enabled by phi_track_conf.print_time.
+Per-track statistics are printed in JSON format when the track is closed;
+ the summary for all tracks is printed when Core is destroyed. */
+
+#define PROF_BUCKETS  40
+
+struct filter_prof {
+	uint64 calls;
+	uint64 bytes_in, bytes_out;
+	uint64 busy_nsec;
+	uint64 async_nsec; // time spent waiting for the filter's async operation
+	uint64 hist[PROF_BUCKETS]; // [i]: N of calls that took 2^i..2^(i+1)-1 nsec
+};
+
+struct track_prof {
+	struct filter_prof filters[MAX_FILTERS];
+	fftime t_async; // the time when the track was suspended
+	uint64 t_wake_nsec; // the time when the track was put to the worker's queue.  Written by any thread.
+	uint async_filter;
+	uint64 wakes; // Written by any thread
+	uint64 queue_wait_nsec; // time spent in the worker's queue
+};
+
+/** Summary for a filter across all tracks */
+struct filter_prof_total {
+	char name[16]; // filter interface may be unloaded at the time we print the summary
+	struct filter_prof st;
+};
+
+static uint64 prof_nsec(fftime t)
+{
+	return (uint64)t.sec * 1000000000 + t.nsec;
+}
+
+static uint64 prof_elapsed(fftime since)
+{
+	fftime now = core->time(NULL, PHI_CORE_TIME_MONOTONIC);
+	fftime_sub(&now, &since);
+	return prof_nsec(now);
+}
+
+/** Get histogram bucket index for the call duration */
+static uint prof_bucket(uint64 nsec)
+{
+	if (nsec == 0)
+		return 0;
+	// ffbit_find64() returns the position of the most significant bit counting from the left
+	return ffmin(64 - ffbit_find64(nsec), PROF_BUCKETS - 1);
+}
+
+static void prof_call(struct filter_prof *fp, uint64 nsec, ffsize in, ffsize out)
+{
+	fp->calls++;
+	fp->bytes_in += in;
+	fp->bytes_out += out;
+	fp->busy_nsec += nsec;
+	fp->hist[prof_bucket(nsec)]++;
+}
+
+/** Get the upper bound of the call latency for the specified percentile */
+static uint64 prof_percentile(const struct filter_prof *fp, uint percent)
+{
+	uint64 need = (fp->calls * percent + 99) / 100, n = 0;
+	for (uint i = 0;  i < PROF_BUCKETS;  i++) {
+		n += fp->hist[i];
+		if (n >= need)
+			return 2ULL << i;
+	}
+	return 0;
+}
+
+static void prof_add(struct filter_prof *dst, const struct filter_prof *src)
+{
+	dst->calls += src->calls;
+	dst->bytes_in += src->bytes_in;
+	dst->bytes_out += src->bytes_out;
+	dst->busy_nsec += src->busy_nsec;
+	dst->async_nsec += src->async_nsec;
+	for (uint i = 0;  i < PROF_BUCKETS;  i++) {
+		dst->hist[i] += src->hist[i];
+	}
+}
+
+static void prof_filter_json(ffvec *buf, const char *name, const struct filter_prof *fp)
+{
+	ffvec_addfmt(buf, "{\"name\":\"%s\",\"calls\":%U,\"bytes_in\":%U,\"bytes_out\":%U"
+		",\"busy_usec\":%U,\"async_usec\":%U,\"p50_usec\":%U,\"p99_usec\":%U},"
+		, name, fp->calls, fp->bytes_in, fp->bytes_out
+		, fp->busy_nsec / 1000, fp->async_nsec / 1000
+		, prof_percentile(fp, 50) / 1000, prof_percentile(fp, 99) / 1000);
+}
+
+/** Print per-filter statistics for the track */
+static void prof_track_print(phi_track *t, const struct track_prof *tp)
+{
+	ffvec buf = {};
+	ffvec_addfmt(&buf, "{\"track\":\"%s\",\"wakes\":%U,\"queue_wait_usec\":%U,\"filters\":["
+		, t->id, tp->wakes, tp->queue_wait_nsec / 1000);
+
+	const struct filter *f;
+	FF_FOREACH(t->conveyor.filters_pool, f) {
+		const struct filter_prof *fp = &tp->filters[f - t->conveyor.filters_pool];
+		if (fp->calls == 0)
+			continue;
+		prof_filter_json(&buf, f->iface->name, fp);
+	}
+	if (((char*)buf.ptr)[buf.len - 1] == ',')
+		buf.len--;
+	ffvec_addfmt(&buf, "]}");
+
+	infolog(t, "profile: %S", &buf);
+	ffvec_free(&buf);
+}
+
+/** Add the track's statistics to the summary */
+static void prof_total_add(ffvec *total, const phi_track *t, const struct track_prof *tp)
+{
+	const struct filter *f;
+	FF_FOREACH(t->conveyor.filters_pool, f) {
+		const struct filter_prof *fp = &tp->filters[f - t->conveyor.filters_pool];
+		if (fp->calls == 0)
+			continue;
+
+		struct filter_prof_total *it;
+		FFSLICE_WALK(total, it) {
+			if (ffsz_eq(it->name, f->iface->name))
+				goto add;
+		}
+		it = ffvec_zpushT(total, struct filter_prof_total);
+		ffsz_copyz(it->name, sizeof(it->name), f->iface->name);
+	add:
+		prof_add(&it->st, fp);
+	}
+}
+
+static void prof_total_print(const ffvec *total, uint64 tracks, uint64 queue_wait_nsec)
+{
+	ffvec buf = {};
+	ffvec_addfmt(&buf, "{\"tracks\":%U,\"queue_wait_usec\":%U,\"filters\":["
+		, tracks, queue_wait_nsec / 1000);
+
+	const struct filter_prof_total *it;
+	FFSLICE_WALK(total, it) {
+		prof_filter_json(&buf, it->name, &it->st);
+	}
+	if (((char*)buf.ptr)[buf.len - 1] == ',')
+		buf.len--;
+	ffvec_addfmt(&buf, "]}");
+
+	infolog(NULL, "profile summary: %S", &buf);
+	ffvec_free(&buf);
+}
+
+#undef PROF_BUCKETS
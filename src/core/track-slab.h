@@ -0,0 +1,189 @@
+/** phiola: per-worker cache of track pages and arena chunks
+2026, Simon Zolin */
+
+/* Each track object occupies a 4KB page; the rest of the page is used for filter data.
+Filter data that doesn't fit into the page is allocated from the track's arena:
+ a list of 16KB chunks which are released all at once when the track is closed.
+Only the objects larger than a chunk are allocated from heap.
+Objects that may outlive the track (file reader, audio server, parallel FLAC encoder)
+ must be allocated with ffmem_new() by the filter itself.
+Released pages and chunks are zeroed (only the used part) and kept in the worker's slab,
+ so the next track gets the pre-zeroed memory without calling the system allocator.
+
+Audio buffers (phi_track_if.buf_alloc()) are cached by size class (power of 2: 64KB..4MB).
+They aren't zeroed and may be returned on any worker. */
+
+#define TRACK_PAGE  4096
+#define ARENA_CHUNK  (16*1024)
+#define SLAB_PAGES_MAX  64
+#define SLAB_CHUNKS_MAX  64
+#define SLAB_BUF_MIN_SHIFT  16
+#define SLAB_BUF_CLASSES  7 // 64KB..4MB
+#define SLAB_BUFS_MAX  8 // per class
+#define SLAB_BUF_HDR  64
+
+struct arena_chunk {
+	struct arena_chunk *next;
+	uint size; // used bytes (including header)
+};
+#define ARENA_HDR  64
+
+struct slab_item {
+	struct slab_item *next;
+};
+
+struct track_slab {
+	fflock lock;
+	struct slab_item *pages, *chunks;
+	uint n_pages, n_chunks;
+	struct slab_item *bufs[SLAB_BUF_CLASSES];
+	uint n_bufs[SLAB_BUF_CLASSES];
+
+	// stats
+	uint64 page_hits, page_allocs;
+	uint64 chunk_hits, chunk_allocs;
+	uint64 buf_hits, buf_allocs;
+	uint64 arena_allocs, heap_allocs; // filter data that didn't fit into the track page
+} FF_STRUCTALIGN(64);
+
+static void* slab_pop(struct track_slab *s, struct slab_item **list, uint *n, uint64 *hits, uint64 *allocs)
+{
+	fflock_lock(&s->lock);
+	struct slab_item *it = *list;
+	if (it != NULL) {
+		*list = it->next;
+		(*n)--;
+		(*hits)++;
+		it->next = NULL;
+	} else {
+		(*allocs)++;
+	}
+	fflock_unlock(&s->lock);
+	return it;
+}
+
+/** Put the object to the cache.
+Return 0 if the cache is full and the object should be freed */
+static int slab_push(struct track_slab *s, struct slab_item **list, uint *n, uint limit, void *ptr)
+{
+	int r = 0;
+	fflock_lock(&s->lock);
+	if (*n < limit) {
+		struct slab_item *it = ptr;
+		it->next = *list;
+		*list = it;
+		(*n)++;
+		r = 1;
+	}
+	fflock_unlock(&s->lock);
+	return r;
+}
+
+/** Get a zeroed track page */
+static void* slab_page_alloc(struct track_slab *s)
+{
+	void *p;
+	if (NULL == (p = slab_pop(s, &s->pages, &s->n_pages, &s->page_hits, &s->page_allocs))) {
+		if (NULL == (p = ffmem_align(TRACK_PAGE, TRACK_PAGE)))
+			return NULL;
+		ffmem_zero(p, TRACK_PAGE);
+	}
+	return p;
+}
+
+/**
+used: the number of bytes that might have been modified */
+static void slab_page_free(struct track_slab *s, void *p, ffsize used)
+{
+	ffmem_zero(p, used);
+	if (!slab_push(s, &s->pages, &s->n_pages, SLAB_PAGES_MAX, p))
+		ffmem_alignfree(p);
+}
+
+static struct arena_chunk* slab_chunk_alloc(struct track_slab *s)
+{
+	struct arena_chunk *c;
+	if (NULL == (c = slab_pop(s, &s->chunks, &s->n_chunks, &s->chunk_hits, &s->chunk_allocs))) {
+		if (NULL == (c = ffmem_align(ARENA_CHUNK, 64)))
+			return NULL;
+		ffmem_zero(c, ARENA_CHUNK);
+	}
+	c->size = ARENA_HDR;
+	return c;
+}
+
+static void slab_chunk_free(struct track_slab *s, struct arena_chunk *c)
+{
+	ffmem_zero(c, c->size);
+	if (!slab_push(s, &s->chunks, &s->n_chunks, SLAB_CHUNKS_MAX, c))
+		ffmem_alignfree(c);
+}
+
+/** Audio buffer header */
+struct slab_buf {
+	uint cls; // size class; -1: not cached
+};
+
+/** Get an audio buffer of at least 'n' bytes (not zeroed) */
+static void* slab_buf_alloc(struct track_slab *s, ffsize n)
+{
+	uint cls = ~0U;
+	ffsize cap = n;
+	if (n <= ((ffsize)1 << (SLAB_BUF_MIN_SHIFT + SLAB_BUF_CLASSES - 1))) {
+		cls = 0;
+		while (((ffsize)1 << (SLAB_BUF_MIN_SHIFT + cls)) < n) {
+			cls++;
+		}
+		cap = (ffsize)1 << (SLAB_BUF_MIN_SHIFT + cls);
+	}
+
+	struct slab_buf *b = NULL;
+	if (cls != ~0U)
+		b = slab_pop(s, &s->bufs[cls], &s->n_bufs[cls], &s->buf_hits, &s->buf_allocs);
+	if (b == NULL) {
+		if (NULL == (b = ffmem_align(SLAB_BUF_HDR + cap, 64)))
+			return NULL;
+	}
+	b->cls = cls;
+	return (u_char*)b + SLAB_BUF_HDR;
+}
+
+static void slab_buf_free(struct track_slab *s, void *ptr)
+{
+	struct slab_buf *b = (void*)((u_char*)ptr - SLAB_BUF_HDR);
+	if (b->cls == ~0U
+		|| !slab_push(s, &s->bufs[b->cls], &s->n_bufs[b->cls], SLAB_BUFS_MAX, b))
+		ffmem_alignfree(b);
+}
+
+static void slab_stats_add(struct track_slab *s, uint arena_allocs, uint heap_allocs)
+{
+	fflock_lock(&s->lock);
+	s->arena_allocs += arena_allocs;
+	s->heap_allocs += heap_allocs;
+	fflock_unlock(&s->lock);
+}
+
+static void slab_destroy(struct track_slab *s)
+{
+	struct slab_item *it, *next;
+	for (it = s->pages;  it != NULL;  it = next) {
+		next = it->next;
+		ffmem_alignfree(it);
+	}
+	for (it = s->chunks;  it != NULL;  it = next) {
+		next = it->next;
+		ffmem_alignfree(it);
+	}
+	s->pages = s->chunks = NULL;
+	s->n_pages = s->n_chunks = 0;
+
+	for (uint i = 0;  i < SLAB_BUF_CLASSES;  i++) {
+		for (it = s->bufs[i];  it != NULL;  it = next) {
+			next = it->next;
+			ffmem_alignfree(it);
+		}
+		s->bufs[i] = NULL;
+		s->n_bufs[i] = 0;
+	}
+}
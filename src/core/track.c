@@ -3,8 +3,14 @@
 
 #include <track.h>
 #include <ffsys/perf.h>
+#include <ffsys/thread.h>
 #include <ffbase/list.h>
 #include <ffbase/vector.h>
+#include <util/wakeq.h>
+
+// phi_track.wake is an opaque storage for ffwakeq_node
+_Static_assert(sizeof(((phi_track*)0)->wake) >= sizeof(ffwakeq_node), "phi_track.wake: size");
+_Static_assert(__alignof__(((phi_track*)0)->wake) >= __alignof__(ffwakeq_node), "phi_track.wake: alignment");
 
 extern const phi_core *core;
 #define syserrlog(t, ...)  phi_syserrlog(core, "track", t, __VA_ARGS__)
@@ -14,8 +20,14 @@ extern const phi_core *core;
 #define dbglog(t, ...)  phi_dbglog(core, "track", t, __VA_ARGS__)
 #define extralog(t, ...)  phi_extralog(core, "track", t, __VA_ARGS__)
 
+#include <core/track-prof.h>
+#include <core/track-slab.h>
+
+extern void core_track_wake(uint worker, ffwakeq_node *n, phi_task_func func);
+
 static void conveyor_close(struct phi_conveyor *v, phi_track *t);
 static void track_wake(phi_track *t);
+static void track_run(phi_track *t);
 
 static struct filter* conveyor_filter_cur(struct phi_conveyor *v)
 {
@@ -37,24 +49,73 @@ enum STATE {
 
 	/** User's stop-signal is being processed by the track filters */
 	ST_STOPPING,
+
+	/** Track is being moved to another worker;
+	the new worker sets ST_RUNNING when it starts processing the track */
+	ST_MOVING, // ->ST_RUNNING
 };
 
-struct track_ctx {
+/** Active tracks started on a worker */
+struct track_list {
 	fflist tracks;
-	fflock tracks_lock;
+	fflock lock;
+} FF_STRUCTALIGN(64);
+
+struct track_ctx {
+	struct track_list *lists; // [workers]
 	uint cur_id;
+
+	struct track_slab *slabs; // [workers]
+	uint n_slabs;
+
+	struct {
+		fflock lock;
+		ffvec filters; // struct filter_prof_total[]
+		uint64 tracks;
+		uint64 queue_wait_nsec;
+	} prof;
 };
 static struct track_ctx *tx;
 
 void tracks_init()
 {
 	tx = ffmem_new(struct track_ctx);
-	fflist_init(&tx->tracks);
 	tx->cur_id = 1;
+
+	tx->n_slabs = ffmax(core->conf.workers, 1);
+	tx->slabs = ffmem_align(tx->n_slabs * sizeof(struct track_slab), 64);
+	ffmem_zero(tx->slabs, tx->n_slabs * sizeof(struct track_slab));
+
+	tx->lists = ffmem_align(tx->n_slabs * sizeof(struct track_list), 64);
+	ffmem_zero(tx->lists, tx->n_slabs * sizeof(struct track_list));
+	for (uint i = 0;  i < tx->n_slabs;  i++) {
+		fflist_init(&tx->lists[i].tracks);
+	}
+}
+
+static struct track_slab* track_slab(uint worker)
+{
+	return &tx->slabs[worker % tx->n_slabs];
 }
 
 void tracks_destroy()
 {
+	if (tx->prof.tracks)
+		prof_total_print(&tx->prof.filters, tx->prof.tracks, tx->prof.queue_wait_nsec);
+	ffvec_free(&tx->prof.filters);
+
+	struct track_slab *s;
+	for (uint i = 0;  i < tx->n_slabs;  i++) {
+		s = &tx->slabs[i];
+		dbglog(NULL, "worker #%u: track pages:%U/%U  arena chunks:%U/%U  overflow: arena:%U heap:%U  audio buffers:%U/%U"
+			, i, s->page_hits, s->page_hits + s->page_allocs
+			, s->chunk_hits, s->chunk_hits + s->chunk_allocs
+			, s->arena_allocs, s->heap_allocs
+			, s->buf_hits, s->buf_hits + s->buf_allocs);
+		slab_destroy(s);
+	}
+	ffmem_alignfree(tx->slabs);
+	ffmem_alignfree(tx->lists);
 	ffmem_free(tx);  tx = NULL;
 }
 
@@ -78,7 +139,7 @@ static void track_busytime_print(phi_track *t)
 	struct filter *f;
 	FF_FOREACH(t->conveyor.filters_pool, f) {
 		uint i = f - t->conveyor.filters_pool;
-		uint64 nsec = t->conveyor.busytime_nsec[i];
+		uint64 nsec = t->conveyor.prof->filters[i].busy_nsec;
 		if (nsec == 0)
 			continue;
 		uint percent = nsec / 1000 * 100 / total_usec;
@@ -93,26 +154,54 @@ static void track_busytime_print(phi_track *t)
 	ffvec_free(&buf);
 }
 
+/** Release the memory of a closed track */
+static void track_free(phi_track *t)
+{
+	struct track_slab *s = track_slab(t->worker);
+	slab_stats_add(s, t->arena_allocs, t->heap_allocs);
+
+	struct arena_chunk *c, *next;
+	for (c = t->arena;  c != NULL;  c = next) {
+		next = c->next;
+		slab_chunk_free(s, c);
+	}
+
+	slab_page_free(s, t, FF_OFF(struct phi_track, area) + t->area_size);
+}
+
 static void track_close(phi_track *t)
 {
 	if (t == NULL) return;
 
-	core->task(t->worker, &t->task_wake, NULL, NULL);
-
 	if (t->sib.next) {
-		fflock_lock(&tx->tracks_lock);
-		fflist_rm(&tx->tracks, &t->sib);
-		fflock_unlock(&tx->tracks_lock);
+		struct track_list *l = &tx->lists[t->list_idx];
+		fflock_lock(&l->lock);
+		fflist_rm(&l->tracks, &t->sib);
+		fflock_unlock(&l->lock);
 	}
 
 	conveyor_close(&t->conveyor, t);
 	ffmem_free(t->output.name);
 
-	if (t->conf.print_time)
+	struct track_prof *tp = t->conveyor.prof;
+	if (tp) {
 		track_busytime_print(t);
+		prof_track_print(t, tp);
+
+		fflock_lock(&tx->prof.lock);
+		prof_total_add(&tx->prof.filters, t, tp);
+		tx->prof.tracks++;
+		tx->prof.queue_wait_nsec += tp->queue_wait_nsec;
+		fflock_unlock(&tx->prof.lock);
+		ffmem_free(tp);
+	}
 
-	dbglog(t, "closed.  area:%u/%u", t->area_size, t->area_cap);
-	ffmem_alignfree(t);
+	dbglog(t, "closed.  area:%u/%u  arena:%u  heap:%u"
+		, t->area_size, t->area_cap, t->arena_allocs, t->heap_allocs);
+
+	if (ffwakeq_node_close((ffwakeq_node*)&t->wake))
+		track_free(t);
+	// else: the track will be freed by the worker when it processes the pending wake-up
 }
 
 static void conveyor_init(struct phi_conveyor *v)
@@ -163,21 +252,28 @@ static char* conveyor_print(struct phi_conveyor *v, const struct filter *mark, c
 
 static phi_track* track_create(struct phi_track_conf *conf)
 {
-	FF_ASSERT(sizeof(phi_track) < 4096);
-	phi_track *t = ffmem_align(4096, 4096);
-	ffmem_zero(t, 4096);
-	t->area_cap = 4096 - sizeof(phi_track);
+	FF_ASSERT(sizeof(phi_track) < TRACK_PAGE);
+	uint worker = core->worker_assign(conf->cross_worker_assign);
+	phi_track *t = slab_page_alloc(track_slab(worker));
+	if (t == NULL) {
+		core->worker_release(worker);
+		return NULL;
+	}
+	t->area_cap = TRACK_PAGE - sizeof(phi_track);
 	t->area_size = ffint_align_ceil2(FF_OFF(struct phi_track, area) & 63, 64);
 	t->conf = *conf;
 	conveyor_init(&t->conveyor);
-	t->worker = core->worker_assign(conf->cross_worker_assign);
+	t->worker = worker;
+	ffwakeq_node_init((ffwakeq_node*)&t->wake, (ffwakeq_handler)track_free, t);
 
 	uint id = ffint_fetch_add(&tx->cur_id, 1);
 	t->id[0] = '*';
 	ffs_fromint(id, t->id+1, sizeof(t->id)-1, 0);
 
-	if (t->conf.print_time)
+	if (t->conf.print_time) {
 		t->t_start = core->time(NULL, PHI_CORE_TIME_MONOTONIC);
+		t->conveyor.prof = ffmem_new(struct track_prof);
+	}
 
 	t->audio.seek = ~0ULL;
 	if (t->conf.seek_msec && !t->conf.seek_type) {
@@ -367,9 +463,78 @@ go_fwd:
 	return r;
 }
 
+/** Get PHI_FWRITABLE flag for the output data of the filter that has just been called */
+static uint trk_out_writable(phi_track *t, const struct filter *f)
+{
+	uint flags = f->iface->flags;
+	uint own = t->chain_flags & PHI_FOWN_OUTPUT;
+	t->chain_flags &= ~PHI_FOWN_OUTPUT;
+	if ((flags & PHI_FILTER_OWN_OUTPUT) || own)
+		return PHI_FWRITABLE;
+	if ((flags & PHI_FILTER_INPLACE)
+		|| f->obj == NULL) // skipped by open()
+		return t->chain_flags & PHI_FWRITABLE;
+	return 0;
+}
+
+/** Move the track to an idle worker.
+Return 1 if the track is moved: the current thread must not touch the track anymore. */
+static int track_move(phi_track *t)
+{
+	if (t->worker_bound
+		|| FFINT_READONCE(((ffwakeq_node*)&t->wake)->state) != FFWAKEQ_IDLE)
+		return 0; // the track may be woken up on the current worker
+
+	uint wid = core->worker_move(t->worker);
+	if (wid == t->worker)
+		return 0;
+
+	if (ST_RUNNING != ffint_cmpxchg(&t->state, ST_RUNNING, ST_MOVING)) {
+		core->worker_release(wid); // the track is being stopped
+		return 0;
+	}
+
+	dbglog(t, "moving to worker #%u", wid);
+	core->worker_release(t->worker);
+	t->worker = wid;
+	// The new worker may process and close the track right away:
+	//  this is the last access to the track from the current thread
+	core_track_wake(wid, (ffwakeq_node*)&t->wake, (phi_task_func)track_run);
+	return 1;
+}
+
+/** Account the time the track spent suspended and waiting in the worker's queue */
+static void track_prof_resume(struct track_prof *tp)
+{
+	uint64 wake = ffint_fetch_and(&tp->t_wake_nsec, 0);
+	if (wake == 0)
+		return;
+
+	if (tp->t_async.sec != 0 || tp->t_async.nsec != 0) {
+		uint64 async = prof_nsec(tp->t_async);
+		if (wake >= async)
+			tp->filters[tp->async_filter].async_nsec += wake - async;
+		ffmem_zero_obj(&tp->t_async);
+	}
+
+	uint64 now = prof_nsec(core->time(NULL, PHI_CORE_TIME_MONOTONIC));
+	if (now >= wake)
+		tp->queue_wait_nsec += now - wake;
+}
+
 static void track_run(phi_track *t)
 {
 	int r;
+	if (ff_unlikely(FFINT_READONCE(t->state) == ST_MOVING)) {
+		// the track has been moved to this worker: stop() may now send the signal here
+		ffcpu_fence_release();
+		FFINT_WRITEONCE(t->state, ST_RUNNING);
+	}
+
+	struct track_prof *tp = t->conveyor.prof;
+	if (ff_unlikely(tp))
+		track_prof_resume(tp);
+
 	for (;;) {
 
 		if (FFINT_READONCE(t->state) == ST_STOP) {
@@ -379,35 +544,48 @@ static void track_run(phi_track *t)
 			t->chain_flags |= PHI_FSTOP;
 		}
 
-		fftime t1, t2;
-		if (ff_unlikely(t->conf.print_time))
+		fftime t1;
+		ffsize in_len = 0;
+		uint i_filter = 0;
+		if (ff_unlikely(tp)) {
 			t1 = core->time(NULL, PHI_CORE_TIME_MONOTONIC);
+			in_len = t->data_in.len;
+			i_filter = t->conveyor.filters_active[t->conveyor.cur];
+		}
 
 		struct filter *f = conveyor_filter_cur(&t->conveyor);
 		r = trk_filter_run(t, f);
 
-		if (ff_unlikely(t->conf.print_time)) {
-			t2 = core->time(NULL, PHI_CORE_TIME_MONOTONIC);
-			fftime_sub(&t2, &t1);
-			t->conveyor.busytime_nsec[t->conveyor.filters_active[t->conveyor.cur]] += t2.sec * 1000000 + t2.nsec;
+		if (ff_unlikely(tp)) {
+			prof_call(&tp->filters[i_filter], prof_elapsed(t1), in_len, t->data_out.len);
+			if (r == PHI_ASYNC) {
+				tp->t_async = core->time(NULL, PHI_CORE_TIME_MONOTONIC);
+				tp->async_filter = i_filter;
+			}
 		}
 
+		uint writable = trk_out_writable(t, f);
 		r = trk_filter_handle_result(t, f, r);
 		switch (r) {
 		case PHI_MORE:
-			t->chain_flags &= ~PHI_FFWD;
+			t->chain_flags &= ~(PHI_FFWD | PHI_FWRITABLE);
 			ffstr_null(&t->data_in);
 			ffstr_null(&t->data_out);
+			if (t->conveyor.cur == 0
+				&& t->conf.cross_worker_assign
+				&& track_move(t))
+				return; // continue on another worker
 			break;
 
 		case PHI_BACK:
+			// the filter returns its input data back: PHI_FWRITABLE is unchanged
 			t->chain_flags &= ~PHI_FFWD;
 			t->data_in = t->data_out;
 			ffstr_null(&t->data_out);
 			break;
 
 		case PHI_DATA:
-			t->chain_flags |= PHI_FFWD;
+			t->chain_flags = (t->chain_flags & ~PHI_FWRITABLE) | PHI_FFWD | writable;
 			t->data_in = t->data_out;
 			ffstr_null(&t->data_out);
 			break;
@@ -442,9 +620,11 @@ fin:
 
 static void track_start(phi_track *t)
 {
-	fflock_lock(&tx->tracks_lock);
-	fflist_add(&tx->tracks, &t->sib);
-	fflock_unlock(&tx->tracks_lock);
+	t->list_idx = t->worker % tx->n_slabs;
+	struct track_list *l = &tx->lists[t->list_idx];
+	fflock_lock(&l->lock);
+	fflist_add(&l->tracks, &t->sib);
+	fflock_unlock(&l->lock);
 
 	track_run(t);
 }
@@ -456,7 +636,7 @@ static void track_xstart(phi_track *t)
 	t->conveyor.cur = 0;
 
 	dbglog(t, "%p: starting (worker #%u)", t, t->worker);
-	core->task(t->worker, &t->task_wake, (phi_task_func)track_start, t);
+	core_track_wake(t->worker, (ffwakeq_node*)&t->wake, (phi_task_func)track_start);
 }
 
 static void track_stop(phi_track *t)
@@ -474,7 +654,10 @@ static void track_stop(phi_track *t)
 static void track_xstop(phi_track *t)
 {
 	dbglog(t, "stop");
-	int st = ffint_cmpxchg(&t->state, ST_RUNNING, ST_STOP);
+	int st;
+	while (ST_MOVING == (st = ffint_cmpxchg(&t->state, ST_RUNNING, ST_STOP))) {
+		ffthread_yield(); // wait until the track is assigned to the new worker
+	}
 	if (st == ST_RUNNING)
 		core->task(t->worker, &t->task_stop, (phi_task_func)track_stop, t);
 }
@@ -482,21 +665,32 @@ static void track_xstop(phi_track *t)
 static void track_wake(phi_track *t)
 {
 	dbglog(t, "wake up");
-	core->task(t->worker, &t->task_wake, (phi_task_func)track_run, t);
+	struct track_prof *tp = t->conveyor.prof;
+	if (ff_unlikely(tp)) {
+		// may be called from any thread while the track is running on its worker
+		ffint_fetch_add(&tp->wakes, 1);
+		uint64 now = prof_nsec(core->time(NULL, PHI_CORE_TIME_MONOTONIC));
+		ffint_cmpxchg(&tp->t_wake_nsec, 0, now); // keep the time of the first wake-up
+	}
+	core_track_wake(t->worker, (ffwakeq_node*)&t->wake, (phi_task_func)track_run);
 }
 
 /**
 Return N of tracks that were issued the stop command */
 static uint track_xstop_all()
 {
-	fflock_lock(&tx->tracks_lock);
-	ffchain_item *it;
-	FFLIST_WALK(&tx->tracks, it) {
-		phi_track *t = FF_CONTAINER(phi_track, sib, it);
-		track_xstop(t);
+	uint n = 0;
+	for (uint i = 0;  i < tx->n_slabs;  i++) {
+		struct track_list *l = &tx->lists[i];
+		fflock_lock(&l->lock);
+		ffchain_item *it;
+		FFLIST_WALK(&l->tracks, it) {
+			phi_track *t = FF_CONTAINER(phi_track, sib, it);
+			track_xstop(t);
+		}
+		n += l->tracks.len;
+		fflock_unlock(&l->lock);
 	}
-	uint n = tx->tracks.len;
-	fflock_unlock(&tx->tracks_lock);
 	return n;
 }
 
@@ -516,31 +710,80 @@ static ffssize track_cmd(phi_track *t, uint cmd, ...)
 	return 0;
 }
 
+/** Allocate zeroed memory from the track's arena */
+static void* track_arena_alloc(phi_track *t, uint n)
+{
+	n = ffint_align_ceil2(n, 64);
+	struct arena_chunk *c = t->arena;
+	if (c == NULL || c->size + n > ARENA_CHUNK) {
+		if (NULL == (c = slab_chunk_alloc(track_slab(t->worker))))
+			return NULL;
+		c->next = t->arena;
+		t->arena = c;
+	}
+
+	void *p = (u_char*)c + c->size;
+	c->size += n;
+	t->arena_allocs++;
+	return p;
+}
+
+static int track_arena_owns(phi_track *t, void *ptr)
+{
+	for (struct arena_chunk *c = t->arena;  c != NULL;  c = c->next) {
+		if ((u_char*)ptr >= (u_char*)c
+			&& (u_char*)ptr < (u_char*)c + ARENA_CHUNK)
+			return 1;
+	}
+	return 0;
+}
+
 void* track_memalloc(phi_track *t, uint n)
 {
 	uint sz = t->area_size + ffint_align_ceil2(n, 64);
-	if (n > 256 || sz > t->area_cap) {
+	if (ffint_align_ceil2(n, 64) > ARENA_CHUNK - ARENA_HDR) {
+		// the object doesn't fit into an arena chunk
 		dbglog(t, "alloc %u bytes", n);
+		t->heap_allocs++;
 		void *p = ffmem_align(n, 64);
-		ffmem_zero(p, n);
+		if (p != NULL)
+			ffmem_zero(p, n);
 		return p;
 	}
 
+	if (sz > t->area_cap) {
+		dbglog(t, "arena: reserve %u bytes", n);
+		return track_arena_alloc(t, n);
+	}
+
 	dbglog(t, "reserve %u bytes", n);
 	void *p = t->area + t->area_size;
 	t->area_size = sz;
 	return p;
 }
 
+/** Note: the memory in the track area and arena is released only when the track is closed */
 void track_memfree(phi_track *t, void *ptr)
 {
-	if ((u_char*)ptr >= t->area
-		&& (u_char*)ptr < t->area + t->area_cap) {
+	if (((u_char*)ptr >= t->area
+			&& (u_char*)ptr < t->area + t->area_cap)
+		|| track_arena_owns(t, ptr)) {
 		return;
 	}
 	ffmem_alignfree(ptr);
 }
 
+static void* track_buf_alloc(phi_track *t, ffsize n)
+{
+	return slab_buf_alloc(track_slab(t->worker), n);
+}
+
+static void track_buf_free(phi_track *t, void *ptr)
+{
+	if (ptr == NULL) return;
+	slab_buf_free(track_slab(t->worker), ptr);
+}
+
 const phi_track_if phi_track_iface = {
 	track_conf,
 	track_create,
@@ -552,4 +795,6 @@ const phi_track_if phi_track_iface = {
 	track_memalloc,
 	track_memfree,
 	track_cmd,
+	track_buf_alloc,
+	track_buf_free,
 };
@@ -11,6 +11,7 @@
 #include <util/kq.h>
 #include <util/kq-kcq.h>
 #include <util/kq-tq.h>
+#include <util/kq-wq.h>
 #include <util/kq-timer.h>
 #include <ffsys/sysconf.h>
 #include <ffsys/thread.h>
@@ -28,6 +29,7 @@ struct wrk_ctx {
 	struct wrk_conf conf;
 	ffvec			workers; // struct worker[]
 	uint			n_reserved;
+	int				n_idle; // Number of started workers (except main) without jobs
 };
 
 struct worker {
@@ -41,6 +43,7 @@ struct worker {
 
 	fftaskqueue		tq;
 	struct zzkq_tq	kq_tq;
+	struct zzkq_wq	kq_wq; // track wake-ups
 
 	fftimerqueue		timerq;
 	struct zzkq_timer	kq_timer;
@@ -63,6 +66,14 @@ void wrk_task(struct worker *w, fftask *t, phi_task_func func, void *param)
 	zzkq_tq_post(&w->kq_tq, t);
 }
 
+/** Add a node to the lock-free wake queue.  Thread-safe.
+The node isn't added if it's already in the queue. */
+void wrk_wake(struct worker *w, ffwakeq_node *n, phi_task_func func)
+{
+	extralog("wake: %p %p", n, func);
+	zzkq_wq_post(&w->kq_wq, n, func);
+}
+
 static void timer_suspend(void *param)
 {
 	struct worker *w = param;
@@ -186,6 +197,11 @@ static int wrk_create(struct worker *w, const struct wrk_conf *conf)
 		return -1;
 	}
 
+	if (!!zzkq_wq_attach(&w->kq_wq, w->kq.kq)) {
+		syserrlog("zzkq_wq_attach");
+		return -1;
+	}
+
 	if (!!zzkq_timer_create(&w->kq_timer)) {
 		syserrlog("timer create");
 		return -1;
@@ -205,6 +221,7 @@ static void wrk_destroy(struct worker *w)
 	}
 	zzkqkcq_disconnect(&w->kq_kcq, w->kq.kq);
 	zzkq_tq_detach(&w->kq_tq, w->kq.kq);
+	zzkq_wq_detach(&w->kq_wq, w->kq.kq);
 	zzkq_timer_destroy(&w->kq_timer, w->kq.kq);
 	zzkq_destroy(&w->kq);
 }
@@ -333,6 +350,8 @@ uint wrkx_assign(struct wrk_ctx *wx, uint flags)
 done:
 	wid = w - (struct worker*)wx->workers.ptr;
 	nj = ffatomic_fetch_add(&w->njobs, 1) + 1;
+	if (nj == 1 && wid != 0 && !i_reserved)
+		ffint_fetch_add(&wx->n_idle, -1);
 
 	if (i_reserved) {
 		// Wait for others to complete the preparation of the worker slots reserved before us
@@ -356,5 +375,35 @@ static void wrkx_release(struct wrk_ctx *wx, uint wid)
 	struct worker *w = ffslice_itemT(&wx->workers, wid, struct worker);
 	int nj = ffatomic_fetch_add(&w->njobs, -1) - 1;
 	FF_ASSERT(nj >= 0);
+	if (nj == 0 && wid != 0)
+		ffint_fetch_add(&wx->n_idle, 1);
 	dbglog("worker #%u release: jobs:%u", wid, nj);
 }
+
+/** Find an idle worker that can take a job from the busy worker `wid`.
+Lock-free: the idle worker is claimed by atomically changing its jobs counter 0 -> 1.
+The caller releases `wid` after the job is moved.
+Return new worker ID or `wid` */
+static uint wrkx_move(struct wrk_ctx *wx, uint wid)
+{
+	if (FFINT_READONCE(wx->n_idle) <= 0)
+		return wid;
+
+	struct worker *w = ffslice_itemT(&wx->workers, wid, struct worker), *it;
+	if (ffatomic_load(&w->njobs) < 2)
+		return wid; // the worker isn't overloaded
+
+	uint n = FFINT_READONCE(wx->workers.len);
+	for (uint i = 1;  i < n;  i++) {
+		it = ffslice_itemT(&wx->workers, i, struct worker);
+		if (it == w
+			|| 0 != ffatomic_load(&it->njobs)
+			|| 0 != ffatomic_cmpxchg(&it->njobs, 0, 1))
+			continue;
+
+		ffint_fetch_add(&wx->n_idle, -1);
+		dbglog("worker #%u -> #%u: moving job", wid, i);
+		return i;
+	}
+	return wid;
+}
@@ -35,6 +35,13 @@ Options:\n\
   `-aformat` FORMAT       Audio sample format:\n\
                           int8 | int16 | int24 | int32 | float32\n\
   `-rate` NUMBER          Sample rate\n\
+  `-resample` STRING      Sample rate converter:\n\
+                          `fast`    Polyphase, 16 taps (low latency)\n\
+                          `medium`  Polyphase, 32 taps\n\
+                          `high`    Polyphase, 64 taps (default)\n\
+                          `soxr`    Always use libsoxr\n\
+                        Polyphase is used only for 44.1/48/88.2/96/176.4/192kHz;\n\
+                         libsoxr is used for the other rates.\n\
   `-channels` NUMBER      Channels number\n\
   `-danorm` \"OPTIONS\"     Apply Dynamic Audio Normalizer filter. Options:\n\
                           `frame`       Integer\n\
@@ -44,6 +51,14 @@ Options:\n\
                           `target-rms`  Float\n\
                           `compress`    Float\n\
   `-gain` NUMBER          Gain/attenuation in dB\n\
+  `-silence` \"OPTIONS\"    Detect silence. Options:\n\
+                          `threshold`   Integer (dB): max. level of silence (=50: -50dB)\n\
+                          `duration`    Integer (msec): min. duration of silence (=1000)\n\
+                          `trim`        Remove leading and trailing silence\n\
+                          `report`      Print the time ranges of silence\n\
+  `-split` TIME|silence   Create new output file periodically\n\
+                          [[HH:]MM:]SS[.MSC]\n\
+                          `silence`: create new output file after each silence\n\
 \n\
   `-copy`                 Copy audio data without re-encoding\n\
   `-aac_profile` STRING   AAC profile:\n\
@@ -64,6 +79,7 @@ Options:\n\
                           0..10\n\
   `-mp3_quality` NUMBER   MP3 encoding quality:\n\
                           9..0 (VBR) or 64..320 (CBR, kbit/s)\n\
+  `-flac_parallel`        Encode FLAC on several workers\n\
 \n\
   `-meta` NAME=VALUE      Meta data\n\
                           .mp4 supports: album, albumartist, artist, comment, composer, copyright, date, discnumber, genre, lyrics, title, tracknumber.\n\
@@ -93,6 +109,7 @@ Options:\n\
   `-cpu_affinity` STRING  Set Worker-CPU affinity:\n\
                           `auto`\n\
   `-perf`                 Print performance counters\n\
+  `-mmap`                 Read local files via memory mapping\n\
 ");
 	x->exit_code = 0;
 	return 1;
@@ -103,6 +120,7 @@ struct cmd_conv {
 	const char*	opus_mode;
 	const char*	danorm;
 	const char*	output;
+	const char*	silence;
 	ffvec	include, exclude; // ffstr[]
 	ffvec	input; // ffstr[]
 	ffvec	meta;
@@ -110,7 +128,11 @@ struct cmd_conv {
 	int		gain;
 	u_char	copy;
 	u_char	cue_gaps;
+	u_char	flac_parallel;
+	u_char	mmap;
 	u_char	perf;
+	u_char	resampler;
+	u_char	split_silence;
 	uint	aac_bandwidth;
 	uint	aac_q;
 	uint	aformat;
@@ -121,6 +143,7 @@ struct cmd_conv {
 	uint	opus_q;
 	uint	preserve_date;
 	uint	rate;
+	uint	split;
 	uint	vorbis_q;
 	uint64	seek;
 	uint64	until;
@@ -183,10 +206,45 @@ static int conv_cue_gaps(struct cmd_conv *v, ffstr s)
 	return 0;
 }
 
+static int conv_resample(struct cmd_conv *v, ffstr s)
+{
+	static const char values[][8] = {
+		"fast",
+		"high",
+		"medium",
+		"soxr",
+	};
+	static const u_char numbers[] = {
+		PHI_RESAMPLE_FAST,
+		PHI_RESAMPLE_HIGH,
+		PHI_RESAMPLE_MEDIUM,
+		PHI_RESAMPLE_SOXR,
+	};
+	int r = ffcharr_findsorted(values, FF_COUNT(values), sizeof(values[0]), s.ptr, s.len);
+	if (r < 0)
+		return _ffargs_err(&x->cmd, 1, "-resample: value '%S' is not recognized", &s);
+	v->resampler = numbers[r];
+	return 0;
+}
+
 static int conv_seek(struct cmd_conv *v, ffstr s) { return cmd_time_value(&v->seek, s); }
 
 static int conv_until(struct cmd_conv *v, ffstr s) { return cmd_time_value(&v->until, s); }
 
+static int conv_split(struct cmd_conv *v, ffstr s)
+{
+	uint64 val;
+	int r;
+	if (ffstr_eqz(&s, "silence")) {
+		v->split_silence = 1;
+		return 0;
+	}
+	if ((r = cmd_time_value(&val, s)))
+		return r;
+	v->split = val;
+	return 0;
+}
+
 static int conv_workers(struct cmd_conv *v, uint64 val)
 {
 	x->workers = val;
@@ -211,14 +269,19 @@ static int conv_action(struct cmd_conv *v)
 			.include = *(ffslice*)&v->include,
 			.exclude = *(ffslice*)&v->exclude,
 			.preserve_date = v->preserve_date,
+			.mmap = v->mmap,
 		},
 		.cue_gaps = v->cue_gaps,
 		.tracks = *(ffslice*)&v->tracks,
 		.seek_msec = v->seek,
 		.until_msec = v->until,
+		.split_msec = v->split,
+		.split_silence = v->split_silence,
 		.afilter = {
 			.gain_db = v->gain,
 			.danorm = v->danorm,
+			.resampler = v->resampler,
+			.silence = v->silence,
 		},
 		.oaudio = {
 			.format = {
@@ -253,6 +316,9 @@ static int conv_action(struct cmd_conv *v)
 
 	case PHI_AC_VORBIS:
 		c.vorbis.quality = (v->vorbis_q) ? (v->vorbis_q + 1) * 10 : 0;  break;
+
+	case PHI_AC_FLAC:
+		c.flac.parallel = v->flac_parallel;  break;
 	}
 
 	cmd_meta_set(&c.meta, &v->meta);
@@ -314,12 +380,14 @@ static const struct ffarg cmd_conv[] = {
 	{ "-cue_gaps",		'S',	conv_cue_gaps },
 	{ "-danorm",		's',	O(danorm) },
 	{ "-exclude",		'+S',	conv_exclude },
+	{ "-flac_parallel",	'1',	O(flac_parallel) },
 	{ "-force",			'1',	O(force) },
 	{ "-gain",			'd',	O(gain) },
 	{ "-help",			0,		conv_help },
 	{ "-include",		'+S',	conv_include },
 	{ "-m",				'+S',	conv_meta },
 	{ "-meta",			'+S',	conv_meta },
+	{ "-mmap",			'1',	O(mmap) },
 	{ "-mp3_quality",	'u',	O(mp3_q) },
 	{ "-o",				's',	O(output) },
 	{ "-opus_mode",		's',	O(opus_mode) },
@@ -328,7 +396,10 @@ static const struct ffarg cmd_conv[] = {
 	{ "-perf",			'1',	O(perf) },
 	{ "-preserve_date",	'1',	O(preserve_date) },
 	{ "-rate",			'u',	O(rate) },
+	{ "-resample",		'S',	conv_resample },
 	{ "-seek",			'S',	conv_seek },
+	{ "-silence",		's',	O(silence) },
+	{ "-split",			'S',	conv_split },
 	{ "-tracks",		'S',	conv_tracks },
 	{ "-until",			'S',	conv_until },
 	{ "-vorbis_quality",'u',	O(vorbis_q) },
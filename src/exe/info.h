@@ -24,10 +24,12 @@ Options:\n\
                           [[HH:]MM:]SS[.MSC]\n\
   `-until` TIME           Stop at time\n\
 \n\
-  `-loudness`             Analyze audio loudness\n\
+  `-loudness`             Analyze audio loudness.\n\
+                          Files are processed in parallel; album loudness is printed for several files.\n\
   `-peaks`                Analyze audio and print some details\n\
 \n\
   `-perf`                 Print performance counters\n\
+  `-mmap`                 Read local files via memory mapping\n\
   `-connect_timeout` NUMBER\n\
                           Connection timeout (in seconds): 1..255\n\
   `-recv_timeout` NUMBER  Receive timeout (in seconds): 1..255\n\
@@ -39,6 +41,7 @@ Options:\n\
 struct cmd_info {
 	u_char	duration;
 	u_char	loudness;
+	u_char	mmap;
 	u_char	pcm_peaks;
 	u_char	perf;
 	u_char	tags;
@@ -75,9 +78,23 @@ static int info_input(struct cmd_info *p, ffstr s)
 	return cmd_input(&p->input, s);
 }
 
+static void info_q_on_change(phi_queue_id q, uint flags, uint pos)
+{
+	struct cmd_info *p = x->subcmd.obj;
+	if ((flags & 0xff) == '.' && p->loudness) {
+		const phi_loudness_album_if *la = x->core->mod("afilter.loudness-album");
+		double lufs, peak;
+		uint n = la->get(q, &lufs, &peak);
+		if (n > 1)
+			userlog("Album loudness: %f (%u tracks)", lufs, n);
+	}
+
+	q_on_change(q, flags, pos);
+}
+
 static int info_action(struct cmd_info *p)
 {
-	x->queue->on_change(q_on_change);
+	x->queue->on_change(info_q_on_change);
 
 	struct phi_track_conf c = {
 		.ifile = {
@@ -85,6 +102,7 @@ static int info_action(struct cmd_info *p)
 			.exclude = *(ffslice*)&p->exclude,
 			.connect_timeout_sec = ffmin(p->connect_timeout, 0xff),
 			.recv_timeout_sec = ffmin(p->recv_timeout, 0xff),
+			.mmap = p->mmap,
 		},
 		.tracks = *(ffslice*)&p->tracks,
 		.seek_msec = p->seek,
@@ -96,6 +114,7 @@ static int info_action(struct cmd_info *p)
 		.info_only = !(p->pcm_peaks || p->loudness),
 		.print_tags = p->tags,
 		.print_time = p->perf,
+		.cross_worker_assign = p->loudness, // analyze several files in parallel
 	};
 
 	struct phi_queue_conf qc = {
@@ -135,6 +154,7 @@ static const struct ffarg cmd_info[] = {
 	{ "-help",		0,		info_help },
 	{ "-include",	'+S',	info_include },
 	{ "-loudness",	'1',	O(loudness) },
+	{ "-mmap",		'1',	O(mmap) },
 	{ "-peaks",		'1',	O(pcm_peaks) },
 	{ "-perf",		'1',	O(perf) },
 	{ "-recv_timeout",	'u',	O(recv_timeout) },
@@ -43,14 +43,19 @@ Options:\n\
                           `target`     Integer\n\
                           `attenuate`  Integer\n\
                           `gain`       Integer\n\
-  `-equalizer` \"OPTIONS\"  SoX Equalizer. Options:\n\
+                          `lookahead`  Peak limiter lookahead (msec): 0(disable)..10.  Default: 5\n\
+                          `ceiling`    Peak limiter ceiling (dBFS).  Default: -1\n\
+  `-equalizer` \"OPTIONS\"  Parametric equalizer. Options:\n\
                           `type`       band (default), bass or treble\n\
-                          `frequency`  Hz\n\
-                          `width`q     Q-factor value plus 'q' character (larger = narrower)\n\
+                          `frequency`  Hz.  Default for bass: 100, treble: 3000\n\
+                          `width`      Band width with unit character:\n\
+                                         q: Q-factor (larger = narrower)\n\
+                                         o: octaves\n\
+                                         h: Hz (default);  k: kHz\n\
+                                         s: shelf slope (bass/treble only; default: 0.5s)\n\
                           `gain`       dB\n\
                           [, ...]\n\
-                        Add more parameters after comma for multi-band equalizer.\n\
-                        Refer to the official SoX documentation for more info.\n\
+                        Add more parameters after comma for multi-band equalizer (up to 16 bands).\n\
 \n\
   `-audio` STRING         Audio library name (e.g. alsa)\n\
   `-device` NUMBER        Playback device number\n\
@@ -19,14 +19,20 @@ Options:\n\
   `-rate` NUMBER          Sample rate\n\
   `-channels` NUMBER      Channels number\n\
 \n\
-  `-split` TIME           Create new output file periodically\n\
+  `-split` TIME|silence   Create new output file periodically\n\
                           [[HH:]MM:]SS[.MSC]\n\
+                          `silence`: create new output file after each silence\n\
   `-until` TIME           Stop at time\n\
                           [[HH:]MM:]SS[.MSC]\n\
 \n\
   `-noise_gate` \"OPTIONS\" Suppress noise. Options:\n\
                           `threshold`   Integer (dB)\n\
                           `release`     Integer (msec)\n\
+  `-silence` \"OPTIONS\"    Detect silence. Options:\n\
+                          `threshold`   Integer (dB): max. level of silence (=50: -50dB)\n\
+                          `duration`    Integer (msec): min. duration of silence (=1000)\n\
+                          `trim`        Remove leading and trailing silence\n\
+                          `report`      Print the time ranges of silence\n\
   `-danorm` \"OPTIONS\"     Apply Dynamic Audio Normalizer filter. Options:\n\
                           `frame`       Integer\n\
                           `size`        Integer\n\
@@ -86,12 +92,14 @@ struct cmd_rec {
 	const char*	opus_mode;
 	const char*	output;
 	const char*	remote_id;
+	const char*	silence;
 	ffvec	meta;
 	int		gain;
 	u_char	exclusive;
 	u_char	force;
 	u_char	loopback;
 	u_char	remote;
+	u_char	split_silence;
 	uint	aac_q;
 	uint	aformat;
 	uint	buffer;
@@ -160,7 +168,8 @@ enum {
 	FMR_NG = 5,
 	FMR_DAN,
 	FMR_GAIN,
-	FMR_SPLIT = 9,
+	FMR_SIL,
+	FMR_SPLIT = 10,
 	FMR_WRITE,
 	FMR_OUTPUT,
 };
@@ -174,6 +183,7 @@ static struct filter_map FF_STRUCTALIGN(64) rec_f_map[] = {
 	{ "afilter.noise-gate",	0, NULL },
 	{ "af-danorm.f",		0, NULL },
 	{ "afilter.gain",		0, NULL },
+	{ "afilter.silence",	0, NULL },
 	{ "afilter.auto-conv",	1, NULL },
 	{ "afilter.split",		0, NULL },
 	{ "format.auto-write",	0, NULL },
@@ -196,11 +206,13 @@ static int rec_action(struct cmd_rec *r)
 			.buf_time = r->buffer,
 		},
 		.split_msec = r->split,
+		.split_silence = r->split_silence,
 		.until_msec = r->until,
 		.afilter = {
 			.gain_db = r->gain,
 			.danorm = r->danorm,
 			.noise_gate = r->noise_gate,
+			.silence = r->silence,
 		},
 		.oaudio = {
 			.format = {
@@ -246,9 +258,10 @@ static int rec_action(struct cmd_rec *r)
 	map[FMR_NG].use = !!r->noise_gate;
 	map[FMR_DAN].use = !!r->danorm;
 	map[FMR_GAIN].use = r->gain;
-	map[FMR_SPLIT].use = r->split;
-	map[FMR_WRITE].use = !r->split;
-	map[FMR_OUTPUT].use = !r->split;
+	map[FMR_SIL].use = (r->silence || r->split_silence);
+	map[FMR_SPLIT].use = (r->split || r->split_silence);
+	map[FMR_WRITE].use = !map[FMR_SPLIT].use;
+	map[FMR_OUTPUT].use = !map[FMR_SPLIT].use;
 
 	ffsz_copyz(map[FMR_OUTPUT].name, sizeof(map[0].name), (x->stdout_busy) ? "core.stdout" : "core.file-write");
 
@@ -331,6 +344,10 @@ static int rec_split(struct cmd_rec *c, ffstr s)
 {
 	uint64 v;
 	int r;
+	if (ffstr_eqz(&s, "silence")) {
+		c->split_silence = 1;
+		return 0;
+	}
 	if ((r = cmd_time_value(&v, s)))
 		return r;
 	c->split = v;
@@ -364,6 +381,7 @@ static const struct ffarg cmd_rec[] = {
 	{ "-rate",			'u',	O(rate) },
 	{ "-remote",		'1',	O(remote) },
 	{ "-remote_id",		's',	O(remote_id) },
+	{ "-silence",		's',	O(silence) },
 	{ "-split",			'S',	rec_split },
 	{ "-until",			'S',	rec_until },
 	{ "-vorbis_quality",'u',	O(vorbis_q) },
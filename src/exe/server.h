@@ -20,9 +20,17 @@ Options:\n\
   `-opus_quality` NUMBER  Opus encoding bitrate (VBR):\n\
                           6..510 (default: 128)\n\
   `-channels` NUMBER      Channels number (default: 2)\n\
+  `-mount` PATH[=BITRATE] Add mount point (default: \"/\" with AAC or Opus encoder)\n\
+                          Encoder is selected by file extension: .aac, .opus\n\
+                          Without extension: AAC if `-aac_quality` is set, otherwise Opus\n\
+                          e.g. `-mount /hi.aac=192 -mount /lo.opus=48`\n\
 \n\
   `-port` NUMBER          TCP port (default: 21014)\n\
   `-max_clients` NUMBER   Max. number of clients\n\
+  `-burst` NUMBER         Seconds of audio sent to a new client at once (default: 2)\n\
+  `-shards` NUMBER        Number of workers serving the clients (default: 1)\n\
+  `-hls` NUMBER           Also serve AAC streams via HLS with segments of N seconds:\n\
+                          \"/NAME.m3u8\" playlist for \"/NAME.aac\" mount point\n\
 ");
 	x->exit_code = 0;
 	return 1;
@@ -31,8 +39,11 @@ Options:\n\
 struct cmd_srv {
 	ffvec	include, exclude; // ffstr[]
 	ffvec	input; // ffstr[]
+	ffvec	mounts; // struct phi_asv_mount[]
 	uint	aac_q;
+	uint	burst;
 	uint	channels;
+	uint	hls;
 	uint	opus_q;
 	uint	port;
 	u_char	shuffle;
@@ -60,6 +71,37 @@ static int srv_input(struct cmd_srv *s, ffstr fn)
 	return cmd_input(&s->input, fn);
 }
 
+static int srv_mount(struct cmd_srv *s, ffstr ss)
+{
+	ffstr path, br, name, ext;
+	ffstr_splitby(&ss, '=', &path, &br);
+	if (!path.len || path.ptr[0] != '/')
+		return _ffargs_err(&x->cmd, 1, "-mount: path must start with '/': '%S'", &path);
+
+	struct phi_asv_mount *m;
+	FFSLICE_WALK(&s->mounts, m) {
+		if (ffstr_eqz(&path, m->path))
+			return _ffargs_err(&x->cmd, 1, "-mount: duplicate path: '%S'", &path);
+	}
+
+	m = ffvec_zpushT(&s->mounts, struct phi_asv_mount);
+	ffpath_splitname_str(path, &name, &ext);
+	if (ffstr_eqz(&ext, "aac"))
+		m->format = PHI_AC_AAC;
+	else if (ffstr_eqz(&ext, "opus"))
+		m->format = PHI_AC_OPUS;
+	else if (!ext.len)
+		m->format = 0; // the default encoder
+	else
+		return _ffargs_err(&x->cmd, 1, "-mount: unsupported file extension: '%S'", &path);
+
+	if (br.len && !ffstr_to_uint32(&br, &m->bitrate))
+		return _ffargs_err(&x->cmd, 1, "-mount: incorrect bitrate: '%S'", &br);
+
+	m->path = ffsz_dupstr(&path);
+	return 0;
+}
+
 static int srv_prepare(struct cmd_srv *s)
 {
 	if (!s->input.len)
@@ -114,28 +156,41 @@ static void srv_action2(struct cmd_srv *s)
 	};
 	*(struct phi_asv_conf**)&c.ofile.mtime = &s->ac;
 
-	if (s->aac_q) {
-		struct phi_af f = {
-			.format = PHI_PCM_16,
-			.rate = 48000,
-			.channels = (s->channels) ? s->channels : 2,
-			.interleaved = 1,
-		};
-		c.oaudio.format = f;
-		c.aac.quality = (s->aac_q >= 8) ? s->aac_q : 128;
-		c.ofile.name = ffsz_dup("stream.aac");
-
-	} else {
-		struct phi_af f = {
-			.format = PHI_PCM_FLOAT32,
-			.rate = 48000,
-			.channels = (s->channels) ? s->channels : 2,
-			.interleaved = 1,
-		};
-		c.oaudio.format = f;
-		c.opus.bitrate = (s->opus_q >= 6) ? s->opus_q : 128;
-		c.ofile.name = ffsz_dup("stream.opus");
+	if (!s->mounts.len) {
+		struct phi_asv_mount *m = ffvec_zpushT(&s->mounts, struct phi_asv_mount);
+		m->path = ffsz_dup("/");
+		m->format = (s->aac_q) ? PHI_AC_AAC : PHI_AC_OPUS;
+	}
+
+	// Encoders receive the same audio: Opus requires float32, AAC encoder converts it to int16
+	uint pcm_format = PHI_PCM_16;
+	struct phi_asv_mount *m;
+	FFSLICE_WALK(&s->mounts, m) {
+		if (!m->format)
+			m->format = (s->aac_q) ? PHI_AC_AAC : PHI_AC_OPUS;
+
+		if (m->format == PHI_AC_AAC) {
+			if (!m->bitrate)
+				m->bitrate = s->aac_q;
+			m->bitrate = (m->bitrate >= 8) ? m->bitrate : 128;
+		} else {
+			pcm_format = PHI_PCM_FLOAT32;
+			if (!m->bitrate)
+				m->bitrate = s->opus_q;
+			m->bitrate = (m->bitrate >= 6) ? m->bitrate : 128;
+		}
 	}
+	s->ac.mounts = *(ffslice*)&s->mounts;
+	s->ac.hls_segment_msec = s->hls * 1000;
+	s->ac.burst_msec = s->burst * 1000;
+
+	struct phi_af f = {
+		.format = pcm_format,
+		.rate = 48000,
+		.channels = (s->channels) ? s->channels : 2,
+		.interleaved = 1,
+	};
+	c.oaudio.format = f;
 
 	const phi_track_if *track = x->core->track;
 	phi_track *t = track->create(&c);
@@ -146,13 +201,17 @@ static void srv_action2(struct cmd_srv *s)
 #define O(m)  (void*)FF_OFF(struct cmd_srv, m)
 static const struct ffarg cmd_srv[] = {
 	{ "-aac_quality",	'u',	O(aac_q) },
+	{ "-burst",			'u',	O(burst) },
 	{ "-channels",		'u',	O(channels) },
 	{ "-exclude",		'+S',	srv_exclude },
 	{ "-help",			0,		server_help },
+	{ "-hls",			'u',	O(hls) },
 	{ "-include",		'+S',	srv_include },
 	{ "-max_clients",	'u',	O(ac.max_clients) },
+	{ "-mount",			'+S',	srv_mount },
 	{ "-opus_quality",	'u',	O(opus_q) },
 	{ "-port",			'u',	O(port) },
+	{ "-shards",		'u',	O(ac.shards) },
 	{ "-shuffle",		'1',	O(shuffle) },
 	{ "\0\1",			'S',	srv_input },
 	{ "",				0,		srv_prepare },
@@ -161,10 +220,17 @@ static const struct ffarg cmd_srv[] = {
 
 static void cmd_srv_free(struct cmd_srv *s)
 {
+	struct phi_asv_mount *m;
+	FFSLICE_WALK(&s->mounts, m) {
+		ffmem_free((char*)m->path);
+	}
+	ffvec_free(&s->mounts);
 	ffmem_free(s);
 }
 
 static struct ffarg_ctx cmd_server_init(void *obj)
 {
-	return SUBCMD_INIT(ffmem_new(struct cmd_srv), cmd_srv_free, srv_action, cmd_srv);
+	struct cmd_srv *s = ffmem_new(struct cmd_srv);
+	s->burst = 2;
+	return SUBCMD_INIT(s, cmd_srv_free, srv_action, cmd_srv);
 }
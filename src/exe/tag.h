@@ -15,6 +15,9 @@ Options:\n\
   `-meta` NAME=VALUE      Meta data\n\
   `-rg` \"OPTIONS\"         Write ReplayGain tags. Options:\n\
                           `track_gain` (default)\n\
+                          `album_gain`: all input files are one album\n\
+                          `peak`: also write track (and album) peak\n\
+  `-replay-gain`          Same as `-rg \"track_gain album_gain peak\"`\n\
   `-preserve_date`        Preserve file modification date\n\
   `-fast`                 Fail if need to rewrite whole file\n\
 ");
@@ -22,16 +25,35 @@ Options:\n\
 	return 1;
 }
 
+enum TAG_RG {
+	TAG_RG_TRACK = 1,
+	TAG_RG_ALBUM = 2,
+	TAG_RG_PEAK = 4,
+};
+
+struct tag_rg_result {
+	char *filename;
+	double loudness, peak;
+};
+
 struct cmd_tag {
 	ffvec	input;
 	ffvec	meta;
 	u_char	clear;
 	u_char	preserve_date;
 	u_char	fast;
-	uint	replay_gain;
+	uint	replay_gain; // enum TAG_RG
 	ffvec	include, exclude; // ffstr[]
 
 	const phi_tag_if *tag;
+
+	// album gain: the tags are written after all files are analyzed
+	fflock	rg_lock;
+	ffvec	rg_results; // struct tag_rg_result[]
+	uint	rg_active; // tracks being analyzed
+	uint	rg_done :1; // the queue is processed
+	phi_queue_id rg_queue;
+	phi_task rg_task;
 };
 
 static int tag_input(struct cmd_tag *t, ffstr s)
@@ -64,10 +86,14 @@ static int tag_replay_gain(struct cmd_tag *t, const char *s)
 {
 	struct rg {
 		u_char track_gain;
-	} rg;
+		u_char album_gain;
+		u_char peak;
+	} rg = {};
 
 	#define O(m)  (void*)(size_t)FF_OFF(struct rg, m)
 	static const struct ffarg rg_args[] = {
+		{ "album_gain",		'1',	O(album_gain) },
+		{ "peak",			'1',	O(peak) },
 		{ "track_gain",		'1',	O(track_gain) },
 		{}
 	};
@@ -77,44 +103,72 @@ static int tag_replay_gain(struct cmd_tag *t, const char *s)
 	if (ffargs_process_line(&a, rg_args, &rg, FFARGS_O_PARTIAL | FFARGS_O_DUPLICATES, s))
 		return _ffargs_err(&x->cmd, 1, "%s", a.error);
 
-	if (rg.track_gain || !*s) {
-		t->replay_gain |= 1;
+	if (rg.track_gain || !(rg.album_gain || rg.peak))
+		t->replay_gain |= TAG_RG_TRACK;
+	if (rg.album_gain)
+		t->replay_gain |= TAG_RG_ALBUM;
+	if (rg.peak)
+		t->replay_gain |= TAG_RG_PEAK;
+	return 0;
+}
+
+static int tag_replay_gain_all(struct cmd_tag *t)
+{
+	t->replay_gain = TAG_RG_TRACK | TAG_RG_ALBUM | TAG_RG_PEAK;
+	return 0;
+}
+
+/** Add "name=value" tag */
+static int tag_rg_add(ffvec *tags, const char *name, double val, uint peak)
+{
+	char buf[16];
+	uint n;
+	if (peak) {
+		n = ffs_fromfloat(val, buf, sizeof(buf) - 1, 6);
+	} else {
+		// -18: ReplayGain target
+		// -1: EBU R 128: "The Maximum True-Peak Level in production shall not exceed −1 dBTP"
+		// e.g. -10 loudness -> -19 target = -9 gain
+		val = -18-1 - val;
+		n = ffs_fromfloat(val, buf, 7, FFS_FLTKEEPSIGN | FFS_FLTWIDTH(3) | FFS_FLTZERO | 2); // "-xx.xx"
+	}
+	if (!n) {
+		phi_errlog(x->core, NULL, NULL, "ffs_fromfloat");
+		return -1;
 	}
+	buf[n] = '\0';
+
+	ffstr s = {};
+	size_t cap = 0;
+	ffstr_growfmt(&s, &cap, "%s=%s", name, buf);
+	*ffvec_pushT(tags, ffstr) = s;
 	return 0;
 }
 
-static void tag_grd_close(void *f, phi_track *t)
+/**
+album: [0]: loudness; [1]: peak */
+static int tag_rg_write(struct cmd_tag *tt, const struct tag_rg_result *r, const double *album)
 {
-	struct cmd_tag *tt = x->subcmd.obj;
 	ffvec tags = {};
-	ffstr s = {};
 	int rc = -1;
+	ffvec_add2T(&tags, &tt->meta, ffstr);
 
-	x->core->track->stop(t);
-
-	if (t->error)
+	if ((tt->replay_gain & TAG_RG_TRACK)
+		&& tag_rg_add(&tags, "replaygain_track_gain", r->loudness, 0))
 		goto end;
-
-	// -18: ReplayGain target
-	// -1: EBU R 128: "The Maximum True-Peak Level in production shall not exceed −1 dBTP"
-	// e.g. -10 loudness -> -19 target = -9 gain
-	double rg = -18-1 - t->oaudio.loudness;
-
-	char val[8]; // "-xx.xx"
-	uint n = ffs_fromfloat(rg, val, sizeof(val) - 1, FFS_FLTKEEPSIGN | FFS_FLTWIDTH(3) | FFS_FLTZERO | 2);
-	if (!n) {
-		phi_errlog(x->core, NULL, t, "ffs_fromfloat");
+	if ((tt->replay_gain & (TAG_RG_TRACK | TAG_RG_PEAK)) == (TAG_RG_TRACK | TAG_RG_PEAK)
+		&& tag_rg_add(&tags, "replaygain_track_peak", r->peak, 1))
 		goto end;
+	if (album) {
+		if (tag_rg_add(&tags, "replaygain_album_gain", album[0], 0))
+			goto end;
+		if ((tt->replay_gain & TAG_RG_PEAK)
+			&& tag_rg_add(&tags, "replaygain_album_peak", album[1], 1))
+			goto end;
 	}
-	val[n] = '\0';
-
-	ffvec_add2T(&tags, &tt->meta, ffstr);
-	size_t cap = 0;
-	ffstr_growfmt(&s, &cap, "replaygain_track_gain=%s", val);
-	*ffvec_pushT(&tags, ffstr) = s;
 
 	struct phi_tag_conf conf = {
-		.filename = t->conf.ifile.name,
+		.filename = r->filename,
 		.meta = *(ffslice*)&tags,
 		.clear = tt->clear,
 		.preserve_date = tt->preserve_date,
@@ -126,14 +180,98 @@ static void tag_grd_close(void *f, phi_track *t)
 	rc = 0;
 
 end:
-	ffstr_free(&s);
+	for (ffsize i = tt->meta.len;  i < tags.len;  i++) {
+		ffstr_free(&((ffstr*)tags.ptr)[i]);
+	}
 	ffvec_free(&tags);
 	if (rc)
 		x->exit_code = 1;
+	return rc;
+}
+
+/** All files are analyzed: write the tags with album gain
+Thread: main */
+static void tag_rg_album(void *param)
+{
+	struct cmd_tag *tt = param;
+	const phi_loudness_album_if *la = x->core->mod("afilter.loudness-album");
+	double album[2] = { -INFINITY, 0 };
+	uint n = (la) ? la->get(tt->rg_queue, &album[0], &album[1]) : 0;
+	phi_dbglog(x->core, NULL, NULL, "album: tracks:%u  loudness:%f  peak:%f"
+		, n, album[0], album[1]);
+
+	struct tag_rg_result *r;
+	FFSLICE_WALK(&tt->rg_results, r) {
+		tag_rg_write(tt, r, album);
+	}
+
+	q_on_change(NULL, '.', 0);
+}
+
+static void tag_q_on_change(phi_queue_id q, uint flags, uint pos)
+{
+	struct cmd_tag *tt = x->subcmd.obj;
+	if ((flags & 0xff) == '.' && (tt->replay_gain & TAG_RG_ALBUM)) {
+		fflock_lock(&tt->rg_lock);
+		tt->rg_done = 1;
+		tt->rg_queue = q;
+		uint last = (tt->rg_active == 0);
+		fflock_unlock(&tt->rg_lock);
+		if (last)
+			tag_rg_album(tt);
+		// else: the last track will finish the job
+		return;
+	}
+
+	q_on_change(q, flags, pos);
+}
+
+static void* tag_grd_open(phi_track *t)
+{
+	struct cmd_tag *tt = x->subcmd.obj;
+	fflock_lock(&tt->rg_lock);
+	tt->rg_active++;
+	fflock_unlock(&tt->rg_lock);
+	return (void*)1;
+}
+
+/**
+Thread: worker */
+static void tag_grd_close(void *f, phi_track *t)
+{
+	struct cmd_tag *tt = x->subcmd.obj;
+	x->core->track->stop(t);
+
+	if (t->error) {
+		x->exit_code = 1;
+
+	} else {
+		struct tag_rg_result r = {
+			.filename = t->conf.ifile.name,
+			.loudness = t->oaudio.loudness,
+			.peak = t->oaudio.loudness_peak,
+		};
+
+		if (!(tt->replay_gain & TAG_RG_ALBUM)) {
+			tag_rg_write(tt, &r, NULL);
+		} else {
+			r.filename = ffsz_dup(r.filename);
+			fflock_lock(&tt->rg_lock);
+			*ffvec_pushT(&tt->rg_results, struct tag_rg_result) = r;
+			fflock_unlock(&tt->rg_lock);
+		}
+	}
+
+	fflock_lock(&tt->rg_lock);
+	tt->rg_active--;
+	uint last = (tt->rg_done && tt->rg_active == 0);
+	fflock_unlock(&tt->rg_lock);
+	if (last)
+		x->core->task(0, &tt->rg_task, tag_rg_album, tt);
 }
 
 static const phi_filter tag_guard = {
-	NULL, tag_grd_close, phi_grd_process,
+	tag_grd_open, tag_grd_close, phi_grd_process,
 	"tag-guard"
 };
 
@@ -143,7 +281,7 @@ static int tag_action(struct cmd_tag *t)
 	int r = 0;
 
 	if (t->replay_gain) {
-		x->queue->on_change(q_on_change);
+		x->queue->on_change(tag_q_on_change);
 
 		struct phi_track_conf c = {
 			.ifile = {
@@ -208,6 +346,7 @@ static const struct ffarg cmd_tag_args[] = {
 	{ "-include",		'+S',	tag_include },
 	{ "-meta",			'+S',	tag_meta },
 	{ "-preserve_date",	'1',	O(preserve_date) },
+	{ "-replay-gain",	0,		tag_replay_gain_all },
 	{ "-rg",			's',	tag_replay_gain },
 	{ "\0\1",			'S',	tag_input },
 	{ "",				0,		tag_prepare },
@@ -216,6 +355,11 @@ static const struct ffarg cmd_tag_args[] = {
 
 static void cmd_tag_free(struct cmd_tag *t)
 {
+	struct tag_rg_result *r;
+	FFSLICE_WALK(&t->rg_results, r) {
+		ffmem_free(r->filename);
+	}
+	ffvec_free(&t->rg_results);
 	ffvec_free(&t->input);
 	ffvec_free(&t->meta);
 	ffmem_free(t);
@@ -476,7 +476,22 @@ err:
 	return 0;
 }
 
-static int tag_opus_r128_track_gain(vorbistagwrite *vtw, ffstr v)
+/** Get the name of Opus R128 tag for a ReplayGain tag.
+Return NULL if the tag isn't related to ReplayGain;
+  "": the tag isn't supported by Opus */
+static const char* tag_opus_r128_name(ffstr k)
+{
+	if (ffstr_ieqz(&k, "REPLAYGAIN_TRACK_GAIN"))
+		return "R128_TRACK_GAIN";
+	if (ffstr_ieqz(&k, "REPLAYGAIN_ALBUM_GAIN"))
+		return "R128_ALBUM_GAIN";
+	if (ffstr_ieqz(&k, "REPLAYGAIN_TRACK_PEAK")
+		|| ffstr_ieqz(&k, "REPLAYGAIN_ALBUM_PEAK"))
+		return "";
+	return NULL;
+}
+
+static int tag_opus_r128_gain(vorbistagwrite *vtw, const char *name, ffstr v)
 {
 	int r;
 	double d;
@@ -489,7 +504,7 @@ static int tag_opus_r128_track_gain(vorbistagwrite *vtw, ffstr v)
 	char val[8];
 	v.ptr = val;
 	v.len = ffs_fromint(r, val, sizeof(val), FFS_INTSIGN);
-	ffstr k = FFSTR_Z("R128_TRACK_GAIN");
+	ffstr k = FFSTR_Z(name);
 	if (!vorbistagwrite_add_name(vtw, k, v))
 		dbglog("vorbistag: written %S = %S", &k, &v);
 	return 0;
@@ -497,6 +512,7 @@ static int tag_opus_r128_track_gain(vorbistagwrite *vtw, ffstr v)
 
 static int tag_ogg_process(struct tag_edit *t, vorbistagwrite *vtw, ffstr vtag, uint format)
 {
+	const char *r128;
 	int rc = -1, r;
 	uint i;
 	ffstr *kv, k, v;
@@ -530,16 +546,21 @@ static int tag_ogg_process(struct tag_edit *t, vorbistagwrite *vtw, ffstr vtag,
 				goto end;
 			}
 
-			if (format == 'o' && ffstr_ieqz(&k, "R128_TRACK_GAIN"))
-				ffstr_setz(&k, "REPLAYGAIN_TRACK_GAIN");
+			if (format == 'o') {
+				if (ffstr_ieqz(&k, "R128_TRACK_GAIN"))
+					ffstr_setz(&k, "REPLAYGAIN_TRACK_GAIN");
+				else if (ffstr_ieqz(&k, "R128_ALBUM_GAIN"))
+					ffstr_setz(&k, "REPLAYGAIN_ALBUM_GAIN");
+			}
 
 			if ((r = user_meta_find(&t->conf.meta, k, &v)) >= 0) {
 				// Write user tag
 				ffbit_set32(&tags_added, r);
 
-				if (tag == MMTAG_REPLAYGAIN_TRACK_GAIN && format == 'o') {
-					// Write R128_TRACK_GAIN tag instead of REPLAYGAIN_TRACK_GAIN
-					tag_opus_r128_track_gain(vtw, v);
+				if (format == 'o' && (r128 = tag_opus_r128_name(k))) {
+					// Write R128_*_GAIN tag instead of REPLAYGAIN_*_GAIN
+					if (r128[0])
+						tag_opus_r128_gain(vtw, r128, v);
 					continue;
 				}
 			}
@@ -560,9 +581,10 @@ static int tag_ogg_process(struct tag_edit *t, vorbistagwrite *vtw, ffstr vtag,
 		if (i - 1 < 32 && ffbit_test32(&tags_added, i - 1))
 			continue; // Tag is already added
 
-		if (tag == MMTAG_REPLAYGAIN_TRACK_GAIN && format == 'o') {
-			// Write R128_TRACK_GAIN tag instead of REPLAYGAIN_TRACK_GAIN
-			tag_opus_r128_track_gain(vtw, v);
+		if (format == 'o' && (r128 = tag_opus_r128_name(k))) {
+			// Write R128_*_GAIN tag instead of REPLAYGAIN_*_GAIN
+			if (r128[0])
+				tag_opus_r128_gain(vtw, r128, v);
 			continue;
 		}
 
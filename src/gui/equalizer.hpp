@@ -137,9 +137,12 @@ static void weqlz_action(ffui_window *wnd, int id)
 	case A_EQ_GAIN:
 		w->band->gain_set(w->tbgain.get());
 
-	eq_apply:
-		w->eeqlz.text(w->eqlz.str().strz());
+	eq_apply: {
+		xxvec v = w->eqlz.str();
+		w->eeqlz.text(v.strz());
+		gui_core_task_ptr(eqlz_live_set, ffsz_dup(v.strz()));
 		break;
+	}
 
 	case A_EQ_CLOSED:
 		ffmem_free(gg->eqlz);
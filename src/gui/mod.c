@@ -18,6 +18,7 @@ const phi_core *core;
 struct gui_data *gd;
 
 #define AUTO_LIST_FN  "list%u.m3uz"
+#define META_CACHE_FN  "meta.cache"
 #ifdef FF_WIN
 	#define USER_CONF_DIR  "%APPDATA%\\phiola\\"
 #else
@@ -381,6 +382,15 @@ void list_conf_set(void *new_conf)
 	ffmem_free(nc);
 
 	qc_apply();
+	gd->eq_if->update((gd->conf.eqlz_on) ? gd->conf.eqlz : NULL);
+}
+
+/** Apply the equalizer settings to the track being played */
+void eqlz_live_set(void *sz)
+{
+	if (gd->conf.eqlz_on)
+		gd->eq_if->update(sz);
+	ffmem_free(sz);
 }
 
 void ctl_play(uint i)
@@ -952,6 +962,7 @@ static void gui_start(void *param)
 	gd->marker_sec = ~0;
 	gd->conf.volume = 100;
 	gd->queue = core->mod("core.queue");
+	gd->eq_if = core->mod("afilter.eq-live");
 
 	char *user_conf_fn = ffsz_allocfmt("%Smod/gui/%s", &core->conf.root, USER_CONF_NAME_ALT);
 	if (fffile_exists(user_conf_fn)) {
@@ -963,6 +974,10 @@ static void gui_start(void *param)
 		gd->user_conf_name = ffsz_allocfmt("%s%s", gd->user_conf_dir, USER_CONF_NAME);
 	}
 
+	char *mc_fn = ffsz_allocfmt("%s" META_CACHE_FN, gd->user_conf_dir);
+	gd->queue->meta_cache(mc_fn);
+	ffmem_free(mc_fn);
+
 	gui_init();
 	gui_userconf_load();
 	conf_norm();
@@ -49,6 +49,7 @@ FF_EXTERN void list_select(uint i);
 FF_EXTERN void list_filter(ffstr filter);
 FF_EXTERN struct phi_queue_entry* list_vis_qe_ref(uint i);
 FF_EXTERN void list_conf_set(void *new_conf);
+FF_EXTERN void eqlz_live_set(void *sz);
 
 FF_EXTERN void ctl_play(uint i);
 FF_EXTERN void volume_set(uint vol);
@@ -128,6 +129,7 @@ struct gui_data {
 	const phi_queue_if *queue;
 	const phi_filter *playback_first_filter;
 	const phi_adev_if *adev_if;
+	const phi_equalizer_if *eq_if;
 	char *user_conf_dir;
 	char *user_conf_name;
 	phi_task task;
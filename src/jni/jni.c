@@ -111,6 +111,7 @@ struct phiola_jni {
 	} convert;
 
 	const phi_tag_if *tag_if;
+	const phi_equalizer_if *eq_if;
 
 	phi_timer tmr_q_draw;
 	phi_queue_id q_adding;
@@ -340,6 +340,12 @@ static void qc_apply()
 	if (!ffsz_eq_safe(qc->tconf.afilter.equalizer, x->play.equalizer)) {
 		ffmem_free(qc->tconf.afilter.equalizer);
 		qc->tconf.afilter.equalizer = (x->play.equalizer) ? ffsz_dup(x->play.equalizer) : NULL;
+
+		// apply to the track being played
+		if (!x->eq_if)
+			x->eq_if = x->core->mod("afilter.eq-live");
+		if (x->eq_if && x->eq_if->update)
+			x->eq_if->update(x->play.equalizer);
 	}
 }
 
@@ -450,6 +450,7 @@ static void* httpcl_open(phi_track *t)
 	if (!t->input.seek)
 		t->input.seek = ~0ULL;
 
+	t->worker_bound++; // the connection is attached to our worker's kernel queue
 	return h;
 }
 
@@ -461,6 +462,7 @@ static void httpcl_close(struct httpcl *h, phi_track *t)
 	hls_free(h, h->hls);
 	ffring_free(h->buf);
 	nml_cache_interface.destroy(h->conn_cache);
+	t->worker_bound--;
 	phi_track_free(t, h);
 }
 
@@ -0,0 +1,276 @@
+/** phiola: audio server: encoded data buffer
+2026, Simon Zolin */
+
+/*
+The encoded data is stored in a list of segments:
+ the writer appends data to the last segment;
+ the old segments are released periodically.
+A client references the segment it's sending data from,
+ so the data is passed to the socket without copying
+ and the segment stays valid even after it's released by the writer.
+The writer, the readers and the releaser may run on different threads:
+ the list is modified and traversed under lock,
+ but the data within the referenced segment is read without locking
+ (the writer publishes the new length after the data is copied).
+A reader takes the lock only when it moves to the next segment (once per up to 64KB),
+ and the lock is held for a few pointer operations.
+Lock-free cursors would save little here,
+ but a reader would then need a safe memory reclamation scheme (hazard pointers or epochs)
+ to reference the segment that the releaser may be freeing at the same time.
+
+        (released)     (list)
+client -> [seg]        [seg] -> [seg] -> [seg] <- writer
+                                 ^
+                               client
+
+Each write is a whole frame (AAC ADTS frame or Ogg page).
+The sync points (struct svbuf_sync) are the positions of some of the frames
+ (one per 'interval' of audio), so a new client can start reading from a frame boundary.
+*/
+
+#pragma once
+#include <ffbase/string.h>
+#include <ffbase/lock.h>
+
+struct svbuf_seg {
+	struct svbuf_seg *next;
+	uint refs;
+	uint64 off; // position of the first byte in stream
+	size_t len, cap;
+	uint closed; // the writer won't add more data
+	char data[0];
+};
+
+struct svbuf {
+	fflock lock;
+	struct svbuf_seg *first, *last;
+	uint64 wpos; // total bytes written
+	size_t size, limit; // bytes allocated for the segments in list
+	size_t seg_size;
+};
+
+struct svbuf_reader {
+	struct svbuf_seg *seg; // the segment being read (referenced)
+	uint64 pos;
+};
+
+static inline void svbuf_init(struct svbuf *b, size_t limit)
+{
+	ffmem_zero_obj(b);
+	fflock_init(&b->lock);
+	b->limit = limit;
+	b->seg_size = ffmin(ffmax(limit / 8, 1024), 64*1024);
+}
+
+static inline void svbuf_seg_unref(struct svbuf_seg *g)
+{
+	if (ffint_fetch_add(&g->refs, -1) == 1)
+		ffmem_free(g);
+}
+
+/** Release the first segment in list */
+static void _svbuf_rm_first(struct svbuf *b)
+{
+	struct svbuf_seg *g = b->first;
+	b->first = g->next;
+	if (!b->first)
+		b->last = NULL;
+	b->size -= g->cap;
+	g->next = NULL;
+	svbuf_seg_unref(g);
+}
+
+static inline void svbuf_destroy(struct svbuf *b)
+{
+	fflock_lock(&b->lock);
+	while (b->first) {
+		_svbuf_rm_first(b);
+	}
+	fflock_unlock(&b->lock);
+}
+
+/** Add data to the buffer.
+Return 0 if there's no free space */
+static inline int svbuf_write(struct svbuf *b, const void *data, size_t len)
+{
+	struct svbuf_seg *g = b->last;
+	if (!g || g->cap - g->len < len) {
+		size_t cap = ffmax(b->seg_size, len);
+		g = ffmem_alloc(sizeof(struct svbuf_seg) + cap);
+		g->next = NULL;
+		g->refs = 1;
+		g->off = b->wpos;
+		g->len = 0;
+		g->cap = cap;
+		g->closed = 0;
+
+		fflock_lock(&b->lock);
+		if (b->first && b->size + cap > b->limit) {
+			fflock_unlock(&b->lock);
+			ffmem_free(g);
+			return 0;
+		}
+		b->size += cap;
+		if (b->last) {
+			ffcpu_fence_release();
+			FFINT_WRITEONCE(b->last->closed, 1);
+			b->last->next = g;
+		} else {
+			b->first = g;
+		}
+		b->last = g;
+		fflock_unlock(&b->lock);
+	}
+
+	ffmem_copy(g->data + g->len, data, len);
+	ffcpu_fence_release();
+	FFINT_WRITEONCE(g->len, g->len + len);
+	b->wpos += len;
+	return 1;
+}
+
+/** Release the segments containing only the data before 'pos'.
+The segment being written is never released. */
+static inline void svbuf_release(struct svbuf *b, uint64 pos)
+{
+	fflock_lock(&b->lock);
+	while (b->first != b->last
+		&& b->first->off + b->first->len <= pos) {
+		_svbuf_rm_first(b);
+	}
+	fflock_unlock(&b->lock);
+}
+
+/** Position of the next data to be written */
+static inline uint64 svbuf_wpos(struct svbuf *b)
+{
+	return FFINT_READONCE(b->wpos);
+}
+
+/** Position of the oldest data in buffer */
+static inline uint64 svbuf_rpos(struct svbuf *b)
+{
+	fflock_lock(&b->lock);
+	uint64 pos = (b->first) ? b->first->off : b->wpos;
+	fflock_unlock(&b->lock);
+	return pos;
+}
+
+/** Get the next contiguous data for a reader.
+If the data at the reader's position is already released, the reader skips to the oldest data.
+'data' stays valid until the next call.
+Return the number of bytes;  0: no data */
+static inline size_t svbuf_read(struct svbuf *b, struct svbuf_reader *r, size_t limit, ffstr *data)
+{
+	struct svbuf_seg *g = r->seg;
+	size_t len = 0;
+	if (g) {
+		uint closed = FFINT_READONCE(g->closed);
+		ffcpu_fence_acquire();
+		len = FFINT_READONCE(g->len);
+		ffcpu_fence_acquire();
+		if (r->pos == g->off + len && closed) {
+			// this segment won't receive more data
+			svbuf_seg_unref(g);
+			r->seg = g = NULL;
+		}
+	}
+
+	if (!g) {
+		fflock_lock(&b->lock);
+		if (!(g = b->first)) {
+			fflock_unlock(&b->lock);
+			return 0;
+		}
+		if (r->pos < g->off)
+			r->pos = g->off;
+		while (g->off + g->len <= r->pos && g->next) {
+			g = g->next;
+		}
+		ffint_fetch_add(&g->refs, 1);
+		len = FFINT_READONCE(g->len);
+		fflock_unlock(&b->lock);
+		ffcpu_fence_acquire();
+		r->seg = g;
+	}
+
+	size_t n = ffmin(g->off + len - r->pos, limit);
+	ffstr_set(data, g->data + (r->pos - g->off), n);
+	r->pos += n;
+	return n;
+}
+
+static inline void svbuf_reader_close(struct svbuf_reader *r)
+{
+	if (r->seg) {
+		svbuf_seg_unref(r->seg);
+		r->seg = NULL;
+	}
+}
+
+
+struct svbuf_syncpt {
+	uint64 off; // position in buffer
+	uint64 pos; // audio position (samples)
+};
+
+struct svbuf_sync {
+	fflock lock;
+	struct svbuf_syncpt *pts; // ring buffer
+	uint cap;
+	uint n; // sync points added
+	uint interval; // min. audio distance between the sync points (samples)
+	uint64 head_pos; // audio position of the last frame
+};
+
+static inline void svbuf_sync_init(struct svbuf_sync *sp, uint cap, uint interval)
+{
+	ffmem_zero_obj(sp);
+	fflock_init(&sp->lock);
+	sp->pts = ffmem_calloc(cap, sizeof(struct svbuf_syncpt));
+	sp->cap = cap;
+	sp->interval = interval;
+}
+
+static inline void svbuf_sync_destroy(struct svbuf_sync *sp)
+{
+	ffmem_free(sp->pts);
+	sp->pts = NULL;
+}
+
+/** Add the frame that begins at 'off' */
+static inline void svbuf_sync_add(struct svbuf_sync *sp, uint64 off, uint64 pos)
+{
+	FFINT_WRITEONCE(sp->head_pos, pos);
+	if (sp->n && pos < sp->pts[(sp->n - 1) % sp->cap].pos + sp->interval)
+		return;
+
+	fflock_lock(&sp->lock);
+	struct svbuf_syncpt *pt = &sp->pts[sp->n % sp->cap];
+	pt->off = off;
+	pt->pos = pos;
+	sp->n++;
+	fflock_unlock(&sp->lock);
+}
+
+/** Find the latest sync point located at least 'samples' before the last frame.
+min_off: the sync points before this position aren't used
+Return buffer position;  ~0: not found */
+static inline uint64 svbuf_sync_find(struct svbuf_sync *sp, uint64 samples, uint64 min_off)
+{
+	uint64 head = FFINT_READONCE(sp->head_pos);
+	uint64 target = (head > samples) ? head - samples : 0;
+	uint64 off = ~0ULL;
+
+	fflock_lock(&sp->lock);
+	for (uint i = sp->n;  i != 0 && sp->n - i < sp->cap;  i--) {
+		const struct svbuf_syncpt *pt = &sp->pts[(i - 1) % sp->cap];
+		if (pt->off < min_off)
+			break;
+		off = pt->off;
+		if (pt->pos <= target)
+			break;
+	}
+	fflock_unlock(&sp->lock);
+	return off;
+}
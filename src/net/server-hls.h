@@ -0,0 +1,179 @@
+/** phiola: audio server: HLS segments
+2026, Simon Zolin */
+
+/*
+The encoded AAC stream is split into segments (HLS packed audio):
+ each segment contains the ADTS frames with the total duration not less than 'seg_msec'
+ and begins with ID3 tag containing the timestamp of the first sample.
+The last completed segments are kept in memory;
+ the live playlist lists the most recent of them.
+A client references the segment it's sending,
+ so the segment stays valid after it's removed from cache.
+The writer and the readers may run on different threads:
+ the cache is accessed under lock.
+*/
+
+#pragma once
+#include <ffbase/vector.h>
+#include <ffbase/lock.h>
+
+#define SVHLS_CACHE  6 // max. segments in cache
+#define SVHLS_LIST  3 // segments listed in playlist
+
+struct svhls_seg {
+	uint refs;
+	uint seq;
+	uint duration_msec;
+	size_t len;
+	char data[0];
+};
+
+struct svhls {
+	fflock lock;
+	struct svhls_seg *segs[SVHLS_CACHE]; // completed segments: [seq % SVHLS_CACHE]
+	uint n; // number of completed segments
+	uint seg_msec;
+	uint rate;
+	ffvec cur; // the segment being written
+	uint64 cur_start; // position of the first sample in the segment being written
+};
+
+static inline void svhls_init(struct svhls *h, uint seg_msec, uint rate)
+{
+	ffmem_zero_obj(h);
+	fflock_init(&h->lock);
+	h->seg_msec = seg_msec;
+	h->rate = rate;
+}
+
+static inline void svhls_seg_unref(struct svhls_seg *g)
+{
+	if (ffint_fetch_add(&g->refs, -1) == 1)
+		ffmem_free(g);
+}
+
+static inline void svhls_destroy(struct svhls *h)
+{
+	for (uint i = 0;  i < SVHLS_CACHE;  i++) {
+		if (h->segs[i])
+			svhls_seg_unref(h->segs[i]);
+	}
+	ffvec_free(&h->cur);
+}
+
+/** Write ID3v2.4 tag with PRIV frame containing MPEG-2 timestamp (90kHz) */
+static void _svhls_id3_ts(ffvec *buf, uint64 ts)
+{
+	static const char owner[] = "com.apple.streaming.transportStreamTimestamp";
+	uint frame_len = sizeof(owner) + 8;
+	uint tag_len = 10 + frame_len;
+	ffvec_grow(buf, 10 + tag_len, 1);
+	u_char *p = (u_char*)buf->ptr + buf->len;
+
+	ffmem_copy(p, "ID3\x04\x00\x00", 6);
+	for (uint i = 0;  i < 4;  i++) {
+		p[6 + i] = (tag_len >> ((3 - i) * 7)) & 0x7f;
+	}
+	p += 10;
+
+	ffmem_copy(p, "PRIV", 4);
+	for (uint i = 0;  i < 4;  i++) {
+		p[4 + i] = (frame_len >> ((3 - i) * 7)) & 0x7f;
+	}
+	p[8] = p[9] = 0;
+	p += 10;
+
+	ffmem_copy(p, owner, sizeof(owner));
+	p += sizeof(owner);
+	ts &= 0x1ffffffffULL;
+	for (uint i = 0;  i < 8;  i++) {
+		p[i] = (u_char)(ts >> ((7 - i) * 8));
+	}
+
+	buf->len += 10 + tag_len;
+}
+
+/** Complete the current segment and add it to cache */
+static void _svhls_seg_fin(struct svhls *h, uint64 end_pos)
+{
+	struct svhls_seg *g = ffmem_alloc(sizeof(struct svhls_seg) + h->cur.len);
+	g->refs = 1;
+	g->seq = h->n;
+	g->duration_msec = (end_pos - h->cur_start) * 1000 / h->rate;
+	g->len = h->cur.len;
+	ffmem_copy(g->data, h->cur.ptr, h->cur.len);
+	h->cur.len = 0;
+
+	fflock_lock(&h->lock);
+	struct svhls_seg *old = h->segs[g->seq % SVHLS_CACHE];
+	h->segs[g->seq % SVHLS_CACHE] = g;
+	FFINT_WRITEONCE(h->n, h->n + 1);
+	fflock_unlock(&h->lock);
+
+	if (old)
+		svhls_seg_unref(old);
+}
+
+/** Add audio frame.
+pos: position of the first sample in the frame */
+static inline void svhls_write(struct svhls *h, const void *data, size_t len, uint64 pos)
+{
+	if (h->cur.len
+		&& (pos - h->cur_start) * 1000 >= (uint64)h->seg_msec * h->rate)
+		_svhls_seg_fin(h, pos);
+
+	if (!h->cur.len) {
+		h->cur_start = pos;
+		_svhls_id3_ts(&h->cur, pos * 90000 / h->rate);
+	}
+	ffvec_add(&h->cur, data, len, 1);
+}
+
+/** Get a referenced segment by its sequence number.
+Return NULL if it's not in cache */
+static inline struct svhls_seg* svhls_seg_get(struct svhls *h, uint seq)
+{
+	struct svhls_seg *g = NULL;
+	fflock_lock(&h->lock);
+	if (seq < h->n && h->n - seq <= SVHLS_CACHE) {
+		g = h->segs[seq % SVHLS_CACHE];
+		ffint_fetch_add(&g->refs, 1);
+	}
+	fflock_unlock(&h->lock);
+	return g;
+}
+
+/** Write live playlist.
+name: segment file name prefix;  a segment's URL is "NAME-SEQ.aac"
+Return 0 if there are no segments yet */
+static inline int svhls_playlist(struct svhls *h, ffvec *buf, ffstr name)
+{
+	fflock_lock(&h->lock);
+	uint n = h->n;
+	if (n == 0) {
+		fflock_unlock(&h->lock);
+		return 0;
+	}
+
+	uint first = (n > SVHLS_LIST) ? n - SVHLS_LIST : 0;
+	uint target = 1;
+	for (uint i = first;  i < n;  i++) {
+		target = ffmax(target, (h->segs[i % SVHLS_CACHE]->duration_msec + 500) / 1000);
+	}
+
+	buf->len = 0;
+	ffvec_addfmt(buf, "#EXTM3U\n"
+		"#EXT-X-VERSION:3\n"
+		"#EXT-X-TARGETDURATION:%u\n"
+		"#EXT-X-MEDIA-SEQUENCE:%u\n"
+		, target, first);
+	for (uint i = first;  i < n;  i++) {
+		uint ms = h->segs[i % SVHLS_CACHE]->duration_msec;
+		ffvec_addfmt(buf, "#EXTINF:%u.%03u,\n"
+			"%S-%u.aac\n"
+			, ms / 1000, ms % 1000
+			, &name, i);
+	}
+	fflock_unlock(&h->lock);
+	return 1;
+}
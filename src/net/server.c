@@ -2,10 +2,34 @@
 2025, Simon Zolin */
 
 /*
-                                                          -> consumer -> ac.enc -> format.write -> server ->
-                                                        (ring)                                          (ring)
-file.read -> format.read -> ac.dec -> af.conv -> provider ->                                              -> http.server.conn
+                                                        (ring)                         (ring)
+file.read -> format.read -> ac.dec -> af.conv -> provider -> consumer -> server (#1) -> mount-src -> af.conv -> ac.enc -> format.write -> mount-out ->
+...                                                                                 \                                                            (buffer)
+                                                                                     -> mount-src -> ... (#2)                                         -> http.server.conn
 ...
+
+The main track passes the decoded audio to the encoder tracks, one per mount point.
+Each mount point has its own encoded data buffer and its own set of listeners.
+The encoder tracks run on different workers.
+
+With HLS enabled, the AAC stream of a mount point is also split into segments (see server-hls.h):
+ "/NAME.m3u8" is the live playlist, "/NAME-SEQ.aac" are the segments
+ (e.g. "/hi.m3u8" and "/hi-1.aac" for "/hi.aac" mount point).
+
+A new client first receives the last 'burst' seconds of the encoded data at once,
+ starting at a frame boundary (see struct svbuf_sync),
+ so the player can start without waiting until its buffer is filled in real time.
+The timer doesn't release the data within the burst window.
+
+The clients may be served by several workers (shards):
+ each shard runs its own HTTP server instance listening on the same port (SO_REUSEPORT),
+ and the clients read the encoded data from the shared buffer.
+Encoding runs on the main track's worker.
+When new data is written, each shard is notified via a task on its worker,
+ so the suspended clients are woken up within their own worker.
+When an encoder track is closed (e.g. on error), the clients of its mount point
+ receive the rest of the encoded data and are disconnected;
+ new requests for this mount point are rejected.
 */
 
 #include <track.h>
@@ -13,6 +37,8 @@ file.read -> format.read -> ac.dec -> af.conv -> provider ->
 #include <http-server/conn.h>
 #include <avpack/icy.h>
 #include <ffbase/ring.h>
+#include <net/server-buf.h>
+#include <net/server-hls.h>
 
 extern const phi_core *core;
 #define errlog(t, ...)  phi_errlog(core, "audio-server", t, __VA_ARGS__)
@@ -26,35 +52,85 @@ extern const struct nml_tcp_listener_if nml_tcp_listener_interface;
 #define AUSV_CLIENT_BUF_SIZE_KB  16
 #define ERRORS_MAX  20
 
-struct ausv {
-	nml_http_server *sv;
+struct ausv;
+struct ausv_shard;
+
+/** Suspended clients of a mount point within a shard */
+struct ausv_listeners {
+	struct ausv_shard *sh;
 	ffvec clients_paused; // nml_http_sv_conn*[]
+	uint wake_pending;
+	phi_task task_wake;
+};
+
+struct ausv_shard {
+	struct ausv *s;
+	nml_http_server *sv;
+	struct ausv_listeners *lst; // [n_mounts]
+	uint worker;
+	phi_task task_run, task_close;
+};
+
+struct ausv_mount {
+	struct ausv *s;
+	uint index;
+	char *path;
+	fflock lock; // protects 'trk' and 'parent'
+	phi_track *trk; // encoder track
+	phi_track *parent; // main track
+	ffring *iring; // audio data from the main track
+	ffring_head rh;
+	size_t fan_off; // bytes of the current input chunk written to 'iring'
+	struct svbuf obuf; // encoded data
+	struct svbuf_sync sync; // frame positions within 'obuf'
+	ffvec header; // OGG Opus header
+	ffstr resp_headers;
+	struct svhls hls;
+	char *hls_path; // "/NAME";  NULL: HLS is disabled
+	ffstr hls_name; // "NAME"
+	uint64 half_pos;
+	uint kbps;
+	uint pkt;
+	uint src_paused;
+	uint output_full;
+	uint closed;
+	uint ogg_opus :1;
+};
+
+struct ausv {
+	struct ausv_shard *shards;
+	uint n_shards;
+	uint shards_active;
+	struct ausv_mount *mounts;
+	uint n_mounts;
+	uint mounts_active;
 	struct nml_address addr;
 	phi_track *trk, *subtrack;
 	phi_task task;
 	phi_timer tmr;
 	const phi_queue_if *qif;
-	ffring *iring, *oring;
+	ffring *iring;
 	ffring_head rh;
+	fflock meta_lock;
 	ffvec meta;
-	ffstr resp_headers;
 	ffstr input;
+	ffstr fan; // audio data being passed to the encoder tracks
 	uint64 total_msec;
 	uint64 next_pos_samples;
 	size_t buf_half_samples;
-	size_t half_pos;
+	uint64 burst_samples;
+	uint burst_msec;
 	uint worker;
 	uint clients;
 	uint qi;
-	uint pkt;
+	uint fanout_paused;
 	u_char consecutive_errors;
 	u_char meta_uid;
-	uint ogg_opus :1;
+	uint icy :1;
 	uint consumer_paused :1;
 	uint provider_paused :1;
-	uint output_full :1;
 };
-static struct ausv *gs;
+static __thread struct ausv_shard *gshard; // the shard being configured within this thread
 
 static void ausv_track_closed(struct ausv *s, uint stop, uint error);
 
@@ -76,39 +152,42 @@ static void ausv_consumer_paused(struct ausv *s)
 	}
 }
 
-static void ausv_client_paused(struct ausv *s, nml_http_sv_conn *hsc)
+static void ausv_client_paused(struct ausv_listeners *lst, nml_http_sv_conn *hsc)
 {
-	*ffvec_pushT(&s->clients_paused, nml_http_sv_conn*) = hsc;
+	*ffvec_pushT(&lst->clients_paused, nml_http_sv_conn*) = hsc;
 }
 
-static void ausv_client_connected(struct ausv *s, nml_http_sv_conn *c)
+static void ausv_client_connected(struct ausv_shard *sh, nml_http_sv_conn *c)
 {
-	s->clients++;
+	ffint_fetch_add(&sh->s->clients, 1);
 }
 
-static void ausv_client_closed(struct ausv *s, nml_http_sv_conn *c)
+static void ausv_client_closed(struct ausv_listeners *lst, nml_http_sv_conn *c)
 {
-	s->clients--;
+	ffint_fetch_add(&lst->sh->s->clients, -1);
 
 	// Remove this client from the list of suspended clients
 	nml_http_sv_conn **hsc;
-	FFSLICE_WALK(&s->clients_paused, hsc) {
+	FFSLICE_WALK(&lst->clients_paused, hsc) {
 		if (*hsc == c) {
-			size_t i = hsc - (nml_http_sv_conn**)s->clients_paused.ptr;
-			ffslice_rmswapT((ffslice*)&s->clients_paused, i, 1, void*);
+			size_t i = hsc - (nml_http_sv_conn**)lst->clients_paused.ptr;
+			ffslice_rmswapT((ffslice*)&lst->clients_paused, i, 1, void*);
 			break;
 		}
 	}
 }
 
-static void ausv_client_unpause(struct ausv *s)
+/** Notify all suspended clients of the mount point to continue their work.
+Called within the shard's worker. */
+static void ausv_shard_wake(void *param)
 {
-	if (s->clients_paused.len) {
-		// Notify all suspended clients to continue their work
+	struct ausv_listeners *lst = param;
+	FFINT_WRITEONCE(lst->wake_pending, 0);
+	if (lst->clients_paused.len) {
 		nml_http_sv_conn **hsc;
 		ffvec v = {};
-		ffvec_add2T(&v, &s->clients_paused, void*);
-		s->clients_paused.len = 0;
+		ffvec_add2T(&v, &lst->clients_paused, void*);
+		lst->clients_paused.len = 0;
 		FFSLICE_WALK(&v, hsc) {
 			(*hsc)->conf->cl_wake(*hsc);
 		}
@@ -116,6 +195,16 @@ static void ausv_client_unpause(struct ausv *s)
 	}
 }
 
+static void ausv_client_unpause(struct ausv_mount *m)
+{
+	struct ausv *s = m->s;
+	for (uint i = 0;  i < s->n_shards;  i++) {
+		struct ausv_listeners *lst = &s->shards[i].lst[m->index];
+		if (0 == ffint_cmpxchg(&lst->wake_pending, 0, 1))
+			core->task(lst->sh->worker, &lst->task_wake, ausv_shard_wake, lst);
+	}
+}
+
 
 static void nml_log(void *log_obj, uint level, const char *ctx, const char *id, const char *format, ...)
 {
@@ -141,36 +230,36 @@ static void nml_log(void *log_obj, uint level, const char *ctx, const char *id,
 
 static struct zzkevent* nmlcore_kev_new(void *boss)
 {
-	struct ausv *s = boss;
-	return (struct zzkevent*)core->kev_alloc(s->worker);
+	struct ausv_shard *sh = boss;
+	return (struct zzkevent*)core->kev_alloc(sh->worker);
 }
 
 static void nmlcore_kev_free(void *boss, struct zzkevent *kev)
 {
-	struct ausv *s = boss;
-	core->kev_free(s->worker, (phi_kevent*)kev);
+	struct ausv_shard *sh = boss;
+	core->kev_free(sh->worker, (phi_kevent*)kev);
 }
 
 static int nmlcore_kq_attach(void *boss, ffsock sk, struct zzkevent *kev, void *obj)
 {
-	struct ausv *s = boss;
+	struct ausv_shard *sh = boss;
 	kev->obj = obj;
-	return core->kq_attach(s->worker, (phi_kevent*)kev, (fffd)sk, 0);
+	return core->kq_attach(sh->worker, (phi_kevent*)kev, (fffd)sk, 0);
 }
 
 static void nmlcore_timer(void *boss, nml_timer *tmr, int interval_msec, fftimerqueue_func func, void *param)
 {
-	struct ausv *s = boss;
-	core->timer(s->worker, (phi_timer*)tmr, interval_msec, func, param);
+	struct ausv_shard *sh = boss;
+	core->timer(sh->worker, (phi_timer*)tmr, interval_msec, func, param);
 }
 
 static void nmlcore_task(void *boss, nml_task *t, uint flags)
 {
-	struct ausv *s = boss;
+	struct ausv_shard *sh = boss;
 	if (flags == 0)
-		core->task(s->worker, (phi_task*)t, NULL, NULL);
+		core->task(sh->worker, (phi_task*)t, NULL, NULL);
 	else
-		core->task(s->worker, (phi_task*)t, t->handler, t->param);
+		core->task(sh->worker, (phi_task*)t, t->handler, t->param);
 }
 
 static fftime nmlcore_date(void *boss, ffstr *dts)
@@ -194,7 +283,7 @@ static const struct nml_core nmlcore = {
 static nml_wrk* nmlwrk_create(nml_core *core)
 {
 	*core = nmlcore;
-	return (nml_wrk*)gs;
+	return (nml_wrk*)gshard;
 }
 
 static void nmlwrk_free(nml_wrk *w)
@@ -223,16 +312,22 @@ static const nml_worker_if nmlwrk_if = {
 
 
 struct ausv_cl {
-	size_t rpos;
+	struct ausv_mount *m;
+	struct ausv_listeners *lst;
+	struct svbuf_reader rd;
+	ffvec meta; // OGG Opus header or ICY meta data or HLS playlist being sent
+	struct svhls_seg *hls_seg; // HLS segment being sent
 	uint icy_meta_off;
 	u_char last_meta_uid;
+	u_char meta_pending;
+	u_char hls;
 };
 
 /** Process HTTP request headers */
 static void phi_sv_req_headers(nml_http_sv_conn *c)
 {
-	const struct ausv *s = c->conf->opaque;
 	struct ausv_cl *sc = c->proxy;
+	const struct ausv_mount *m = sc->m;
 
 	ffstr h = HS_REQUEST_DATA(c, c->req.headers), name = {}, val = {};
 	for (;;) {
@@ -243,19 +338,81 @@ static void phi_sv_req_headers(nml_http_sv_conn *c)
 
 		if (ffstr_ieqz(&name, "Icy-MetaData")
 			&& ffstr_eqz(&val, "1")) {
-			c->resp.headers = s->resp_headers;
+			c->resp.headers = m->resp_headers;
 			sc->icy_meta_off = AUSV_CLIENT_BUF_SIZE_KB * 1024;
 		}
 	}
 }
 
+static struct ausv_mount* ausv_mount_find(struct ausv *s, ffstr path)
+{
+	for (uint i = 0;  i < s->n_mounts;  i++) {
+		if (ffstr_eqz(&path, s->mounts[i].path))
+			return &s->mounts[i];
+	}
+	return NULL;
+}
+
+/** Prepare HLS playlist or segment.
+Return 0 if the path doesn't match;  <0: not found */
+static int phi_sv_hls_open(nml_http_sv_conn *c, struct ausv *s, ffstr path)
+{
+	struct ausv_cl *sc = c->proxy;
+	for (uint i = 0;  i < s->n_mounts;  i++) {
+		struct ausv_mount *m = &s->mounts[i];
+		if (!m->hls_path || !ffstr_matchz(&path, m->hls_path))
+			continue;
+
+		ffstr name = path, num, ext;
+		ffstr_shift(&name, ffsz_len(m->hls_path));
+		if (ffstr_eqz(&name, ".m3u8")) {
+			if (!svhls_playlist(&m->hls, &sc->meta, m->hls_name))
+				return -1;
+			c->resp.content_length = sc->meta.len;
+			ffstr_setz(&c->resp.headers, "Content-Type: application/vnd.apple.mpegurl\r\n"
+				"Cache-Control: no-cache\r\n");
+
+		} else if (ffstr_matchz(&name, "-")) {
+			ffstr_shift(&name, 1);
+			ffstr_splitby(&name, '.', &num, &ext);
+			uint seq;
+			if (!ffstr_eqz(&ext, "aac")
+				|| !ffstr_to_uint32(&num, &seq))
+				continue;
+			if (!(sc->hls_seg = svhls_seg_get(&m->hls, seq)))
+				return -1;
+			c->resp.content_length = sc->hls_seg->len;
+			ffstr_setz(&c->resp.headers, "Content-Type: audio/aac\r\n"
+				"Cache-Control: max-age=60\r\n");
+
+		} else {
+			continue;
+		}
+
+		sc->hls = 1;
+		hs_response(c, HTTP_200_OK);
+		return 1;
+	}
+	return 0;
+}
+
+/** Get the position in buffer from which a new client starts receiving data:
+ the beginning of the frame (AAC) or page (Ogg) 'burst' seconds before the last encoded data */
+static uint64 ausv_burst_start(struct ausv_mount *m)
+{
+	uint64 off = svbuf_sync_find(&m->sync, m->s->burst_samples, svbuf_rpos(&m->obuf));
+	if (off == ~0ULL)
+		off = svbuf_wpos(&m->obuf); // no data yet
+	return off;
+}
+
 static int phi_sv_open(nml_http_sv_conn *c)
 {
-	struct ausv *s = c->conf->opaque;
+	struct ausv_shard *sh = c->conf->opaque;
+	struct ausv *s = sh->s;
 	struct ausv_cl *sc = ffmem_new(struct ausv_cl);
 	sc->icy_meta_off = ~0U;
-	sc->last_meta_uid = s->meta_uid - 1;
-	sc->rpos = s->oring->rtail;
+	sc->last_meta_uid = FFINT_READONCE(s->meta_uid) - 1;
 	c->proxy = sc;
 
 	ffstr method = HS_REQUEST_DATA(c, c->req.method);
@@ -265,96 +422,111 @@ static int phi_sv_open(nml_http_sv_conn *c)
 	}
 
 	ffstr path = HS_REQUEST_DATA(c, c->req.path);
-	if (!ffstr_eqz(&path, "/")) {
+	// a mount point path takes precedence over HLS file names (e.g. "/a-1.aac" mount point and "/a.aac" with HLS)
+	struct ausv_mount *m = ausv_mount_find(s, path);
+	if (!m && phi_sv_hls_open(c, s, path) > 0)
+		return NMLR_OPEN;
+
+	if (!m || FFINT_READONCE(m->closed)) {
+		// unknown path, or the encoder track of this mount point has been closed
 		hs_response_err(c, HTTP_404_NOT_FOUND);
 		return NMLR_DONE;
 	}
 
-	ausv_client_connected(s, c);
+	sc->m = m;
+	sc->lst = &sh->lst[m->index];
+	sc->rd.pos = ausv_burst_start(m);
+	ausv_client_connected(sh, c);
 	hs_response(c, HTTP_200_OK);
 	c->req_no_chunked = 1;
 
-	if (!s->ogg_opus)
+	if (!m->ogg_opus)
 		phi_sv_req_headers(c);
 
-	ffvec_alloc(&c->file.buf, AUSV_CLIENT_BUF_SIZE_KB * 1024, 1);
-	if (s->ogg_opus)
-		ffvec_addstr(&c->file.buf, &s->meta);
+	if (m->ogg_opus) {
+		fflock_lock(&s->meta_lock);
+		ffvec_addstr(&sc->meta, &m->header);
+		fflock_unlock(&s->meta_lock);
+		sc->meta_pending = 1;
+	}
 	return NMLR_OPEN;
 }
 
 static void phi_sv_close(nml_http_sv_conn *c)
 {
 	struct ausv_cl *sc = c->proxy;
-	struct ausv *s = c->conf->opaque;
-	ausv_client_closed(s, c);
-	ffvec_free(&c->file.buf);
+	if (sc->m)
+		ausv_client_closed(sc->lst, c);
+	if (sc->hls_seg)
+		svhls_seg_unref(sc->hls_seg);
+	svbuf_reader_close(&sc->rd);
+	ffvec_free(&sc->meta);
 	ffmem_free(sc);
 }
 
-/**
-Return the max. size of the next audio data chunk */
-static size_t phi_sv_icy_meta(nml_http_sv_conn *c, size_t n)
+/** Set ICY meta data block as output when the client has received the next 'metaint' bytes of audio.
+Return 1 if the output is set */
+static int phi_sv_icy_meta(nml_http_sv_conn *c)
 {
-	const struct ausv *s = c->conf->opaque;
+	const struct ausv_shard *sh = c->conf->opaque;
+	struct ausv *s = sh->s;
 	struct ausv_cl *sc = c->proxy;
-	ffvec *buf = &c->file.buf;
-
-	if (sc->icy_meta_off == ~0U)
-		return n;
-
-	if (sc->icy_meta_off == 0) {
-		sc->icy_meta_off = AUSV_CLIENT_BUF_SIZE_KB * 1024;
-		if (sc->last_meta_uid != s->meta_uid) {
-			// Meta has been changed
-			sc->last_meta_uid = s->meta_uid;
-			ffmem_copy(buf->ptr, s->meta.ptr, s->meta.len);
-			buf->len = s->meta.len;
-		} else {
-			ffmem_copy(buf->ptr, "\0", 1);
-			buf->len = 1;
-		}
-	}
-
-	return ffmin(n, sc->icy_meta_off);
-}
 
-static inline int ring_peek_at(ffring *r, size_t off, size_t n, ffstr *d1, ffstr *d2)
-{
-	n = ffmin(n, r->wtail - off);
-	size_t i = off & r->mask;
-	ffstr_set(d1, r->data + i, n);
-	ffstr_set(d2, r->data, 0);
-	if (i + n > r->cap) {
-		d1->len = r->cap - i;
-		d2->len = i + n - r->cap;
+	if (sc->icy_meta_off != 0)
+		return 0;
+
+	sc->icy_meta_off = AUSV_CLIENT_BUF_SIZE_KB * 1024;
+	if (sc->last_meta_uid != FFINT_READONCE(s->meta_uid)) {
+		// Meta has been changed
+		fflock_lock(&s->meta_lock);
+		sc->last_meta_uid = s->meta_uid;
+		sc->meta.len = 0;
+		ffvec_addstr(&sc->meta, &s->meta);
+		fflock_unlock(&s->meta_lock);
+		c->output = *(ffstr*)&sc->meta;
+	} else {
+		ffstr_set(&c->output, "\0", 1);
 	}
-	return n;
+	return 1;
 }
 
+/** Pass audio data to the socket directly from the shared buffer */
 static int phi_sv_process(nml_http_sv_conn *c)
 {
 	struct ausv_cl *sc = c->proxy;
-	struct ausv *s = c->conf->opaque;
-	ffvec *buf = &c->file.buf;
 
-	size_t n = phi_sv_icy_meta(c, ffvec_unused(buf));
+	if (sc->hls) {
+		if (sc->hls_seg)
+			ffstr_set(&c->output, sc->hls_seg->data, sc->hls_seg->len);
+		else
+			c->output = *(ffstr*)&sc->meta;
+		return NMLR_DONE;
+	}
+
+	if (sc->meta_pending) {
+		sc->meta_pending = 0;
+		c->output = *(ffstr*)&sc->meta;
+		return NMLR_FWD;
+	}
+
+	if (phi_sv_icy_meta(c))
+		return NMLR_FWD;
 
-	ffstr d1, d2;
-	n = ring_peek_at(s->oring, sc->rpos, n, &d1, &d2);
-	if (!n) {
-		ausv_client_paused(s, c);
-		return NMLR_ASYNC;
+	ffstr d;
+	size_t n = (sc->icy_meta_off != ~0U) ? sc->icy_meta_off : ~(size_t)0;
+	if (!svbuf_read(&sc->m->obuf, &sc->rd, n, &d)) {
+		if (!FFINT_READONCE(sc->m->closed)) {
+			ausv_client_paused(sc->lst, c);
+			return NMLR_ASYNC;
+		}
+		// The encoder track is closed: finish after the rest of the data is sent
+		if (!svbuf_read(&sc->m->obuf, &sc->rd, n, &d))
+			return NMLR_DONE;
 	}
-	ffmem_copy(buf->ptr + buf->len, d1.ptr, d1.len);
-	ffmem_copy(buf->ptr + buf->len + d1.len, d2.ptr, d2.len);
-	buf->len += n;
-	sc->rpos += n;
 	if (sc->icy_meta_off != ~0U)
-		sc->icy_meta_off -= n;
+		sc->icy_meta_off -= d.len;
 
-	c->output = *(ffstr*)buf;
-	buf->len = 0;
+	c->output = d;
 	return NMLR_FWD;
 }
 
@@ -412,10 +584,12 @@ static void ausv_icy_meta(struct ausv *s, ffstr artist, ffstr title)
 {
 	char buf[250];
 	ffsz_format(buf, sizeof(buf), "%S - %S", &artist, &title);
+	fflock_lock(&s->meta_lock);
 	s->meta.len = 0;
 	icymeta_add(&s->meta, FFSTR_Z("StreamTitle"), FFSTR_Z(buf));
 	icymeta_fin(&s->meta);
-	s->meta_uid++;
+	FFINT_WRITEONCE(s->meta_uid, s->meta_uid + 1);
+	fflock_unlock(&s->meta_lock);
 }
 
 static void* ausv_provider_open(phi_track *t)
@@ -426,7 +600,7 @@ static void* ausv_provider_open(phi_track *t)
 	core->metaif->find(&t->meta, FFSTR_Z("artist"), &artist, 0);
 	core->metaif->find(&t->meta, FFSTR_Z("title"), &title, 0);
 
-	if (!s->ogg_opus)
+	if (s->icy)
 		ausv_icy_meta(s, artist, title);
 
 	userlog(s->trk, "New track: \"%S - %S\" \"%s\""
@@ -495,24 +669,238 @@ const struct phi_filter ausv_consumer = {
 };
 
 
+/** Wake the main track if it's waiting until the encoder track reads the audio data */
+static void ausv_fanout_wake(struct ausv_mount *m)
+{
+	if (1 == ffint_cmpxchg(&m->s->fanout_paused, 1, 0)) {
+		fflock_lock(&m->lock);
+		if (m->parent)
+			core->track->wake(m->parent);
+		fflock_unlock(&m->lock);
+	}
+}
+
+static void ausv_mount_wake(struct ausv_mount *m)
+{
+	fflock_lock(&m->lock);
+	if (m->trk)
+		core->track->wake(m->trk);
+	fflock_unlock(&m->lock);
+}
+
+static void ausv_mounts_unref(struct ausv *s);
+
+static void* ausv_msrc_open(phi_track *t)
+{
+	t->worker_bound++; // the main track wakes us up
+	return t->udata;
+}
+
+static void ausv_msrc_close(struct ausv_mount *m, phi_track *t)
+{
+	t->worker_bound--;
+	ffmem_free(t->conf.ofile.name);  t->conf.ofile.name = NULL;
+
+	FFINT_WRITEONCE(m->closed, 1);
+	fflock_lock(&m->lock);
+	m->trk = NULL;
+	fflock_unlock(&m->lock);
+	ausv_fanout_wake(m);
+	ausv_client_unpause(m); // the suspended clients finish after receiving the rest of the data
+	ausv_mounts_unref(m->s);
+}
+
+static int ausv_msrc_process(struct ausv_mount *m, phi_track *t)
+{
+	if (t->chain_flags & PHI_FSTOP)
+		return PHI_FIN;
+
+	if (!(t->chain_flags & PHI_FFWD)) {
+		ffring_read_finish(m->iring, m->rh);
+		ausv_fanout_wake(m);
+	}
+
+	ffstr d;
+	m->rh = ffring_read_begin(m->iring, ~0U, &d, NULL);
+	if (!d.len) {
+		ffint_cmpxchg(&m->src_paused, 0, 1);
+		// The main track might have written new data before it could see our flag
+		m->rh = ffring_read_begin(m->iring, ~0U, &d, NULL);
+		if (!d.len)
+			return PHI_ASYNC;
+	}
+
+	t->data_out = d;
+	return PHI_DATA;
+}
+
+/** Receives audio data from the main track */
+static const phi_filter ausv_mount_src = {
+	ausv_msrc_open, (void*)ausv_msrc_close, (void*)ausv_msrc_process,
+	"ausv-mount-src"
+};
+
+static void* ausv_mout_open(phi_track *t)
+{
+	return t->udata;
+}
+
+static int ausv_mout_process(struct ausv_mount *m, phi_track *t)
+{
+	struct ausv *s = m->s;
+
+	if (t->chain_flags & PHI_FSTOP)
+		return PHI_FIN;
+
+	if (m->ogg_opus && m->pkt <= 1) {
+		if (!t->data_in.len)
+			return PHI_MORE;
+		m->pkt++;
+		fflock_lock(&s->meta_lock);
+		ffvec_addstr(&m->header, &t->data_in); // Store OGG Opus header and tags
+		fflock_unlock(&s->meta_lock);
+		return PHI_MORE;
+	}
+
+	if (!t->data_in.len)
+		return PHI_MORE;
+
+	// Determine how many bytes to discard from the buffer on next timer signal
+	uint64 next_pos = FFINT_READONCE(s->next_pos_samples);
+	if (t->audio.pos < next_pos) {
+		FFINT_WRITEONCE(m->half_pos, m->obuf.wpos);
+		dbglog(t, "apos:%U  next:%U  half:%U"
+			, t->audio.pos, next_pos, m->half_pos);
+	}
+
+	uint64 off = m->obuf.wpos;
+	if (!svbuf_write(&m->obuf, t->data_in.ptr, t->data_in.len)) {
+		// There is no free space for this compressed audio frame -> suspend processing until the timer signals
+		ffint_cmpxchg(&m->output_full, 0, 1);
+		// The timer might have released the data before it could see our flag
+		if (!svbuf_write(&m->obuf, t->data_in.ptr, t->data_in.len))
+			return PHI_ASYNC;
+	}
+	svbuf_sync_add(&m->sync, off, t->audio.pos);
+	dbglog(t, "obuffer: %L%%", FFINT_READONCE(m->obuf.size) * 100 / m->obuf.limit);
+	ausv_client_unpause(m);
+
+	if (m->hls_path)
+		svhls_write(&m->hls, t->data_in.ptr, t->data_in.len, t->audio.pos);
+	return PHI_MORE;
+}
+
+/** Passes encoded data to the clients */
+static const phi_filter ausv_mount_out = {
+	ausv_mout_open, NULL, (void*)ausv_mout_process,
+	"ausv-mount-out"
+};
+
+/** Start the encoder track for the mount point */
+static int ausv_mount_start(struct ausv *s, struct ausv_mount *m)
+{
+	struct phi_track_conf tc = {
+		.ofile.name = ffsz_dup((m->ogg_opus) ? "stream.opus" : "stream.aac"),
+		.cross_worker_assign = 1,
+	};
+	if (m->ogg_opus)
+		tc.opus.bitrate = m->kbps;
+	else
+		tc.aac.quality = m->kbps;
+
+	const phi_track_if *track = core->track;
+	phi_track *t = track->create(&tc);
+	t->data_type = PHI_AC_PCM;
+	t->audio.format = s->trk->oaudio.format;
+	t->oaudio.format = s->trk->oaudio.format;
+
+	if (!track->filter(t, &ausv_mount_src, 0)
+		|| !track->filter(t, core->mod("afilter.auto-conv"), 0)
+		|| !track->filter(t, core->mod("format.auto-write"), 0)
+		|| !track->filter(t, &ausv_mount_out, 0)) {
+		ffmem_free(t->conf.ofile.name);  t->conf.ofile.name = NULL;
+		track->close(t);
+		return -1;
+	}
+
+	t->udata = m;
+	m->trk = t;
+	m->parent = s->trk;
+	s->mounts_active++;
+	track->start(t);
+	return 0;
+}
+
+
 static void ausv_close_delayed(struct ausv *s)
 {
 	FF_ASSERT(s->clients == 0);
 	FF_ASSERT(s->subtrack == NULL);
-	nml_http_server_interface.free(s->sv);
-	ffstr_free(&s->resp_headers);
 	ffring_free(s->iring);
-	ffring_free(s->oring);
 	ffvec_free(&s->meta);
-	ffvec_free(&s->clients_paused);
-	phi_track_free(s->trk, s);
-	gs = NULL;
+	for (uint i = 0;  i < s->n_mounts;  i++) {
+		struct ausv_mount *m = &s->mounts[i];
+		ffring_free(m->iring);
+		svbuf_destroy(&m->obuf);
+		svbuf_sync_destroy(&m->sync);
+		ffvec_free(&m->header);
+		ffstr_free(&m->resp_headers);
+		svhls_destroy(&m->hls);
+		ffmem_free(m->hls_path);
+		ffmem_free(m->path);
+	}
+	ffmem_free(s->mounts);
+	if (s->n_shards > 1) {
+		for (uint i = 0;  i < s->n_shards;  i++) {
+			core->worker_release(s->shards[i].worker);
+		}
+	}
+	ffmem_free(s->shards);
+	ffmem_free(s);
+}
+
+/** Free the shard's HTTP server.  Called within the shard's worker. */
+static void ausv_shard_close(void *param)
+{
+	struct ausv_shard *sh = param;
+	struct ausv *s = sh->s;
+	if (sh->sv)
+		nml_http_server_interface.free(sh->sv);
+	for (uint i = 0;  i < s->n_mounts;  i++) {
+		ffvec_free(&sh->lst[i].clients_paused);
+	}
+	ffmem_free(sh->lst);
+
+	if (ffint_fetch_add(&s->shards_active, -1) == 1)
+		core->task(s->worker, &s->task, (void*)ausv_close_delayed, s);
+}
+
+/** Close the shards after the main track and all encoder tracks are closed:
+ no more wake-up tasks will be posted to the shards' workers. */
+static void ausv_mounts_unref(struct ausv *s)
+{
+	if (ffint_fetch_add(&s->mounts_active, -1) != 1)
+		return;
+
+	s->shards_active = s->n_shards;
+	for (uint i = 0;  i < s->n_shards;  i++) {
+		struct ausv_shard *sh = &s->shards[i];
+		core->task(sh->worker, &sh->task_close, ausv_shard_close, sh);
+	}
 }
 
 static void ausv_close(struct ausv *s, phi_track *t)
 {
 	core->timer(t->worker, &s->tmr, 0, NULL, NULL);
-	core->task(t->worker, &s->task, (void*)ausv_close_delayed, s);
+	for (uint i = 0;  i < s->n_mounts;  i++) {
+		struct ausv_mount *m = &s->mounts[i];
+		fflock_lock(&m->lock);
+		m->parent = NULL;
+		if (m->trk)
+			core->track->stop(m->trk);
+		fflock_unlock(&m->lock);
+	}
+	ausv_mounts_unref(s);
 }
 
 static phi_track* ausv_track_start(struct ausv *s)
@@ -572,23 +960,105 @@ static void ausv_timer(void *param)
 {
 	struct ausv *s = param;
 
-	ffstr d1, d2;
-	ffring_head rh = ffring_read_all_begin(s->oring, s->half_pos - s->oring->rtail, &d1, &d2, NULL);
-	ffring_read_finish(s->oring, rh);
-
-	s->next_pos_samples += s->buf_half_samples;
-
-	if (s->output_full) {
-		s->output_full = 0;
-		core->track->wake(s->trk);
+	for (uint i = 0;  i < s->n_mounts;  i++) {
+		struct ausv_mount *m = &s->mounts[i];
+		// Keep the data within the burst window
+		uint64 pos = svbuf_sync_find(&m->sync, s->burst_samples, 0);
+		pos = ffmin(pos, FFINT_READONCE(m->half_pos));
+		svbuf_release(&m->obuf, pos);
+		if (1 == ffint_cmpxchg(&m->output_full, 1, 0))
+			ausv_mount_wake(m);
 	}
 
+	FFINT_WRITEONCE(s->next_pos_samples, s->next_pos_samples + s->buf_half_samples);
+
 	userlog(s->trk, "[%U:%02U:%02U.%03U]  Listeners:%u"
 		, s->total_msec / (60*60*1000)
 		, (s->total_msec / 60000) % 60
 		, (s->total_msec / 1000) % 60
 		, s->total_msec % 1000
-		, s->clients);
+		, FFINT_READONCE(s->clients));
+}
+
+static int ausv_shard_conf(struct ausv *s, struct ausv_shard *sh, const struct phi_asv_conf *ac)
+{
+	sh->sv = nml_http_server_interface.create();
+	struct nml_http_server_conf sc;
+	nml_http_server_interface.conf(NULL, &sc);
+	sc.response.server_name = FFSTR_Z("phiola/2");
+	sc.opaque = sh;
+	sc.server.wif = &nmlwrk_if;
+	sc.server.lsif = &nml_tcp_listener_interface;
+	sc.server.listen_addresses = &s->addr;
+	sc.server.reuse_port = (s->n_shards > 1);
+	if (ac->max_clients)
+		sc.server.max_connections = (ac->max_clients + s->n_shards - 1) / s->n_shards;
+	sc.chain = sv_chain;
+
+	sc.log_level = NML_LOG_VERBOSE;
+	if (core->conf.log_level >= PHI_LOG_EXTRA)
+		sc.log_level = NML_LOG_EXTRA;
+	else if (core->conf.log_level >= PHI_LOG_DEBUG)
+		sc.log_level = NML_LOG_DEBUG;
+	sc.log = nml_log;
+	sc.log_obj = s;
+
+	gshard = sh;
+	return nml_http_server_interface.conf(sh->sv, &sc);
+}
+
+/** Start the shard's HTTP server.  Called within the shard's worker. */
+static void ausv_shard_run(void *param)
+{
+	struct ausv_shard *sh = param;
+	gshard = sh;
+	nml_http_server_interface.run(sh->sv);
+}
+
+static void ausv_mount_hls_init(struct ausv *s, struct ausv_mount *m, uint seg_msec)
+{
+	if (m->ogg_opus) {
+		warnlog(s->trk, "%s: HLS is supported for AAC streams only", m->path);
+		return;
+	}
+
+	// "/dir/NAME.aac" -> "/dir/NAME";  "/" -> "/index"
+	ffstr path = FFSTR_INITZ(m->path), dir, name, ext;
+	ffpath_splitpath_str(path, &dir, &name);
+	ffpath_splitname_str(name, &name, &ext);
+	if (!name.len)
+		ffstr_setz(&name, "index");
+	m->hls_path = ffsz_allocfmt("%S/%S", &dir, &name);
+	ffstr_setz(&m->hls_name, m->hls_path + dir.len + 1);
+
+	svhls_init(&m->hls, seg_msec, s->trk->oaudio.format.rate);
+}
+
+static void ausv_mount_init(struct ausv *s, struct ausv_mount *m, const struct phi_asv_mount *am, uint i)
+{
+	phi_track *t = s->trk;
+	m->s = s;
+	m->index = i;
+	m->path = ffsz_dup(am->path);
+	m->ogg_opus = (am->format == PHI_AC_OPUS);
+	m->kbps = am->bitrate;
+	fflock_init(&m->lock);
+
+	uint n = msec_to_bytes_af(t->conf.oaudio.buf_time, &t->oaudio.format);
+	m->iring = ffring_alloc(n, FFRING_1_READER | FFRING_1_WRITER);
+	n = msec_to_bytes_kbps(t->conf.oaudio.buf_time + s->burst_msec, m->kbps);
+	svbuf_init(&m->obuf, n);
+
+	// a sync point per 100msec
+	uint cap = (t->conf.oaudio.buf_time * 2 + s->burst_msec) / 100 + 16;
+	svbuf_sync_init(&m->sync, cap, t->oaudio.format.rate / 10);
+
+	if (!m->ogg_opus) {
+		s->icy = 1;
+		size_t cap = 0;
+		ffstr_growfmt(&m->resp_headers, &cap, "icy-br:%u\r\nicy-metaint:%u\r\n"
+			, m->kbps, AUSV_CLIENT_BUF_SIZE_KB * 1024);
+	}
 }
 
 static void* ausv_open(phi_track *t)
@@ -596,97 +1066,122 @@ static void* ausv_open(phi_track *t)
 	const struct phi_asv_conf *ac = *(struct phi_asv_conf**)&t->conf.ofile.mtime;
 
 	core->track->filter(t, &ausv_consumer, PHI_TF_PREV);
-	core->track->filter(t, core->mod("format.auto-write"), PHI_TF_PREV);
 
 	t->oaudio.format = t->conf.oaudio.format;
 	t->data_type = PHI_AC_PCM;
 
-	struct ausv *s = phi_track_allocT(t, struct ausv);
-	gs = s;
+	struct ausv *s = ffmem_new(struct ausv);
 	s->qif = core->mod("core.queue");
 	t->udata = s;
-	s->ogg_opus = ffsz_eq(t->conf.ofile.name, "stream.opus");
 	s->trk = t;
 	s->worker = t->worker;
+	fflock_init(&s->meta_lock);
 
-	uint n = msec_to_bytes_af(t->conf.oaudio.buf_time, &t->oaudio.format);
-	s->iring = ffring_alloc(n, FFRING_1_READER | FFRING_1_WRITER);
-	uint kbps = (s->ogg_opus) ? t->conf.opus.bitrate : t->conf.aac.quality;
-	n = msec_to_bytes_kbps(t->conf.oaudio.buf_time, kbps);
-	s->oring = ffring_alloc(n, FFRING_1_READER | FFRING_1_WRITER);
+	s->burst_msec = ac->burst_msec;
+	s->burst_samples = msec_to_samples(ac->burst_msec, t->oaudio.format.rate);
 
-	if (!s->ogg_opus) {
-		size_t cap = 0;
-		ffstr_growfmt(&s->resp_headers, &cap, "icy-br:%u\r\nicy-metaint:%u\r\n"
-			, kbps, AUSV_CLIENT_BUF_SIZE_KB * 1024);
+	s->n_mounts = ac->mounts.len;
+	s->mounts = ffmem_calloc(s->n_mounts, sizeof(struct ausv_mount));
+	for (uint i = 0;  i < s->n_mounts;  i++) {
+		ausv_mount_init(s, &s->mounts[i], &((struct phi_asv_mount*)ac->mounts.ptr)[i], i);
+		if (ac->hls_segment_msec)
+			ausv_mount_hls_init(s, &s->mounts[i], ac->hls_segment_msec);
+	}
+	s->mounts_active = 1; // released on close
+
+	s->n_shards = ffmax(ac->shards, 1);
+	s->shards = ffmem_calloc(s->n_shards, sizeof(struct ausv_shard));
+	for (uint i = 0;  i < s->n_shards;  i++) {
+		struct ausv_shard *sh = &s->shards[i];
+		sh->s = s;
+		sh->worker = (s->n_shards > 1) ? core->worker_assign(1) : s->worker;
+		sh->lst = ffmem_calloc(s->n_mounts, sizeof(struct ausv_listeners));
+		for (uint j = 0;  j < s->n_mounts;  j++) {
+			sh->lst[j].sh = sh;
+		}
 	}
 
+	uint n = msec_to_bytes_af(t->conf.oaudio.buf_time, &t->oaudio.format);
+	s->iring = ffring_alloc(n, FFRING_1_READER | FFRING_1_WRITER);
+
 	s->next_pos_samples = s->buf_half_samples = msec_to_samples(t->conf.oaudio.buf_time / 2, t->oaudio.format.rate);
 	core->timer(s->worker, &s->tmr, t->conf.oaudio.buf_time / 2, ausv_timer, s);
 
-	s->sv = nml_http_server_interface.create();
-	struct nml_http_server_conf sc;
-	nml_http_server_interface.conf(NULL, &sc);
-	sc.response.server_name = FFSTR_Z("phiola/2");
-	sc.opaque = s;
-	sc.server.wif = &nmlwrk_if;
-	sc.server.lsif = &nml_tcp_listener_interface;
 	s->addr.port = ac->port;
-	sc.server.listen_addresses = &s->addr;
-	if (ac->max_clients)
-		sc.server.max_connections = ac->max_clients;
-	sc.chain = sv_chain;
-
-	sc.log_level = NML_LOG_VERBOSE;
-	if (core->conf.log_level >= PHI_LOG_EXTRA)
-		sc.log_level = NML_LOG_EXTRA;
-	else if (core->conf.log_level >= PHI_LOG_DEBUG)
-		sc.log_level = NML_LOG_DEBUG;
-	sc.log = nml_log;
-	sc.log_obj = s;
+	for (uint i = 0;  i < s->n_shards;  i++) {
+		if (ausv_shard_conf(s, &s->shards[i], ac)) {
+			ausv_close(s, t);
+			return PHI_OPEN_ERR;
+		}
+	}
 
-	if (nml_http_server_interface.conf(s->sv, &sc)) {
-		ausv_close(s, t);
-		return PHI_OPEN_ERR;
+	for (uint i = 0;  i < s->n_mounts;  i++) {
+		struct ausv_mount *m = &s->mounts[i];
+		if (ausv_mount_start(s, m)) {
+			ausv_close(s, t);
+			return PHI_OPEN_ERR;
+		}
 	}
 
-	userlog(t, "Started ICY/HTTP server (TCP port %u)", s->addr.port);
+	userlog(t, "Started ICY/HTTP server (TCP port %u, %u shards)", s->addr.port, s->n_shards);
+	for (uint i = 0;  i < s->n_mounts;  i++) {
+		const struct ausv_mount *m = &s->mounts[i];
+		userlog(t, "Mount point: %s (%s, %ukbps)"
+			, m->path, (m->ogg_opus) ? "Opus" : "AAC", m->kbps);
+		if (m->hls_path)
+			userlog(t, "HLS playlist: %s.m3u8", m->hls_path);
+	}
 	s->subtrack = ausv_track_start(s);
-	nml_http_server_interface.run(s->sv);
+	for (uint i = 0;  i < s->n_shards;  i++) {
+		struct ausv_shard *sh = &s->shards[i];
+		core->task(sh->worker, &sh->task_run, ausv_shard_run, sh);
+	}
 	return s;
 }
 
+/** Pass the input audio data to the encoder tracks.
+Return 0 if all the data is written */
+static int ausv_fanout(struct ausv *s)
+{
+	int pending = 0;
+	for (uint i = 0;  i < s->n_mounts;  i++) {
+		struct ausv_mount *m = &s->mounts[i];
+		if (m->fan_off == s->fan.len
+			|| FFINT_READONCE(m->closed))
+			continue;
+
+		ffstr d = s->fan;
+		ffstr_shift(&d, m->fan_off);
+		size_t n = ffring_writestr(m->iring, d);
+		m->fan_off += n;
+		if (m->fan_off < s->fan.len)
+			pending = 1;
+
+		if (n && 1 == ffint_cmpxchg(&m->src_paused, 1, 0))
+			ausv_mount_wake(m);
+	}
+	return pending;
+}
+
 static int ausv_process(struct ausv *s, phi_track *t)
 {
 	if (t->chain_flags & PHI_FSTOP)
 		return PHI_FIN;
 
-	if (s->ogg_opus && s->pkt <= 1) {
-		if (!t->data_in.len)
-			return PHI_MORE;
-		s->pkt++;
-		ffvec_addstr(&s->meta, &t->data_in); // Store OGG Opus header and tags
-		return PHI_MORE;
-	}
-
-	if (!t->data_in.len)
-		return PHI_MORE;
-
-	// Determine how many bytes to discard from the ring buffer on next timer signal
-	if (t->audio.pos < s->next_pos_samples) {
-		s->half_pos = s->oring->wtail;
-		dbglog(s->trk, "apos:%U  next:%U  half:%L"
-			, t->audio.pos, s->next_pos_samples, s->half_pos);
+	if (t->chain_flags & PHI_FFWD) {
+		s->fan = t->data_in;
+		for (uint i = 0;  i < s->n_mounts;  i++) {
+			s->mounts[i].fan_off = 0;
+		}
 	}
 
-	size_t n = ffring_write_all(s->oring, t->data_in.ptr, t->data_in.len);
-	if (n == 0) {
-		// There is no free space for this compressed audio frame -> suspend processing until the timer signals
-		s->output_full = 1;
-		return PHI_ASYNC;
+	if (ausv_fanout(s)) {
+		// An encoder track isn't reading its data fast enough -> suspend processing until it wakes us
+		ffint_cmpxchg(&s->fanout_paused, 0, 1);
+		// The encoder track might have read the data before it could see our flag
+		if (ausv_fanout(s))
+			return PHI_ASYNC;
 	}
-	dbglog(s->trk, "obuffer: %L%%", (s->oring->wtail - s->oring->rtail) * 100 / s->oring->cap);
-	ausv_client_unpause(s);
 	return PHI_MORE;
 }
 
@@ -186,6 +186,11 @@ struct phi_core {
 
 	/** Unassign a task from a worker */
 	void (*worker_release)(uint worker);
+
+	/** Assign a task from an overloaded worker to an idle one.
+	On success, the user calls worker_release() for the old worker after the task is moved.
+	Return new worker ID, or `worker` if there's no idle worker */
+	uint (*worker_move)(uint worker);
 };
 
 /** Create the core object (singleton). */
@@ -287,6 +292,15 @@ enum PHI_UN {
 	PHI_UN_PERCENT,
 };
 
+/** Sample rate converter */
+enum PHI_RESAMPLE {
+	PHI_RESAMPLE_DEFAULT, // polyphase (high quality) for the supported rates, otherwise soxr
+	PHI_RESAMPLE_FAST,
+	PHI_RESAMPLE_MEDIUM,
+	PHI_RESAMPLE_HIGH,
+	PHI_RESAMPLE_SOXR, // always use soxr
+};
+
 /** Track configuration */
 struct phi_track_conf {
 	struct {
@@ -298,11 +312,13 @@ struct phi_track_conf {
 		u_char	format; // enum AVPK_FORMAT
 		uint	preserve_date :1;
 		uint	no_meta :1;
+		uint	mmap :1; // Read local files via memory mapping (UNIX only)
 	} ifile;
 
 	ffslice tracks; // uint[]
 
 	uint	split_msec;
+	uint	split_silence :1; // Split output at silence (afilter.silence)
 	uint64	seek_msec, until_msec;
 	uint	seek_cdframes, until_cdframes;
 
@@ -327,9 +343,11 @@ struct phi_track_conf {
 		uint	rg_normalizer :1;
 		uint	peaks_info :1;
 		uint	loudness_summary :1;
+		u_char	resampler; // enum PHI_RESAMPLE
 		const char *auto_normalizer;
 		const char *danorm;
 		const char *noise_gate;
+		const char *silence; // afilter.silence options
 		char *equalizer;
 	} afilter;
 
@@ -349,6 +367,10 @@ struct phi_track_conf {
 			u_char	quality; // (q+1.0)*10
 		} vorbis;
 
+		struct {
+			u_char	parallel; // encode on several workers
+		} flac;
+
 		struct {
 			ushort	quality; // +1
 		} mp3;
@@ -439,6 +461,14 @@ struct phi_track_if {
 	/** Send a command to the track.
 	cmd: enum PHI_TRACK_CMD */
 	ffssize (*cmd)(phi_track *t, uint cmd, ...);
+
+	/** Get an audio buffer from the worker's pool.
+	The memory is not zeroed.
+	Return NULL on error */
+	void* (*buf_alloc)(phi_track *t, ffsize n);
+
+	/** Return the buffer allocated by buf_alloc() to the pool. */
+	void (*buf_free)(phi_track *t, void *ptr);
 };
 
 
@@ -669,6 +699,10 @@ struct phi_queue_if {
 	/** Rename item's source file.
 	flags: enum PHI_Q_RENAME */
 	int (*rename)(struct phi_queue_entry *qe, char *new_url, uint flags);
+
+	/** Enable persistent metadata cache for read_meta().
+	The cache is loaded from file now and saved to the same file on exit. */
+	int (*meta_cache)(const char *filename);
 };
 
 
@@ -710,6 +744,28 @@ struct phi_tag_if {
 };
 
 
+/** Album loudness: the results of the tracks analyzed by "afilter.loudness", per queue */
+
+typedef struct phi_loudness_album_if phi_loudness_album_if;
+struct phi_loudness_album_if {
+	/** Get integrated loudness (LUFS) and max. sample peak (linear) of all tracks analyzed in the queue
+	 and reset the album data.
+	Return the number of tracks */
+	uint (*get)(phi_queue_id q, double *loudness, double *peak);
+};
+
+
+/** Equalizer: "afilter.eq-live" */
+
+typedef struct phi_equalizer_if phi_equalizer_if;
+struct phi_equalizer_if {
+	/** Apply new settings to the tracks being processed by "afilter.eq".
+	conf: the same format as phi_track_conf.afilter.equalizer
+	  NULL: disable all bands */
+	void (*update)(const char *conf);
+};
+
+
 /** UI configuration */
 
 typedef void (*phi_log_ctl)(uint flags);
@@ -736,7 +792,17 @@ struct phi_ui_if {
 
 /** Audio Streaming Server */
 
+struct phi_asv_mount {
+	const char *path; // e.g. "/hi.aac"
+	uint format; // PHI_AC_AAC | PHI_AC_OPUS
+	uint bitrate; // kbit/s
+};
+
 struct phi_asv_conf {
 	uint max_clients;
+	uint shards; // number of workers serving the clients
 	ushort port;
+	ffslice mounts; // struct phi_asv_mount[]
+	uint hls_segment_msec; // HLS segment duration;  0: HLS is disabled
+	uint burst_msec; // encoded data sent to a new client immediately
 };
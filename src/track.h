@@ -96,6 +96,24 @@ struct phi_filter {
 	int (*process)(void *f, phi_track *t);
 
 	char name[16];
+
+	uint flags; // enum PHI_FILTER_F
+};
+
+/** Output buffer ownership.
+A filter may modify 'data_in' in-place only if PHI_FWRITABLE is set:
+ this is the case when the data was produced by a PHI_FILTER_OWN_OUTPUT filter
+ and then passed through PHI_FILTER_INPLACE filters only.
+Otherwise the filter copies the data to its own buffer
+ and sets PHI_FOWN_OUTPUT for this call (see afilter/pcm-writable.h). */
+enum PHI_FILTER_F {
+	/** 'data_out' is 'data_in' (or a part of it), probably modified in-place:
+	the output is writable if the input is writable */
+	PHI_FILTER_INPLACE = 1,
+
+	/** 'data_out' is filter's own buffer which isn't used by the filter after the next process() call:
+	the next filters may modify it */
+	PHI_FILTER_OWN_OUTPUT = 2,
 };
 
 #define MAX_FILTERS 24
@@ -108,7 +126,7 @@ struct filter {
 
 struct phi_conveyor {
 	struct filter filters_pool[MAX_FILTERS];
-	uint64 busytime_nsec[MAX_FILTERS];
+	struct track_prof *prof; // per-filter statistics (phi_track_conf.print_time)
 	u_char filters_active[MAX_FILTERS];
 	u_char backward_skip[MAX_FILTERS];
 	uint i_fpool, n_active, cur;
@@ -120,6 +138,8 @@ enum PHI_F {
 	PHI_FFWD = 4, // going forward through the chain
 	PHI_FFINISHED = 8, // the chain is finished either by PHI_DONE/PHI_FIN or PHI_ERR
 	PHI_FSTOP_AFTER = 0x20, // don't start next track in queue
+	PHI_FWRITABLE = 0x40, // 'data_in' may be modified in-place (enum PHI_FILTER_F)
+	PHI_FOWN_OUTPUT = 0x80, // set by filter: 'data_out' is filter's own buffer (as PHI_FILTER_OWN_OUTPUT) for this call only
 };
 
 enum PHI_E {
@@ -149,8 +169,12 @@ struct phi_track {
 	// internal:
 	uint state; // enum STATE
 	uint area_size;
+	void *arena; // struct arena_chunk*: filter data that doesn't fit into 'area'
+	uint arena_allocs, heap_allocs;
+	ushort list_idx;
 	ffchain_item sib;
-	phi_task task_wake, task_stop;
+	struct { size_t a[5]; } wake; // ffwakeq_node
+	phi_task task_stop;
 
 	// hot:
 	struct {
@@ -167,6 +191,7 @@ struct phi_track {
 		fftime mtime; // Modification date/time
 		u_char format; // AVPKF_*
 		uint no_auto_seek :1; // Disable automatic seek requests when reading metadata
+		uint allow_async :1; // Allow asynchronous reading
 	} input;
 
 	phi_meta meta;
@@ -175,6 +200,11 @@ struct phi_track {
 	char ifile_ext[4];
 	u_char data_type; // enum PHI_AC
 	uint error; // enum PHI_E
+
+	/** >0: the track can't be moved to another worker.
+	A filter increments it while it holds per-worker resources (kernel events, timers)
+	 or while it expects track->wake() calls from other threads. */
+	uint worker_bound;
 	uint icy_meta_interval; // Upon receiving HTTP response, 'http' filter sets ICY meta interval for 'icy' filter
 	uint meta_changed :1; // Set by 'icy' filter when meta is changed; reset by 'ui' filter
 	uint meta_reading :1;
@@ -189,6 +219,7 @@ struct phi_track {
 		uint	seek_req :1; // New seek request is received (UI -> fmt.read)
 		uint	ogg_reset :1; // ogg.read -> opus.dec
 		uint	mp3_lametag :1; // mpeg.enc -> fmt.w
+		uint	split_gap :1; // afilter.silence -> afilter.split: start a new file with this data
 		uint	bitrate;
 		double	maxpeak_db;
 		const char *decoder;
@@ -229,6 +260,7 @@ struct phi_track {
 			double gain_db;
 			double replay_gain_db;
 			double loudness, loudness_momentary;
+			double loudness_peak; // afilter.loudness: max. sample peak (linear)
 
 			// ui -> audio.play
 			void *adev_ctx;
@@ -280,3 +312,5 @@ struct phi_track {
 #define phi_track_alloc(t, n)  (core)->track->memalloc(t, n)
 #define phi_track_allocT(t, T)  (core)->track->memalloc(t, sizeof(T))
 #define phi_track_free(t, ptr)  (core)->track->memfree(t, ptr)
+#define phi_track_buf_alloc(t, n)  (core)->track->buf_alloc(t, n)
+#define phi_track_buf_free(t, ptr)  (core)->track->buf_free(t, ptr)
@@ -4,6 +4,7 @@
 /*
 fcache_init fcache_destroy
 fcache_reset
+fcache_buf_realloc
 fcache_curbuf fcache_nextbuf
 fcache_find
 fbuf_write
@@ -18,11 +19,13 @@ struct fcache_buf {
 	ffsize len;
 	char *ptr;
 	ffuint64 off;
+	ffsize cap;
 };
 
 struct fcache {
 	struct fcache_buf bufs[4];
 	ffuint n, idx;
+	ffuint align;
 	struct {
 		ffuint64 hits, misses;
 	};
@@ -32,24 +35,39 @@ static inline int fcache_init(struct fcache *c, ffuint nbufs, ffuint bufsize, ff
 {
 	FF_ASSERT(nbufs <= FF_COUNT(c->bufs));
 
-	char *p = ffmem_align(bufsize * nbufs, align);
-	if (!p)
-		return 1;
-
 	c->n = nbufs;
+	c->align = align;
 	for (uint i = 0;  i < c->n;  i++) {
 		struct fcache_buf *b = &c->bufs[i];
 		b->len = 0;
 		b->off = 0;
-		b->ptr = p;
-		p += bufsize;
+		b->cap = bufsize;
+		if (!(b->ptr = ffmem_align(bufsize, align)))
+			return 1;
 	}
 	return 0;
 }
 
 static inline void fcache_destroy(struct fcache *c)
 {
-	ffmem_alignfree(c->bufs[0].ptr);
+	for (uint i = 0;  i < c->n;  i++) {
+		ffmem_alignfree(c->bufs[i].ptr);
+		c->bufs[i].ptr = NULL;
+	}
+}
+
+/** Set new capacity for a buffer; its data is discarded. */
+static inline int fcache_buf_realloc(struct fcache *c, struct fcache_buf *b, ffsize cap)
+{
+	char *p;
+	if (!(p = ffmem_align(cap, c->align)))
+		return 1;
+	ffmem_alignfree(b->ptr);
+	b->ptr = p;
+	b->cap = cap;
+	b->len = 0;
+	b->off = 0;
+	return 0;
 }
 
 static inline void fcache_reset(struct fcache *c)
@@ -0,0 +1,42 @@
+/** Bridge between KQ and lock-free wake queue
+2026, Simon Zolin */
+
+#pragma once
+#include "kq.h"
+#include "wakeq.h"
+
+struct zzkq_wq {
+	ffwakeq wq;
+	ffkq_postevent kqpost;
+	struct zzkevent kev;
+};
+
+static inline void zzkq_wq_detach(struct zzkq_wq *kw, ffkq kq)
+{
+	ffkq_post_detach(kw->kqpost, kq);  kw->kqpost = FFKQ_NULL;
+}
+
+static void zzkq_wq_process(struct zzkq_wq *kw)
+{
+	ffkq_post_consume(kw->kqpost);
+	ffwakeq_run(&kw->wq);
+}
+
+/** Attach WQ processor to KQ */
+static inline int zzkq_wq_attach(struct zzkq_wq *kw, ffkq kq)
+{
+	kw->kev.rhandler = (void*)zzkq_wq_process;
+	kw->kev.obj = kw;
+	kw->kev.rtask.active = 1;
+	if (FFKQ_NULL == (kw->kqpost = ffkq_post_attach(kq, &kw->kev)))
+		return -1;
+	return 0;
+}
+
+/** Add a node to WQ and signal KQ if the reader may be sleeping */
+static inline int zzkq_wq_post(struct zzkq_wq *kw, ffwakeq_node *n, ffwakeq_handler handler)
+{
+	if (1 == ffwakeq_post(&kw->wq, n, handler))
+		return ffkq_post(kw->kqpost, &kw->kev);
+	return 0;
+}
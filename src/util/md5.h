@@ -0,0 +1,118 @@
+/** phiola: MD5 hash (RFC 1321)
+2026, Simon Zolin */
+
+/*
+md5_init
+md5_update
+md5_fin
+*/
+
+#pragma once
+#include <ffbase/base.h>
+
+struct md5 {
+	uint h[4];
+	uint64 len; // bytes
+	u_char buf[64];
+};
+
+static inline void md5_init(struct md5 *m)
+{
+	m->h[0] = 0x67452301;
+	m->h[1] = 0xefcdab89;
+	m->h[2] = 0x98badcfe;
+	m->h[3] = 0x10325476;
+	m->len = 0;
+}
+
+#define _MD5_ROTL(x, n)  (((x) << (n)) | ((x) >> (32 - (n))))
+
+static void _md5_block(uint *h, const u_char *p)
+{
+	static const uint K[64] = {
+		0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
+		0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be, 0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
+		0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+		0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
+		0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c, 0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
+		0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+		0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+		0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1, 0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391,
+	};
+	static const u_char S[16] = {
+		7, 12, 17, 22,  5, 9, 14, 20,  4, 11, 16, 23,  6, 10, 15, 21,
+	};
+
+	uint w[16];
+	for (uint i = 0;  i < 16;  i++) {
+		w[i] = p[i*4] | (p[i*4+1] << 8) | (p[i*4+2] << 16) | ((uint)p[i*4+3] << 24);
+	}
+
+	uint a = h[0], b = h[1], c = h[2], d = h[3], f, g;
+	for (uint i = 0;  i < 64;  i++) {
+		switch (i / 16) {
+		case 0:
+			f = (b & c) | (~b & d);  g = i;  break;
+		case 1:
+			f = (d & b) | (~d & c);  g = (5*i + 1) % 16;  break;
+		case 2:
+			f = b ^ c ^ d;  g = (3*i + 5) % 16;  break;
+		default:
+			f = c ^ (b | ~d);  g = (7*i) % 16;  break;
+		}
+		f += a + K[i] + w[g];
+		a = d;
+		d = c;
+		c = b;
+		b += _MD5_ROTL(f, S[(i / 16) * 4 + i % 4]);
+	}
+
+	h[0] += a;
+	h[1] += b;
+	h[2] += c;
+	h[3] += d;
+}
+
+#undef _MD5_ROTL
+
+static inline void md5_update(struct md5 *m, const void *data, ffsize len)
+{
+	const u_char *p = data;
+	uint n = m->len % 64;
+	m->len += len;
+
+	if (n) {
+		uint k = ffmin(64 - n, len);
+		ffmem_copy(m->buf + n, p, k);
+		p += k;
+		len -= k;
+		if (n + k < 64)
+			return;
+		_md5_block(m->h, m->buf);
+	}
+
+	for (;  len >= 64;  len -= 64) {
+		_md5_block(m->h, p);
+		p += 64;
+	}
+
+	ffmem_copy(m->buf, p, len);
+}
+
+static inline void md5_fin(struct md5 *m, u_char result[16])
+{
+	uint64 bits = m->len * 8;
+	static const u_char pad[64] = { 0x80 };
+	uint n = m->len % 64;
+	md5_update(m, pad, (n < 56) ? 56 - n : 120 - n);
+
+	u_char len[8];
+	for (uint i = 0;  i < 8;  i++) {
+		len[i] = (u_char)(bits >> (i * 8));
+	}
+	md5_update(m, len, 8);
+
+	for (uint i = 0;  i < 16;  i++) {
+		result[i] = (u_char)(m->h[i / 4] >> ((i % 4) * 8));
+	}
+}
@@ -0,0 +1,143 @@
+/** phiola: benchmark: lock-free wake queue vs. locked task queue
+2026, Simon Zolin
+
+Several writer threads wake up their objects, one reader thread handles the wake-ups,
+ as a worker does with the tracks woken from other threads.
+Usage:
+	wakeq-bench [WRITERS] [WAKEUPS]
+Run on a multi-core CPU with WRITERS less than the number of CPUs:
+ the writers don't yield, so on a single CPU the results show only the scheduler's time slices.
+*/
+
+#include <ffsys/thread.h>
+#include <ffsys/time.h>
+#include <ffsys/std.h>
+#include <ffbase/string.h>
+typedef struct phi_track phi_track;
+#include <util/taskqueue.h>
+#include <util/wakeq.h>
+
+#define OBJECTS  16 // per writer
+
+struct obj {
+	ffwakeq_node node;
+	fftask task;
+	uint *handled;
+};
+
+struct bench {
+	uint lockfree;
+	uint writers;
+	uint wakeups; // stop after this number of wake-ups is handled
+	uint handled;
+	uint stop;
+	ffwakeq wq;
+	fftaskqueue tq;
+	struct obj *objs; // [writers * OBJECTS]
+	uint64 posts; // the number of wake-up calls (including the coalesced ones)
+};
+
+static void obj_handler(void *param)
+{
+	struct obj *o = param;
+	(*o->handled)++;
+}
+
+struct writer {
+	struct bench *b;
+	uint index;
+	uint64 posts;
+};
+
+static int FFTHREAD_PROCCALL writer_proc(void *param)
+{
+	struct writer *w = param;
+	struct bench *b = w->b;
+	struct obj *objs = b->objs + w->index * OBJECTS;
+	while (!FFINT_READONCE(b->stop)) {
+		for (uint i = 0;  i < OBJECTS;  i++) {
+			if (b->lockfree)
+				ffwakeq_post(&b->wq, &objs[i].node, obj_handler);
+			else
+				fftaskqueue_post(&b->tq, &objs[i].task);
+		}
+		w->posts += OBJECTS;
+	}
+	return 0;
+}
+
+/** Return the number of nanoseconds */
+static uint64 bench_run(struct bench *b)
+{
+	b->handled = 0;
+	b->stop = 0;
+	b->posts = 0;
+	ffmem_zero_obj(&b->wq);
+	fftaskqueue_init(&b->tq);
+	b->objs = ffmem_calloc(b->writers * OBJECTS, sizeof(struct obj));
+	for (uint i = 0;  i < b->writers * OBJECTS;  i++) {
+		struct obj *o = &b->objs[i];
+		o->handled = &b->handled;
+		ffwakeq_node_init(&o->node, NULL, o);
+		fftask_set(&o->task, obj_handler, o);
+	}
+
+	struct writer *w = ffmem_calloc(b->writers, sizeof(struct writer));
+	ffthread *th = ffmem_calloc(b->writers, sizeof(ffthread));
+
+	fftime t1, t2;
+	fftime_now(&t1);
+
+	for (uint i = 0;  i < b->writers;  i++) {
+		w[i].b = b;
+		w[i].index = i;
+		th[i] = ffthread_create(writer_proc, &w[i], 0);
+	}
+
+	while (b->handled < b->wakeups) {
+		if (b->lockfree)
+			ffwakeq_run(&b->wq);
+		else
+			fftaskqueue_run(&b->tq);
+	}
+
+	fftime_now(&t2);
+	FFINT_WRITEONCE(b->stop, 1);
+	for (uint i = 0;  i < b->writers;  i++) {
+		ffthread_join(th[i], -1, NULL);
+		b->posts += w[i].posts;
+	}
+
+	ffmem_free(th);
+	ffmem_free(w);
+	ffmem_free(b->objs);
+	fftime_sub(&t2, &t1);
+	return (uint64)t2.sec * 1000000000 + t2.nsec;
+}
+
+int main(int argc, char **argv)
+{
+	struct bench b = {
+		.writers = 4,
+		.wakeups = 1000000,
+	};
+	ffstr s;
+	if (argc > 1) {
+		ffstr_setz(&s, argv[1]);
+		ffstr_toint(&s, &b.writers, FFS_INT32);
+	}
+	if (argc > 2) {
+		ffstr_setz(&s, argv[2]);
+		ffstr_toint(&s, &b.wakeups, FFS_INT32);
+	}
+
+	static const char names[][16] = { "task queue", "wake queue" };
+	for (uint i = 0;  i < 2;  i++) {
+		b.lockfree = i;
+		uint64 ns = bench_run(&b);
+		ffstdout_fmt("%s: writers:%u  handled:%u  posted:%U  %Ums  %Uns/wake-up\n"
+			, names[i], b.writers, b.handled, b.posts
+			, ns / 1000000, ns / b.handled);
+	}
+	return 0;
+}
@@ -0,0 +1,126 @@
+/** ff: wake queue: lock-free, multiple writers, one reader.
+2026, Simon Zolin
+*/
+
+/*
+ffwakeq_node_init
+ffwakeq_post
+ffwakeq_node_close
+ffwakeq_run
+*/
+
+/* Writers push nodes to the stack with CAS; the reader takes the whole stack at once.
+A node that is already in the queue isn't added again.
+Node states:
+ IDLE -> QUEUED: ffwakeq_post()
+ QUEUED -> IDLE: ffwakeq_run() before calling the handler
+ IDLE -> CLOSED: ffwakeq_node_close(): the object may be freed now
+ QUEUED -> CLOSED_QUEUED: ffwakeq_node_close(): the reader will call 'on_close()' */
+
+#pragma once
+#include <ffbase/atomic.h>
+
+typedef void (*ffwakeq_handler)(void *param);
+
+enum FFWAKEQ_NODE {
+	FFWAKEQ_IDLE,
+	FFWAKEQ_QUEUED,
+	FFWAKEQ_CLOSED,
+	FFWAKEQ_CLOSED_QUEUED,
+};
+
+typedef struct ffwakeq_node {
+	struct ffwakeq_node *next;
+	uint state; // enum FFWAKEQ_NODE
+	ffwakeq_handler handler, on_close;
+	void *param;
+} ffwakeq_node;
+
+typedef struct ffwakeq {
+	ffatomic head; // ffwakeq_node*
+} ffwakeq;
+
+/**
+on_close: called by reader if the node is closed while in the queue */
+static inline void ffwakeq_node_init(ffwakeq_node *n, ffwakeq_handler on_close, void *param)
+{
+	n->next = NULL;
+	n->state = FFWAKEQ_IDLE;
+	n->on_close = on_close;
+	n->param = param;
+}
+
+/** Add node to the queue.  Thread-safe.
+Return 1 if the queue was empty: the reader must be signalled;
+  0: the node is added;
+  -1: the node is in the queue already or closed. */
+static inline int ffwakeq_post(ffwakeq *q, ffwakeq_node *n, ffwakeq_handler handler)
+{
+	if (FFWAKEQ_IDLE != ffint_cmpxchg(&n->state, FFWAKEQ_IDLE, FFWAKEQ_QUEUED))
+		return -1;
+	n->handler = handler;
+
+	ffsize old;
+	do {
+		old = ffatomic_load(&q->head);
+		n->next = (ffwakeq_node*)old;
+	} while (old != ffatomic_cmpxchg(&q->head, old, (ffsize)n));
+	return (old == 0);
+}
+
+/** Prevent the node from being added to the queue.
+Return 1 if the object may be freed now;
+  0: the node is in the queue: 'on_close()' will be called by the reader. */
+static inline int ffwakeq_node_close(ffwakeq_node *n)
+{
+	for (;;) {
+		uint st = FFINT_READONCE(n->state);
+		switch (st) {
+		case FFWAKEQ_IDLE:
+			if (st == ffint_cmpxchg(&n->state, st, FFWAKEQ_CLOSED))
+				return 1;
+			break;
+
+		case FFWAKEQ_QUEUED:
+			if (st == ffint_cmpxchg(&n->state, st, FFWAKEQ_CLOSED_QUEUED))
+				return 0;
+			break;
+
+		default:
+			return 1; // closed already
+		}
+	}
+}
+
+/** Call a handler for each node in order they were added.  Reader only.
+Return the number of nodes processed. */
+static inline uint ffwakeq_run(ffwakeq *q)
+{
+	uint n = 0;
+	for (;;) {
+		ffwakeq_node *it = (ffwakeq_node*)ffatomic_swap(&q->head, 0);
+		if (it == NULL)
+			break;
+
+		// reverse the stack: the first added node is handled first
+		ffwakeq_node *list = NULL, *next;
+		for (;  it != NULL;  it = next) {
+			next = it->next;
+			it->next = list;
+			list = it;
+		}
+
+		for (it = list;  it != NULL;  it = next) {
+			next = it->next;
+			it->next = NULL;
+			ffwakeq_handler h = it->handler;
+			void *param = it->param;
+			if (FFWAKEQ_QUEUED == ffint_cmpxchg(&it->state, FFWAKEQ_QUEUED, FFWAKEQ_IDLE))
+				h(param);
+			else
+				it->on_close(param); // FFWAKEQ_CLOSED_QUEUED
+			n++;
+		}
+	}
+	return n;
+}
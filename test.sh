@@ -113,6 +113,7 @@ test_info() {
 
 	./phiola i pl.wav -peaks
 	./phiola i pl.wav -loudness
+	./phiola i pl.wav -peaks -mmap
 
 	if ! test -f fm_wv.wv ; then
 		ffmpeg_encode pl.wav
@@ -251,6 +252,10 @@ test_convert_samples() {
 	conv__src_af cosa-float32.wav int16
 	conv__src_af cosa-float32.wav int24
 	conv__src_af cosa-float32.wav int32
+	conv__src_af cosa-float32.wav float64
+
+	# float64/i ->
+	conv__src_af cosa-float64.wav float32
 
 	# int16/ni ->
 	conv__src_af cosa16.flac int16
@@ -281,6 +286,12 @@ test_convert_af() {
 	O=co_wav_i32_96k.wav      ; ./phiola co co.wav -af int32 -rate 96000       -f -o $O ; ./phiola i $O | grep 'int32 96000Hz' ; ./phiola pl $O
 	O=co_wav_i32_96k_mono.wav ; ./phiola co co.wav -af int32 -rate 96000 -ch 1 -f -o $O ; ./phiola i $O | grep 'int32 96000Hz mono' ; ./phiola pl $O
 	# O=co_wav_i24_96k_mono.wav ; ./phiola co co.wav -af int24 -rate 96000 -ch 1 -f -o $O ; ./phiola i $O | grep 'int24 96000Hz mono' ; ./phiola pl $O
+	O=co_wav_44k_fast.wav     ; ./phiola co co.wav -rate 44100 -resample fast  -f -o $O ; ./phiola i $O | grep '44100Hz' ; ./phiola pl $O
+	O=co_wav_44k_soxr.wav     ; ./phiola co co.wav -rate 44100 -resample soxr  -f -o $O ; ./phiola i $O | grep '44100Hz' ; ./phiola pl $O
+
+	# performance: polyphase resampler vs. libsoxr (compare "busy_usec")
+	./phiola co co.wav -rate 44100 -resample high -f -o co_rsmp.wav -perf 2>&1 | grep -o '{"name":"resample"[^}]*}'
+	./phiola co co.wav -rate 44100 -resample soxr -f -o co_rsmp.wav -perf 2>&1 | grep -o '{"name":"soxr-convert"[^}]*}'
 }
 
 test_convert() {
@@ -301,7 +312,12 @@ test_convert() {
 	test_convert_af
 
 	./phiola co co.wav -f -o co_wav_gain6.wav -gain -6 ; ./phiola pl co_wav_gain6.wav
+	# in-place filter after the read-only file mapping
+	./phiola co co.wav -mmap -f -o co_wav_mmap_gain6.wav -gain -6 ; cmp co_wav_gain6.wav co_wav_mmap_gain6.wav
 	./phiola co co.wav -f -o co_wav.wav -preserve_date
+
+	# profiler: per-filter statistics in JSON
+	./phiola co co.wav -f -o co_perf.wav -perf 2>&1 | grep '"p99_usec"'
 }
 
 convert__from_to() {
@@ -318,6 +334,13 @@ test_convert_encode() {
 	./phiola i co_wav.flac -peaks      | grep '96,000 total'
 	./phiola i -u 1 co_wav.flac -peaks | grep '48,000 total'
 	# ./phiola i -s 1 co_wav.flac -peaks | grep '48,000 total'
+	# parallel encoding: the input must be longer than 1 chunk (64 frames * 4096 samples)
+	if ! test -f co_long.wav ; then
+		./phiola rec -rate 48000 -f -o co_long.wav -u 12
+	fi
+	./phiola co co_long.wav -f -o co_long.flac
+	./phiola co co_long.wav -flac_parallel -workers 2 -f -o co_long_par.flac
+	cmp co_long.flac co_long_par.flac
 
 	convert__from_to wav m4a
 	./phiola i co_wav.m4a              | grep -E '98,... samples'
@@ -514,6 +537,9 @@ test_copy() {
 	O=copy_mp4.m4a        ; ./phiola co -copy -f -s 1 -u 2 fm_aac.mp4    -o $O ; ./phiola pl $O
 	O=copy_mp3.mp3        ; ./phiola co -copy -f -s 1 -u 2 fm_mp3.mp3    -o $O ; ./phiola pl $O
 	O=copy_mp3_mkv.mp3    ; ./phiola co -copy -f -s 1 -u 2 fm_mp3.mkv    -o $O ; ./phiola pl $O
+
+	## Memory-mapped input
+	O=copy_mmap.mp3        ; ./phiola co -copy -mmap -f fm_mp3.mp3 -o $O ; ./phiola pl $O
 }
 
 test_danorm() {
@@ -552,8 +578,20 @@ test_equalizer() {
 	fi
 	./phiola pl -equ " f 1000 w 1.0q" pl.wav || true # missing parameter
 	./phiola pl -equ " f 1000 unknown 1.0q g -6.0" pl.wav || true # unknown parameter
-	./phiola -D pl -equ " w 1.0q g -6.0 f 1000 , w 1.0q f 10000 g -6.0 " pl.wav | grep 'adding filter'
-	./phiola -D pl -equ "t bass g 6, f 1000 w 1.0q g 3, t treble g -6" pl.wav | grep 'adding filter'
+	./phiola -D pl -equ " w 1.0q g -6.0 f 1000 , w 1.0q f 10000 g -6.0 " pl.wav | grep 'band #2'
+	./phiola -D pl -equ "t bass g 6, f 1000 w 1.0q g 3, t treble g -6" pl.wav | grep 'band #3'
+	./phiola -D pl -equ "f 1000 w 2o g 3, t bass w 0.8s g -3" pl.wav | grep 'band #2'
+}
+
+test_silence() {
+	if ! test -f pl.wav ; then
+		./phiola rec -rate 48000 -o pl.wav -f -u 2
+	fi
+	./phiola co -silence "unknown 1" pl.wav -f -o sil.wav || true # unknown parameter
+	./phiola co -silence "threshold 30 duration 100 report" pl.wav -f -o sil_report.wav
+	./phiola co -silence "threshold 30 trim" pl.wav -f -o sil_trim.wav ; ./phiola i sil_trim.wav
+	./phiola co -silence "threshold 30 duration 100 trim" -split silence pl.wav -f -o sil_split_@counter.wav
+	./phiola rec -silence "trim" -split silence -u 2 -f -o sil_rec_@counter.wav
 }
 
 test_dir_read() {
@@ -790,6 +828,34 @@ test_server() {
 	sleep .1
 	./phiola pl http://127.0.0.1:21014/ -u 3
 	kill -9 $!
+	sleep .1
+
+	./phiola server sv.flac -mount /hi.aac=192 -mount /lo.opus=48 -burst 1 &
+	sleep .1
+	./phiola pl http://127.0.0.1:21014/hi.aac -u 3
+	./phiola pl http://127.0.0.1:21014/lo.opus -u 3
+	./phiola pl http://127.0.0.1:21014/ -u 1 || true # 404
+	kill -9 $!
+	sleep .1
+
+	./phiola server sv.flac -aac_q 64 -mount / -mount /lo.opus=48 &
+	sleep .1
+	./phiola pl http://127.0.0.1:21014/ -u 3
+	kill -9 $!
+	sleep .1
+	./phiola server sv.flac -mount /a.aac -mount /a.aac 2>&1 | grep 'duplicate path'
+
+	./phiola server sv.flac -shards 2 &
+	sleep .1
+	./phiola pl http://127.0.0.1:21014/ -u 3
+	./phiola pl http://127.0.0.1:21014/ -u 3
+	kill -9 $!
+	sleep .1
+
+	./phiola server sv.flac -aac_q 64 -hls 1 &
+	sleep 2.5
+	./phiola pl http://127.0.0.1:21014/index.m3u8 -u 3
+	kill -9 $!
 }
 
 test_http() {
@@ -917,6 +983,12 @@ test_tag() {
 	./phiola i tag.ogg | grep " - Cool Song"
 	./phiola i tag.opus | grep " - Cool Song"
 	./phiola i tag.flac | grep " - Cool Song"
+
+	# ReplayGain: track & album
+	./phiola tag -replay-gain tag.mp3 tag.ogg tag.flac
+	./phiola i -tag tag.mp3 | grep -iE "replaygain_album_gain"
+	./phiola i -tag tag.ogg | grep -iE "replaygain_track_peak"
+	./phiola i -tag tag.flac | grep -iE "replaygain_album_peak"
 }
 
 test_rename() {
@@ -968,6 +1040,7 @@ TESTS=(
 	# http
 	tee
 	equalizer
+	silence
 	clean
 	# rec_play_alsa
 	# wasapi_exclusive